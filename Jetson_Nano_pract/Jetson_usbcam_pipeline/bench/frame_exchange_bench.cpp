@@ -0,0 +1,206 @@
+/* FrameSharedState latest-wins exchange: atomic shared_ptr (LatestOnly) against the triple buffer, no camera needed
+	- one thread, publish + next_frame back to back: the cost of the exchange itself
+	- producer thread publishing flat out while the consumer polls next_frame() in a loop, like Consumer::run does:
+	  publishes and polls per second, how many distinct frames the consumer got to see
+	- producer at a fixed rate while the consumer polls: publish -> seen latency percentiles
+	- consumer wakeup, producer at a camera-like rate: Consumer's old sleep-polling (1ms) against
+	  wait_next_frame() sleeping on the futex. Latency percentiles and consumer wakeups per frame
+	Frames come from a FramePool of 1x1 images, so no allocation or image copy is measured, only the exchange.
+*/
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "../include/frame_shared_state.h"
+#include "../include/frame_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+static volatile int sink = 0;
+
+void report(const std::string& label, double value, const std::string& unit)
+{
+	std::cout << std::left << std::setw(52) << label << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(12) << value << " " << unit << std::endl;
+}
+
+std::shared_ptr<Frame> makeFrame(FramePool& pool, int seq)
+{
+	int slot = pool.try_acquire();
+	if (slot < 0)
+		return std::make_shared<Frame>(cv::Mat(1, 1, CV_8UC3), Clock::now(), seq);
+	return pool.make_frame(slot, Clock::now(), seq);
+}
+
+void benchSingleThread(ExchangeMode mode, const std::string& name)
+{
+	FrameSharedState state(mode);
+	std::shared_ptr<FramePool> pool = FramePool::create(state.capacity() + 2, 1, 1, CV_8UC3);
+	int ops = 2000000;
+	int seen = 0;
+
+	auto start = Clock::now();
+	for (int i = 0; i < ops; i++)
+	{
+		state.publish(makeFrame(*pool, i));
+		seen += state.next_frame()->get_seq() == i;
+	}
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+	sink = seen;
+	report(name + ": publish + next_frame, one thread", ns, "ns");
+}
+
+void benchFlatOut(ExchangeMode mode, const std::string& name)
+{
+	FrameSharedState state(mode);
+	std::shared_ptr<FramePool> pool = FramePool::create(state.capacity() + 2, 1, 1, CV_8UC3);
+	std::atomic<bool> running{true};
+	double seconds = 1.0;
+	long publishes = 0;
+
+	std::thread producer([&]() {
+		int seq = 0;
+		while (running.load(std::memory_order_relaxed))
+			state.publish(makeFrame(*pool, seq++));
+		publishes = seq;
+	});
+
+	long polls = 0;
+	long distinct = 0;
+	int last_seq = -1;
+	auto start = Clock::now();
+	while (Clock::now() - start < std::chrono::duration<double>(seconds))
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			const std::shared_ptr<Frame>& frame = state.next_frame();
+			polls++;
+			if (frame && frame->get_seq() != last_seq)
+			{
+				last_seq = frame->get_seq();
+				distinct++;
+			}
+		}
+	}
+	running.store(false);
+	producer.join();
+
+	report(name + ": publishes/s", publishes / seconds, "");
+	report(name + ": consumer polls/s", polls / seconds, "");
+	report(name + ": distinct frames seen/s", distinct / seconds, "");
+}
+
+void benchLatency(ExchangeMode mode, const std::string& name)
+{
+	FrameSharedState state(mode);
+	std::shared_ptr<FramePool> pool = FramePool::create(state.capacity() + 2, 1, 1, CV_8UC3);
+	std::atomic<bool> running{true};
+	int frames = 2000;
+	auto period = std::chrono::microseconds(500);
+
+	std::thread producer([&]() {
+		auto next = Clock::now();
+		for (int seq = 0; seq < frames; seq++)
+		{
+			next += period;
+			std::this_thread::sleep_until(next);
+			state.publish(makeFrame(*pool, seq));
+		}
+		running.store(false, std::memory_order_release);
+	});
+
+	// busy polling, the latency is the exchange plus scheduling, not a sleep interval
+	std::vector<double> latencies_us;
+	latencies_us.reserve(frames);
+	int last_seq = -1;
+	while (running.load(std::memory_order_acquire))
+	{
+		const std::shared_ptr<Frame>& frame = state.next_frame();
+		if (frame && frame->get_seq() != last_seq)
+		{
+			latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - frame->get_timestamp()).count());
+			last_seq = frame->get_seq();
+		}
+	}
+	producer.join();
+
+	std::sort(latencies_us.begin(), latencies_us.end());
+	auto pct = [&](double p) { return latencies_us.empty() ? 0.0 : latencies_us[static_cast<size_t>(p * (latencies_us.size() - 1))]; };
+	report(name + ": frames seen of " + std::to_string(frames), latencies_us.size(), "");
+	report(name + ": publish->seen p50", pct(0.50), "us");
+	report(name + ": publish->seen p99", pct(0.99), "us");
+	report(name + ": publish->seen max", pct(1.0), "us");
+}
+
+void benchWakeup(bool notify, const std::string& name)
+{
+	FrameSharedState state(ExchangeMode::TripleBuffer);
+	std::shared_ptr<FramePool> pool = FramePool::create(state.capacity() + 2, 1, 1, CV_8UC3);
+	std::atomic<bool> running{true};
+	int frames = 300;
+	auto period = std::chrono::microseconds(10000);
+
+	std::thread producer([&]() {
+		auto next = Clock::now();
+		for (int seq = 0; seq < frames; seq++)
+		{
+			next += period;
+			std::this_thread::sleep_until(next);
+			state.publish(makeFrame(*pool, seq));
+		}
+		running.store(false, std::memory_order_release);
+		state.close();
+	});
+
+	std::vector<double> latencies_us;
+	latencies_us.reserve(frames);
+	long wakeups = 0;
+	int last_seq = -1;
+	while (running.load(std::memory_order_acquire))
+	{
+		const std::shared_ptr<Frame>& frame = notify
+			? state.wait_next_frame(std::chrono::milliseconds(100))
+			: state.next_frame();
+		wakeups++;
+		if (frame && frame->get_seq() != last_seq)
+		{
+			latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - frame->get_timestamp()).count());
+			last_seq = frame->get_seq();
+		}
+		else if (!notify)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(frame ? 1 : 5));
+		}
+	}
+	producer.join();
+
+	std::sort(latencies_us.begin(), latencies_us.end());
+	auto pct = [&](double p) { return latencies_us.empty() ? 0.0 : latencies_us[static_cast<size_t>(p * (latencies_us.size() - 1))]; };
+	report(name + ": publish->seen p50", pct(0.50), "us");
+	report(name + ": publish->seen p99", pct(0.99), "us");
+	report(name + ": publish->seen max", pct(1.0), "us");
+	report(name + ": consumer wakeups per frame", static_cast<double>(wakeups) / std::max<size_t>(1, latencies_us.size()), "");
+}
+
+int main()
+{
+	std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+	std::vector<std::pair<ExchangeMode, std::string>> modes = {
+		{ExchangeMode::LatestOnly, "atomic shared_ptr"},
+		{ExchangeMode::TripleBuffer, "triple buffer"},
+	};
+	for (auto& mode : modes)
+		benchSingleThread(mode.first, mode.second);
+	for (auto& mode : modes)
+		benchFlatOut(mode.first, mode.second);
+	for (auto& mode : modes)
+		benchLatency(mode.first, mode.second);
+	benchWakeup(false, "sleep-poll 1ms/5ms");
+	benchWakeup(true, "wait_next_frame (futex)");
+	return 0;
+}
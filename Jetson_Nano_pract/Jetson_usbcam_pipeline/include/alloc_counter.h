@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Heap allocations per thread, to check that the capture loop really is allocation free in steady state.
+*
+* Off by default, thread_allocs() is then always 0. Configure with -DCOUNT_ALLOCS=ON and the malloc family is
+* interposed: defined in the executable, these win over the libc ones for every library, so cv::Mat buffers
+* (cv::fastMalloc -> posix_memalign) and operator new (-> malloc) are both counted. glibc only, and not together with
+* ASan/TSan, they replace malloc themselves.
+*
+* The definitions are not inline, keep this header in exactly one translation unit (main.cpp, via producer.h).
+*/
+
+namespace alloc_counter {
+
+// constant initialized, so touching it from inside malloc never allocates
+inline uint64_t& thread_count()
+{
+	static thread_local uint64_t count = 0;
+	return count;
+}
+
+inline uint64_t thread_allocs()
+{
+	return thread_count();
+}
+
+}
+
+#ifdef COUNT_ALLOCS
+
+#include <cerrno>
+#include <cstdlib>
+
+extern "C" {
+
+// glibc's own implementations, everything below forwards to them. free() is left alone
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept
+{
+	alloc_counter::thread_count()++;
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+	alloc_counter::thread_count()++;
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+	alloc_counter::thread_count()++;
+	return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept
+{
+	alloc_counter::thread_count()++;
+	void* ptr = __libc_memalign(alignment, size);
+	if (!ptr)
+		return ENOMEM;
+	*out = ptr;
+	return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+	alloc_counter::thread_count()++;
+	return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+	alloc_counter::thread_count()++;
+	return __libc_memalign(alignment, size);
+}
+
+}
+
+#endif
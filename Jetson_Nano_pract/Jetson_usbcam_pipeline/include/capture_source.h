@@ -40,6 +40,9 @@ public:
 
 	}
 	
+	int width() const { return capture_width_; }
+	int height() const { return capture_height_; }
+	
 	void close()
 	{
 		if (cam_capture_.isOpened())
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+* Publish counter the consumer can sleep on: futex on the counter itself, which is what C++20 atomic::wait/notify
+* do on Linux (the project is C++17).
+*
+* notify(): one atomic add, plus a FUTEX_WAKE syscall only while somebody is waiting.
+* wait(seen): the kernel puts the thread to sleep only if the counter still equals seen, so a notify() between
+* the caller's check and the wait is never lost.
+* waiters_ and count_ are both seq_cst: either the notifier sees the waiter or the waiter sees the new count.
+*/
+
+class FrameNotifier {
+
+private:
+	std::atomic<uint32_t> count_{0};
+	std::atomic<uint32_t> waiters_{0};
+
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+
+	uint32_t* word()
+	{
+		return reinterpret_cast<uint32_t*>(&count_);
+	}
+
+public:
+	uint32_t count() const
+	{
+		return count_.load(std::memory_order_seq_cst);
+	}
+
+	void notify()
+	{
+		count_.fetch_add(1, std::memory_order_seq_cst);
+		if (waiters_.load(std::memory_order_seq_cst))
+			syscall(SYS_futex, word(), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+	}
+
+	// Block until count() != seen or the timeout is over. false on timeout
+	bool wait(uint32_t seen, std::chrono::microseconds timeout)
+	{
+		auto deadline = std::chrono::steady_clock::now() + timeout;
+		waiters_.fetch_add(1, std::memory_order_seq_cst);
+		while (count_.load(std::memory_order_seq_cst) == seen)
+		{
+			auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+			if (remaining.count() <= 0)
+				break;
+
+			timespec ts;
+			ts.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+			ts.tv_nsec = static_cast<long>(remaining.count() % 1000000000);
+			// returns on a wake, a count already != seen, the timeout or a signal, the loop sorts them out
+			syscall(SYS_futex, word(), FUTEX_WAIT_PRIVATE, seen, &ts, nullptr, 0);
+		}
+		waiters_.fetch_sub(1, std::memory_order_seq_cst);
+		return count_.load(std::memory_order_acquire) != seen;
+	}
+};
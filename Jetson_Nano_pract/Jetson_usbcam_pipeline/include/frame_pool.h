@@ -0,0 +1,147 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "frame.h"
+
+/**
+* Fixed pool of preallocated frame buffers, so steady state capture does no heap allocation
+*
+* Why: make_shared<Frame>(img,...) with a reused img leaves the Frame and img sharing one buffer (refcounted header),
+* so the next read either writes into the frame the consumer is looking at or makes OpenCV allocate a fresh one.
+* Here every slot owns a cv::Mat of the capture size plus the raw storage for one Frame and its shared_ptr control block.
+*
+* Flow (producer thread):
+*	int slot = pool->try_acquire();			// -1 when every slot is still in use
+*	capture.read(pool->buffer(slot));		// OpenCV writes into the preallocated buffer, no realloc
+*	auto frame = pool->make_frame(slot, now, seq);	// shared_ptr<Frame> living inside the slot
+*	...or pool->release(slot) if the read failed
+*
+* Recycle on release: make_frame uses allocate_shared with a slot allocator, frame and control block sit in the slot.
+* The slot goes back to the pool from the allocator's deallocate, which runs when the last shared_ptr is gone and the
+* control block is already destroyed. (A custom deleter would be too early: it runs before the control block is freed,
+* and the producer could already be building the next control block in the same storage.)
+*
+* The free list is a bitmask: one thread acquires (producer), any thread can release (whoever drops the last reference).
+*/
+
+class FramePool : public std::enable_shared_from_this<FramePool> {
+
+public:
+	static constexpr int MAX_SLOTS = 64;
+
+private:
+	// enough for libstdc++'s in-place control block holding a Frame (cv::Mat header + timestamp + seq)
+	static constexpr std::size_t SLOT_BYTES = 256;
+
+	struct alignas(alignof(std::max_align_t)) SlotStorage {
+		unsigned char bytes[SLOT_BYTES];
+	};
+
+	std::vector<cv::Mat> buffers_;
+	std::unique_ptr<SlotStorage[]> storage_;
+	std::atomic<uint64_t> free_mask_;
+	int num_slots_;
+
+	template <typename T>
+	struct SlotAllocator {
+		using value_type = T;
+
+		// keeps the pool alive as long as any frame from it is
+		std::shared_ptr<FramePool> pool;
+		int slot;
+
+		SlotAllocator(std::shared_ptr<FramePool> p, int s) : pool(std::move(p)), slot(s) {}
+
+		template <typename U>
+		SlotAllocator(const SlotAllocator<U>& other) : pool(other.pool), slot(other.slot) {}
+
+		T* allocate(std::size_t n)
+		{
+			static_assert(sizeof(T) <= SLOT_BYTES, "frame control block does not fit in a pool slot");
+			static_assert(alignof(T) <= alignof(SlotStorage), "frame control block over-aligned for a pool slot");
+			assert(n == 1);
+			(void)n;
+			return reinterpret_cast<T*>(pool->storage_[slot].bytes);
+		}
+
+		void deallocate(T*, std::size_t)
+		{
+			pool->release(slot);
+		}
+
+		template <typename U>
+		bool operator==(const SlotAllocator<U>& other) const { return pool == other.pool && slot == other.slot; }
+
+		template <typename U>
+		bool operator!=(const SlotAllocator<U>& other) const { return !(*this == other); }
+	};
+
+public:
+	// use create(), frames need shared_from_this
+	FramePool(int num_slots, int width, int height, int type)
+	: storage_(new SlotStorage[num_slots]), num_slots_(num_slots)
+	{
+		assert(num_slots > 0 && num_slots <= MAX_SLOTS);
+		buffers_.reserve(num_slots);
+		for (int i = 0; i < num_slots; i++)
+			buffers_.emplace_back(height, width, type);
+
+		uint64_t all = (num_slots == 64) ? ~uint64_t{0} : ((uint64_t{1} << num_slots) - 1);
+		free_mask_.store(all, std::memory_order_relaxed);
+	}
+
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	static std::shared_ptr<FramePool> create(int num_slots, int width, int height, int type)
+	{
+		return std::make_shared<FramePool>(num_slots, width, height, type);
+	}
+
+	// Free slot index or -1 if all are taken. Only one thread may acquire
+	int try_acquire()
+	{
+		uint64_t mask = free_mask_.load(std::memory_order_acquire);
+		while (mask)
+		{
+			int slot = __builtin_ctzll(mask);
+			// acquire: pairs with release(), the previous frame in this slot is fully gone
+			if (free_mask_.compare_exchange_weak(mask, mask & ~(uint64_t{1} << slot),
+					std::memory_order_acquire, std::memory_order_acquire))
+				return slot;
+		}
+		return -1;
+	}
+
+	// Give back a slot that was acquired but never turned into a frame (failed read)
+	void release(int slot)
+	{
+		free_mask_.fetch_or(uint64_t{1} << slot, std::memory_order_release);
+	}
+
+	// Capture target of an acquired slot. Not shared with any frame until make_frame
+	cv::Mat& buffer(int slot)
+	{
+		return buffers_[slot];
+	}
+
+	// Wrap the filled buffer of an acquired slot into a frame, the slot is recycled once the last copy is dropped
+	std::shared_ptr<Frame> make_frame(int slot, TimeStamp ts, int seq)
+	{
+		return std::allocate_shared<Frame>(SlotAllocator<Frame>(shared_from_this(), slot),
+						buffers_[slot], ts, seq);
+	}
+
+	int size() const { return num_slots_; }
+
+	int free_slots() const
+	{
+		return __builtin_popcountll(free_mask_.load(std::memory_order_relaxed));
+	}
+};
@@ -2,8 +2,15 @@
 
 #include <atomic>
 #include <memory>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include "frame.h"
+#include "triple_buffer.h"
+#include "frame_notifier.h"
 #include "pipeline/stats_mode.h"
+#include "../../../cpp_practice_mini_projects/simple_lock_free_queue/lock_free_queue.h"
 
 /**
 *Notes:
@@ -12,14 +19,134 @@
 *
 */
 
+/**
+* How frames get from the producer to the consumer
+* LatestOnly: a single slot, publish overwrites it. The consumer always sees the newest frame and misses the ones
+*	published in between (dropped_frames column), lowest latency.
+*	std::atomic_store/load on a shared_ptr go through a global spinlock pool in libstdc++, plus a refcount
+*	round trip for every poll.
+* TripleBuffer: same latest-wins behaviour on a TripleBuffer<shared_ptr<Frame>>. One atomic exchange per publish
+*	and per new frame, no lock, and the consumer reads the frame in place without touching the refcount.
+* Queue: bounded spsc queue of `depth` frames, the consumer gets every frame in capture order as long as it keeps up
+*	on average. When it falls `depth` frames behind the OverflowPolicy decides what goes.
+*
+* Every mode counts hand-overs on a FrameNotifier, wait_next_frame() sleeps on it until there is something new
+* instead of the consumer polling with sleeps.
+*/
+enum class ExchangeMode { LatestOnly, TripleBuffer, Queue };
+
+enum class OverflowPolicy {
+	DropOldest,	// evict the oldest queued frame, the queue stays as fresh as it can
+	DropNewest,	// discard the frame being published, the queued ones stay
+	BlockProducer	// producer waits for room, the camera driver drops frames instead
+};
+
 class FrameSharedState {
 
 private:
-	// actual shared data between producer and consumer
+	ExchangeMode mode_;
+	OverflowPolicy overflow_policy_;
+
+	// LatestOnly: actual shared data between producer and consumer
 	std::shared_ptr<Frame> frame_{};
-public:
-	void publish(std::shared_ptr<Frame> frame)
+	// consumer only: what next_frame() handed out last
+	std::shared_ptr<Frame> current_{};
+
+	// TripleBuffer
+	TripleBuffer<std::shared_ptr<Frame>> triple_;
+
+	// Queue
+	std::unique_ptr<lockFree_spsc_Queue<std::shared_ptr<Frame>>> queue_;
+	// consumer only: handed out again while the queue is empty, same seq so the consumer's repeated frame check applies
+	std::shared_ptr<Frame> last_popped_{};
+	// DropOldest: the producer pops too, so the consumer end of the spsc queue is shared and needs a lock.
+	// Only ever contended when the queue is full
+	std::atomic_flag consumer_end_lock_ = ATOMIC_FLAG_INIT;
+	std::atomic<bool> closed_{false};
+	std::atomic<uint64_t> overflow_drops_{0};
+
+	FrameNotifier notifier_;
+	// consumer only, latest-wins modes: publish count when the consumer last took a frame
+	uint32_t taken_ = 0;
+
+	bool has_new_frame() const
+	{
+		if (mode_ == ExchangeMode::Queue)
+			return queue_->size() > 0;
+		return notifier_.count() != taken_;
+	}
+
+	void lock_consumer_end()
+	{
+		while (consumer_end_lock_.test_and_set(std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+
+	void unlock_consumer_end()
+	{
+		consumer_end_lock_.clear(std::memory_order_release);
+	}
+
+	bool pop(std::shared_ptr<Frame>& out)
+	{
+		if (overflow_policy_ != OverflowPolicy::DropOldest)
+			return queue_->pop(out);
+
+		lock_consumer_end();
+		bool popped = queue_->pop(out);
+		unlock_consumer_end();
+		return popped;
+	}
+
+	bool enqueue(std::shared_ptr<Frame> frame)
+	{
+		// push(T&&) leaves frame alone when the queue is full
+		while (!queue_->push(std::move(frame)))
+		{
+			switch (overflow_policy_)
+			{
+			case OverflowPolicy::DropNewest:
+				overflow_drops_.fetch_add(1, std::memory_order_relaxed);
+				nvtx3::mark("QueueDropNewest");
+				return false;
+
+			case OverflowPolicy::DropOldest:
+			{
+				// released after the lock, may hand a pool slot back
+				std::shared_ptr<Frame> oldest;
+				if (pop(oldest))
+				{
+					overflow_drops_.fetch_add(1, std::memory_order_relaxed);
+					nvtx3::mark("QueueDropOldest");
+				}
+				break;
+			}
+
+			case OverflowPolicy::BlockProducer:
+				if (closed_.load(std::memory_order_acquire))
+					return false;
+				std::this_thread::sleep_for(std::chrono::microseconds(500));
+				break;
+			}
+		}
+		nvtx3::mark("publishQueuedFrame");
+		return true;
+	}
+
+	bool hand_over(std::shared_ptr<Frame> frame)
 	{
+		if (mode_ == ExchangeMode::Queue)
+			return enqueue(std::move(frame));
+
+		if (mode_ == ExchangeMode::TripleBuffer)
+		{
+			// drops the frame the slot held before, the consumer let go of it already
+			triple_.write_buffer() = std::move(frame);
+			triple_.publish();
+			nvtx3::mark("publishLatestFrame");
+			return true;
+		}
+
 		// Publishes the latest frame ready for consumption
 		/*
 		The frame shareptr is passed by value instead of reference, as then publish will have its own copy of the sharedptr, which will increment its refcount, which shows ownership transfer. Whereas if we pass sharedptr reference, publish will hold reference to original sharedptr but not have its own copy, and refount is not actually increased in this case. This blurrs the ownership boundary as the producer still holding the orignal reference has the power to modify frame data being consumed by consumer.
@@ -27,14 +154,91 @@ public:
 		std::atomic_store_explicit(&frame_,
 					std::move(frame),
 					 std::memory_order_release);
-					 
+
 		nvtx3::mark("publishLatestFrame");
+		return true;
+	}
+
+public:
+	FrameSharedState(ExchangeMode mode = ExchangeMode::LatestOnly, size_t depth = 4,
+			OverflowPolicy overflow_policy = OverflowPolicy::DropOldest)
+	: mode_(mode), overflow_policy_(overflow_policy)
+	{
+		if (mode_ == ExchangeMode::Queue)
+			queue_ = std::make_unique<lockFree_spsc_Queue<std::shared_ptr<Frame>>>(depth);
 	}
 
+	FrameSharedState(const FrameSharedState&) = delete;
+	FrameSharedState& operator=(const FrameSharedState&) = delete;
+
+	// Producer side. false if the frame was not handed over (DropNewest on a full queue, or closed while blocked)
+	bool publish(std::shared_ptr<Frame> frame)
+	{
+		bool handed_over = hand_over(std::move(frame));
+		if (handed_over)
+			notifier_.notify();
+		return handed_over;
+	}
+
+	// LatestOnly mode only
 	std::shared_ptr<Frame> get_latest_frame()
 	{
 		// returns the pointer to the latest available frame
 		return std::atomic_load_explicit(&frame_,std::memory_order_acquire);
-	
+
+	}
+
+	// Consumer side, for every mode. Latest-wins modes: the newest frame. Queue: the next one in capture order,
+	// or the previous one again while nothing new is queued. null until the first publish.
+	// The reference stays valid until the consumer's next call, copy it to keep the frame longer
+	const std::shared_ptr<Frame>& next_frame()
+	{
+		if (mode_ == ExchangeMode::Queue)
+		{
+			std::shared_ptr<Frame> frame;
+			if (pop(frame))
+				last_popped_ = std::move(frame);
+			return last_popped_;
+		}
+
+		// before the frame: a publish in between only makes the next wait return early
+		taken_ = notifier_.count();
+		if (mode_ == ExchangeMode::TripleBuffer)
+		{
+			triple_.update();
+			return triple_.read_buffer();
+		}
+		current_ = get_latest_frame();
+		return current_;
+	}
+
+	// Consumer side: like next_frame(), but sleeps until something new is published, the timeout runs out
+	// or close() is called. After a timeout it returns the same frame as last time (or null)
+	const std::shared_ptr<Frame>& wait_next_frame(std::chrono::microseconds timeout)
+	{
+		uint32_t seen = notifier_.count();
+		if (!has_new_frame() && !closed_.load(std::memory_order_acquire))
+			notifier_.wait(seen, timeout);
+		return next_frame();
+	}
+
+	// Pipeline is stopping: a producer blocked on a full queue gives up, a consumer waiting for a frame wakes up
+	void close()
+	{
+		closed_.store(true, std::memory_order_release);
+		notifier_.notify();
+	}
+
+	// frames the shared state itself can hold on to, the frame pool needs that many on top
+	size_t capacity() const
+	{
+		if (mode_ == ExchangeMode::Queue)
+			return queue_->capacity() + 1;
+		return (mode_ == ExchangeMode::TripleBuffer) ? 3 : 2;
+	}
+
+	uint64_t overflow_drops() const
+	{
+		return overflow_drops_.load(std::memory_order_relaxed);
 	}
 };
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "../frame.h"
+#include "frame_grabber.h"
+#include "image_classifier.h"
+#include "stage_pipeline.h"
+#include "stats_mode.h"
+
+/**
+* Consumer::runInference split into stages, capture -> preprocess -> infer -> overlay -> display, each on its own
+* thread(s) so the frame rate is set by the slowest stage instead of the sum of all of them.
+* infer runs on infer_workers threads with a classifier (dnn::Net) each, frames come out of it re-sequenced.
+* Same PipelineStats as the producer/consumer setup (record_frame at display), per stage stats at the end.
+* FrameJobs are recycled by the pipeline, blob and display_img keep their buffers from one frame to the next.
+*/
+
+// what travels down the pipeline, one per captured frame, reused once displayed
+struct FrameJob {
+	std::shared_ptr<Frame> frame;
+	cv::Mat blob;
+	Prediction pred;
+	cv::Mat display_img;
+};
+
+class ClassificationPipeline {
+
+private:
+	StagePipeline<FrameJob> pipeline_;
+	FrameGrabber grabber_;
+	std::vector<std::unique_ptr<ImageClassifier>> classifiers_;
+	std::atomic<bool>& running_;
+	StatsType& stats_;
+	int device_id_;
+	int screen_refresh_ms_;
+	int retry_count_;
+	bool window_open_;
+
+	bool capture(FrameJob& job)
+	{
+		job.frame = grabber_.grab();
+		if (!job.frame)
+		{
+			if (!(retry_count_--))
+				running_.store(false, std::memory_order_release);
+
+			// sleep for 5ms then loop again
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			return false;
+		}
+		retry_count_ = RETRY_COUNT;
+		return true;
+	}
+
+	bool display(FrameJob& job)
+	{
+		nvtx3::scoped_range s{"ShowFrame", nvtx3::payload{static_cast<uint64_t>(job.frame->get_seq())}};
+		// HighGUI calls all stay on this thread
+		if (!window_open_)
+		{
+			cv::namedWindow("Camera feed");
+			window_open_ = true;
+		}
+
+		/******* Record the frame in stats logs *************/
+		stats_.record_frame(job.frame->get_timestamp(), std::chrono::steady_clock::now(),
+					job.frame->get_seq());
+
+		cv::imshow("Camera feed", job.display_img);
+
+		int key = cv::waitKey(screen_refresh_ms_);
+		if (key == 'q')
+		{
+			std::cout << "Key q is pressed, quitting stream" << std::endl;
+			running_.store(false, std::memory_order_release);
+		}
+		return true;
+	}
+
+public:
+	ClassificationPipeline(std::atomic<bool>& running, StatsType& stats,
+			const std::string& model_path, int infer_workers = 2,
+			int device_id = 0, int screen_refresh_ms = 1)
+	: grabber_(stats), running_(running), stats_(stats), device_id_(device_id),
+	screen_refresh_ms_(screen_refresh_ms), retry_count_(RETRY_COUNT), window_open_(false)
+	{
+		for (int i = 0; i < infer_workers; i++)
+			classifiers_.push_back(std::make_unique<ImageClassifier>(model_path));
+
+		ImageClassifier& first = *classifiers_[0];
+
+		pipeline_.add_stage("capture", [this](FrameJob& job) { return capture(job); });
+
+		pipeline_.add_stage("preprocess", [&first](FrameJob& job) {
+			first.preprocess(job.frame->get_image(), job.blob);
+			return !job.blob.empty();
+		});
+
+		pipeline_.add_stage_per_worker("infer", [this](int worker) {
+			ImageClassifier* classifier = classifiers_[worker].get();
+			return [classifier](FrameJob& job) {
+				job.pred = classifier->classify(job.blob);
+				return true;
+			};
+		}, infer_workers);
+
+		pipeline_.add_stage("overlay", [&first](FrameJob& job) {
+			job.frame->get_image().copyTo(job.display_img);
+			first.drawPrediction(job.display_img, job.pred);
+			return true;
+		});
+
+		pipeline_.add_stage("display", [this](FrameJob& job) { return display(job); });
+
+		// the frame goes back to the pool right away, not when the job is refilled
+		pipeline_.set_recycle([](FrameJob& job) { job.frame.reset(); });
+	}
+
+	// Runs until running is cleared ('q', camera failure or main). false if the camera did not open
+	bool run()
+	{
+		if (!grabber_.open(device_id_, FRAME_POOL_SIZE + static_cast<int>(pipeline_.capacity())))
+		{
+			std::cout << "ClassificationPipeline: Failed to open capture source" << std::endl;
+			running_.store(false, std::memory_order_release);
+			return false;
+		}
+
+		pipeline_.start();
+		while (running_.load(std::memory_order_acquire))
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		pipeline_.stop();
+
+		std::cout << "Total frames rendered: " << grabber_.frames_grabbed() << std::endl;
+		grabber_.close();
+		return true;
+	}
+
+	void print_stage_stats()
+	{
+		pipeline_.print_stage_stats();
+	}
+};
@@ -14,6 +14,17 @@
 
 using Timepoint = std::chrono::steady_clock::time_point;
 
+// PublishNotify wakes up after this long without a frame, to check running_ and count a null frame
+#define FRAME_WAIT_TIMEOUT_MS 100
+
+/**
+* How the consumer waits for the next frame
+* SleepPoll: poll next_frame(), sleep 1ms on a repeated seq and 5ms on null. Up to that much latency on top,
+*	and ~1000 wakeups per second for nothing
+* PublishNotify: sleep in FrameSharedState::wait_next_frame() until the producer publishes
+*/
+enum class WakeupMode { SleepPoll, PublishNotify };
+
 class PrevFrameState {
 
 public:
@@ -31,17 +42,35 @@ private:
 	std::atomic<bool>& running_;
 	int last_seen_seq_;
 	int screen_refresh_ms;
+	WakeupMode wakeup_;
 	PrevFrameState prev_frame_;
 
+	const std::shared_ptr<Frame>& fetch_frame()
+	{
+		if (wakeup_ == WakeupMode::PublishNotify)
+			return shared_state_.wait_next_frame(
+				std::chrono::milliseconds(FRAME_WAIT_TIMEOUT_MS));
+		return shared_state_.next_frame();
+	}
+
+	// nothing new to show: only the polling mode has to sleep, wait_next_frame() did the waiting already
+	void idle(int poll_sleep_ms)
+	{
+		if (wakeup_ == WakeupMode::SleepPoll)
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(poll_sleep_ms));
+	}
+
 public:
 	StatsType& stats_;
 	
 	Consumer(FrameSharedState& shared, 
 		std::atomic<bool>& running, 
 		StatsType& stats,
-		int refresh_time = 20)
+		int refresh_time = 20,
+		WakeupMode wakeup = WakeupMode::PublishNotify)
 	: shared_state_(shared), running_(running),
-	screen_refresh_ms(refresh_time), last_seen_seq_(-1),
+	screen_refresh_ms(refresh_time), wakeup_(wakeup), last_seen_seq_(-1),
 	stats_(stats) {}
 	
 	/* Function to run image processing on camera feed*/
@@ -54,22 +83,19 @@ public:
 		
 		while(running_.load(std::memory_order_acquire))
 		{
-			std::shared_ptr<Frame> snapshot = 
-						shared_state_.get_latest_frame();
+			const std::shared_ptr<Frame>& snapshot = fetch_frame();
 						
 			if(!snapshot)
 			{
 				stats_.record_null_frame();
-				std::this_thread::sleep_for(
-					std::chrono::milliseconds(5));
+				idle(5);
 				
 				continue;
 			}
 			
 			if (last_seen_seq_ == snapshot->get_seq())
 			{
-				std::this_thread::sleep_for(
-					std::chrono::milliseconds(1));
+				idle(1);
 				continue;
 			}
 			
@@ -115,8 +141,7 @@ public:
 		while(running_.load(std::memory_order_acquire))
 		{
 			
-			std::shared_ptr<Frame> snapshot = 
-						shared_state_.get_latest_frame();
+			const std::shared_ptr<Frame>& snapshot = fetch_frame();
 			
 			uint64_t seq = 	(!snapshot)?0:static_cast<uint64_t>(snapshot->get_seq());
 					
@@ -125,16 +150,14 @@ public:
 			if(!snapshot)
 			{
 				stats_.record_null_frame();
-				std::this_thread::sleep_for(
-					std::chrono::milliseconds(5));
+				idle(5);
 				
 				continue;
 			}
 			
 			if (last_seen_seq_ == snapshot->get_seq())
 			{
-				std::this_thread::sleep_for(
-					std::chrono::milliseconds(1));
+				idle(1);
 				continue;
 			}
 			
@@ -147,7 +170,8 @@ public:
 			}
 			
 			/******* Add processing stage ***********************/
-			display_img = snapshot->get_image().clone();
+			// copyTo reuses display_img's buffer once it has the frame size, clone() allocated every frame
+			snapshot->get_image().copyTo(display_img);
 			
 			pred = classifier.infer(snapshot->get_image());
 			classifier.drawPrediction(display_img, pred);
@@ -292,6 +316,7 @@ public:
 	void signal_stop()
 	{
 		running_.store(false, std::memory_order_release);
+		shared_state_.close();
 		stats_.stop_print_stats();
 	}
 };
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "../capture_source.h"
+#include "../frame_pool.h"
+#include "../alloc_counter.h"
+#include "stats_mode.h"
+
+#define RETRY_COUNT 5
+
+// frames that can be alive at once without allocating, on top of what the downstream holds (FrameSharedState::capacity,
+// StagePipeline::capacity): the one being worked on, the one being captured, plus slack for a slow consumer
+#define FRAME_POOL_SIZE 8
+
+/**
+* Camera -> Frame: reads straight into pooled buffers, stamps and numbers the frames.
+* Shared by the Producer (single consumer setup) and the capture stage of the staged pipeline.
+* One thread only.
+*/
+class FrameGrabber {
+
+private:
+	CaptureSource capture_;
+	std::shared_ptr<FramePool> pool_;
+	StatsType& stats_;
+	int seq_;
+
+public:
+	explicit FrameGrabber(StatsType& stats)
+	: stats_(stats), seq_{0} {}
+
+	// pool_size: frames alive at once without allocating, see FRAME_POOL_SIZE
+	bool open(int device_id, int pool_size)
+	{
+		if (!capture_.open(device_id))
+			return false;
+
+		// buffers sized for the opened camera, frames keep the pool alive after the grabber is gone
+		pool_ = FramePool::create(std::min(pool_size, FramePool::MAX_SLOTS),
+				capture_.width(), capture_.height(), CV_8UC3);
+		return true;
+	}
+
+	// Next frame from the camera, null if the read failed
+	std::shared_ptr<Frame> grab()
+	{
+		nvtx3::scoped_range r{"Capture",nvtx3::payload{static_cast<uint64_t>(seq_)}};
+		uint64_t allocs_before = alloc_counter::thread_allocs();
+
+		// every pooled buffer still held downstream, this frame gets a fresh (allocating) one
+		int slot = pool_->try_acquire();
+		cv::Mat unpooled_img;
+		cv::Mat& img = (slot >= 0) ? pool_->buffer(slot) : unpooled_img;
+		if (slot < 0)
+			stats_.record_pool_miss();
+
+		// capture image from source, straight into the buffer
+		if ( !capture_.read(img) )
+		{
+			if (slot >= 0)
+				pool_->release(slot);
+			stats_.record_read_failure();
+			return nullptr;
+		}
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::shared_ptr<Frame> frame = (slot >= 0)
+			? pool_->make_frame(slot,now,seq_)
+			: std::make_shared<Frame>(std::move(unpooled_img),now,seq_);
+
+		seq_++;
+		stats_.record_capture(alloc_counter::thread_allocs() - allocs_before);
+		return frame;
+	}
+
+	int frames_grabbed() const { return seq_; }
+
+	void close()
+	{
+		capture_.close();
+	}
+};
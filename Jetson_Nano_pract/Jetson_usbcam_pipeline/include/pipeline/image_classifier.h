@@ -32,18 +32,6 @@ class ImageClassifier{
 private:
 	cv::dnn::Net net_;
 	std::vector<std::string> labels_;
-	
-	
-	cv::Mat preprocess(const cv::Mat& img) const
-	{
-		nvtx3::scoped_range p{"PreProcess"};
-		cv::Mat blob = cv::dnn::blobFromImage(img,
-						1.0/255.0, 
-						cv::Size(224,224),
-						cv::Scalar(),true,false);
-						
-		return blob;
-	}
 
 public:
 
@@ -65,6 +53,26 @@ public:
 		
 	}
 
+	/* preprocess and classify are separate so a staged pipeline can run them on different threads.
+	   preprocess touches no member, any thread can call it; classify uses net_, one thread per classifier
+	*/
+	cv::Mat preprocess(const cv::Mat& img) const
+	{
+		cv::Mat blob;
+		preprocess(img, blob);
+		return blob;
+	}
+
+	// into blob, its buffer is reused when it already has the right shape (a recycled FrameJob)
+	void preprocess(const cv::Mat& img, cv::Mat& blob) const
+	{
+		nvtx3::scoped_range p{"PreProcess"};
+		cv::dnn::blobFromImage(img, blob,
+					1.0/255.0, 
+					cv::Size(224,224),
+					cv::Scalar(),true,false);
+	}
+
 	Prediction infer(const cv::Mat& img)
 	{
 		if(img.empty())
@@ -72,8 +80,11 @@ public:
 			throw std::runtime_error("infer() received an empty image");
 		}
 		
-		cv::Mat prep_blob = preprocess(img);
-		
+		return classify(preprocess(img));
+	}
+
+	Prediction classify(const cv::Mat& prep_blob)
+	{
 		nvtx3::scoped_range i{"Infer"};
 		// set input and run inference
 		net_.setInput(prep_blob);
@@ -9,10 +9,61 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include <array>
+#include <cstdint>
 #include "../frame.h"
 
 using Timepoint = std::chrono::steady_clock::time_point;
 
+/**
+* Capture->display latency histogram, for percentiles without keeping every sample.
+* Fixed 0.1ms bins up to 1s (the last bin collects everything slower), so recording never allocates
+* and a percentile is reported as the upper edge of its bin.
+*/
+class LatencyHistogram {
+
+private:
+	static constexpr double BIN_MS = 0.1;
+	static constexpr int BIN_COUNT = 10000;
+
+	std::array<uint32_t, BIN_COUNT + 1> bins_{};
+	uint64_t count_ = 0;
+
+public:
+	void record(double latency_ms)
+	{
+		int bin = static_cast<int>(latency_ms / BIN_MS);
+		bins_[std::min(std::max(bin, 0), BIN_COUNT)]++;
+		count_++;
+	}
+
+	// p in (0,1], 0 when nothing was recorded
+	double percentile(double p) const
+	{
+		if (!count_)
+			return 0.0;
+
+		uint64_t rank = static_cast<uint64_t>(p * count_);
+		if (rank < 1)
+			rank = 1;
+
+		uint64_t seen = 0;
+		for (int bin = 0; bin <= BIN_COUNT; bin++)
+		{
+			seen += bins_[bin];
+			if (seen >= rank)
+				return (bin + 1) * BIN_MS;
+		}
+		return (BIN_COUNT + 1) * BIN_MS;
+	}
+
+	void reset()
+	{
+		bins_.fill(0);
+		count_ = 0;
+	}
+};
+
 class FrameStats{
 
 private:
@@ -24,12 +75,17 @@ private:
 	double fps_;
 	double sum_latency_ms_;
 	double max_latency_ms_;
+	LatencyHistogram latency_hist_;
+	unsigned int captured_frames_;
+	uint64_t capture_allocs_;
+	unsigned int pool_misses_;
 	Timepoint start_time_;
 	
 public:
 	FrameStats(): frame_count_(0),dropped_frames_(0),
 			null_frames_(0), read_failures_(0),last_seq_(-1),
 			fps_(0.0), sum_latency_ms_(0.0),max_latency_ms_(0.0),
+			captured_frames_(0), capture_allocs_(0), pool_misses_(0),
 			start_time_(std::chrono::steady_clock::now()) {}
 					 
 	void reset_window(int last_seen_seq=-1)
@@ -42,6 +98,10 @@ public:
 		fps_		=0.0;
 		max_latency_ms_	=0.0;
 		sum_latency_ms_	=0.0;
+		latency_hist_.reset();
+		captured_frames_=0;
+		capture_allocs_	=0;
+		pool_misses_	=0;
 		start_time_	= std::chrono::steady_clock::now();
 	}
 	
@@ -62,6 +122,9 @@ public:
 		// add latency to be used to calculate avg later
 		sum_latency_ms_ += latency_ms;
 		
+		// and to the histogram for p99
+		latency_hist_.record(latency_ms);
+		
 		// update the latest seen frame seq
 		last_seq_ = seq;
 		
@@ -79,6 +142,23 @@ public:
 		read_failures_++;
 	}	
 	
+	// one successful capture and the heap allocations the producer made for it
+	void record_capture(uint64_t allocs)
+	{
+		captured_frames_++;
+		capture_allocs_ += allocs;
+	}
+	
+	void record_pool_miss()
+	{
+		pool_misses_++;
+	}
+	
+	double allocs_per_frame() const
+	{
+		return (captured_frames_)?(static_cast<double>(capture_allocs_)/captured_frames_):0.0;
+	}
+	
 	int get_last_seq()
 	{
 		return last_seq_;
@@ -102,8 +182,11 @@ public:
 			<< " fps:" << fps_ 
 			<< " avg latency:" << (sum_latency_ms_/frame_count_)
 			<< "ms max latency:" << max_latency_ms_
+			<< "ms p99 latency:" << latency_hist_.percentile(0.99)
 			<< "ms dropped frames:" << dropped_frames_
 			<< " null_frames:" << null_frames_
+			<< " allocs/frame:" << allocs_per_frame()
+			<< " pool misses:" << pool_misses_
 			<< std::endl;
 	}
 	
@@ -122,7 +205,10 @@ public:
 		 << max_latency_ms_ << ","
 		 << dropped_frames_ << ","
 		 << null_frames_ << ","
-		 << read_failures_ << "\n";
+		 << read_failures_ << ","
+		 << latency_hist_.percentile(0.99) << ","
+		 << allocs_per_frame() << ","
+		 << pool_misses_ << "\n";
 		 
 		 out.flush();
 	}
@@ -159,7 +245,8 @@ public:
 		if (stats_file_.is_open())
 		{
 			stats_file_ << "window_ms,frames,fps,avg_latency_ms,max_latency_ms,"
-                       "dropped_frames,null_frames,read_failures\n";
+                       "dropped_frames,null_frames,read_failures,"
+                       "p99_latency_ms,allocs_per_frame,pool_misses\n";
                        stats_file_.flush();
                        csv_enabled_  = true;
 		}
@@ -201,6 +288,23 @@ public:
 		mtx_.unlock();
 	}
 	
+	// Producer records every successful capture
+	void record_capture(uint64_t allocs)
+	{
+		mtx_.lock();
+		lifetime_stats_.record_capture(allocs);
+		windowed_stats_.record_capture(allocs);
+		mtx_.unlock();
+	}
+	
+	void record_pool_miss()
+	{
+		mtx_.lock();
+		lifetime_stats_.record_pool_miss();
+		windowed_stats_.record_pool_miss();
+		mtx_.unlock();
+	}
+	
 	void print_lifetime_stats()
 	{
 		mtx_.lock();
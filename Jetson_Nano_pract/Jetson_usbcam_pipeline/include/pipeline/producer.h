@@ -8,30 +8,27 @@
 #include <thread>
 #include <cstdint>
 #include "../frame_shared_state.h"
-#include "../capture_source.h"
+#include "frame_grabber.h"
 #include "stats_mode.h"
 
 using Timepoint = std::chrono::steady_clock::time_point;
 
-#define RETRY_COUNT 5
-
 class Producer {
 
 private:
-	CaptureSource capture_;
+	FrameGrabber grabber_;
 	FrameSharedState& shared_state_;
 	std::atomic<bool>& running_;
 	StatsType& stats_;
-	int seq_;
 	int device_id_;
-	int capture_width_;
-	int capture_height_;
+	int pool_size_;
 
 public:	
 	Producer(FrameSharedState& shared, 
 		std::atomic<bool>& running,StatsType& stats,
-		int device_id =0)
-	: shared_state_(shared), running_(running), seq_{0}, device_id_{device_id}, stats_(stats)
+		int device_id =0, int pool_size = FRAME_POOL_SIZE)
+	: grabber_(stats), shared_state_(shared), running_(running), stats_(stats),
+	device_id_{device_id}, pool_size_{pool_size + static_cast<int>(shared.capacity())}
 	{
 		/* TODO: document why we don't use shared pointer for FrameSharedState and running, but use a reference to these objects from main(). Whereas we use shared_ptr for the actual Frame object inside of this FrameSharedState
 		*/		
@@ -40,11 +37,10 @@ public:
 	void run()
 	{
 		pthread_setname_np(pthread_self(), "Producer");
-		cv::Mat img;
 		int retry_count = RETRY_COUNT;
 		
 		//Failed to open capture device
-		if(!capture_.open(device_id_))
+		if(!grabber_.open(device_id_, pool_size_))
 		{
 			std::cout << "Producer: Failed to open capture source" 
 					<< std::endl;
@@ -55,11 +51,10 @@ public:
 		// now read image in loop
 		while(running_.load(std::memory_order_acquire))
 		{
-			nvtx3::scoped_range r{"Capture",nvtx3::payload{static_cast<uint64_t>(seq_)}};
 			// capture image from source
-			if ( !capture_.read(img) )
+			std::shared_ptr<Frame> current_frame = grabber_.grab();
+			if ( !current_frame )
 			{
-				stats_.record_read_failure();
 				if (!(retry_count--)){
 					signal_stop();
 					break;
@@ -73,23 +68,18 @@ public:
 			}
 			retry_count = RETRY_COUNT;
 			
-			Timepoint now = std::chrono::steady_clock::now();
-			
 			// Capture successful, bind this to shared state
-			std::shared_ptr<Frame> current_frame =
-				std::make_shared<Frame>(img,now,seq_);
-			
-			seq_++;
-			shared_state_.publish(current_frame);
+			shared_state_.publish(std::move(current_frame));
 		}
-		std::cout << "Total frames rendered: " << seq_ << std::endl;
-		capture_.close();		
+		std::cout << "Total frames rendered: " << grabber_.frames_grabbed() << std::endl;
+		grabber_.close();		
 	}
 	
 	void signal_stop()
 	{
 		running_.store(false, std::memory_order_release);
-		std::cout << "Total frames rendered: " << seq_ << std::endl;
+		shared_state_.close();
+		std::cout << "Total frames rendered: " << grabber_.frames_grabbed() << std::endl;
 	}
 	
 };
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include "stage_queue.h"
+#include "pipeline_stats.h"
+
+/**
+* Chain of stages connected by bounded spsc queues, every stage on its own worker thread(s)
+*
+* - add_stage() in order: the first stage is the source, it fills an item per call (false: nothing this time).
+*   Every later stage gets the item in place and returns false to drop it.
+* - Items are recycled: once through the last stage an item goes back to the source over one spsc queue per last
+*   stage worker, so buffers it owns (cv::Mat ...) are reused instead of allocated per item. The source gets a used
+*   item to fill, a default constructed one only while none has come back yet. set_recycle() runs on the item before
+*   it goes back, to let go of what shouldn't be held meanwhile (e.g. a pooled frame).
+* - A stage with workers > 1 processes items in parallel, so they finish out of order; the next stage still sees
+*   them in source order. Items are numbered (ticket) at the source, and between a stage with P workers and the
+*   next with Q workers there is one spsc queue per (producer worker, consumer worker) pair:
+*       ticket t goes from worker t % P to worker t % Q, through queue [t % P][t % Q].
+*   Each worker handles its tickets in increasing order, so every queue is fifo in ticket order and a consumer that
+*   asks for its next ticket from the right queue re-sequences for free, no reorder buffer needed.
+*   Dropped items keep flowing as markers so later stages don't wait for a ticket that never comes.
+* - Backpressure: a worker blocks while its output queue is full. The source never blocks, an item it can't hand
+*   over is dropped (like a camera dropping frames), its ticket is reused.
+* - Per stage stats: service time (avg/p99/max), time starved on the input and blocked on the output,
+*   the stage with work time close to 1/fps and little starving is the bottleneck.
+* - Functions of a stage with several workers run concurrently: share only thread-safe state,
+*   or use add_stage_per_worker() to give every worker its own (e.g. a dnn::Net each).
+*/
+
+class StageStats {
+
+private:
+	std::mutex mtx_;
+	uint64_t items_ = 0;
+	uint64_t dropped_ = 0;
+	uint64_t overflows_ = 0;
+	double busy_ms_ = 0.0;
+	double max_ms_ = 0.0;
+	double starved_ms_ = 0.0;
+	double blocked_ms_ = 0.0;
+	LatencyHistogram service_hist_;
+
+public:
+	// one item through one worker: time in the stage function, waiting for input, waiting for room downstream
+	void record(double service_ms, double starved_ms, double blocked_ms, bool dropped)
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		items_++;
+		dropped_ += dropped;
+		busy_ms_ += service_ms;
+		max_ms_ = std::max(max_ms_, service_ms);
+		starved_ms_ += starved_ms;
+		blocked_ms_ += blocked_ms;
+		service_hist_.record(service_ms);
+	}
+
+	// source only: item produced but the next stage was full
+	void record_overflow()
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		overflows_++;
+	}
+
+	void print(std::ostream& out, const std::string& name, int workers, double elapsed_s)
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		double per_item = items_ ? 1.0 / items_ : 0.0;
+		out << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(4) << workers
+			<< std::setw(10) << items_
+			<< std::setw(10) << items_ / elapsed_s
+			<< std::setw(9) << busy_ms_ * per_item
+			<< std::setw(9) << service_hist_.percentile(0.99)
+			<< std::setw(9) << max_ms_
+			<< std::setw(10) << starved_ms_ * per_item
+			<< std::setw(10) << blocked_ms_ * per_item
+			<< std::setw(8) << dropped_
+			<< std::setw(10) << overflows_ << "\n";
+	}
+};
+
+template <typename T>
+class StagePipeline {
+
+public:
+	using StageFn = std::function<bool(T&)>;
+	// called once per worker with the worker index, returns that worker's function
+	using StageFactory = std::function<StageFn(int)>;
+	// last stage worker, on an item about to go back to the source
+	using RecycleFn = std::function<void(T&)>;
+
+private:
+	struct Packet {
+		uint64_t ticket = 0;
+		bool dropped = false;
+		T item{};
+	};
+
+	using Queue = StageQueue<Packet>;
+
+	struct Stage {
+		std::string name;
+		int workers;
+		size_t queue_depth;
+		std::vector<StageFn> fns;	// one per worker
+		// from the previous stage, [producer worker * workers + consumer worker]. Empty for the source
+		std::vector<std::unique_ptr<Queue>> inputs;
+		StageStats stats;
+	};
+
+	std::vector<std::unique_ptr<Stage>> stages_;
+	// last stage worker -> source, one per last stage worker. Empty with a single stage
+	std::vector<std::unique_ptr<Queue>> returns_;
+	RecycleFn recycle_;
+	std::vector<std::thread> threads_;
+	std::atomic<bool> stopping_{false};
+	bool started_ = false;
+	std::chrono::steady_clock::time_point start_time_;
+
+	static double ms_between(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+	{
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	}
+
+	static Queue& queue(Stage& stage, int producer, int consumer)
+	{
+		return *stage.inputs[producer * stage.workers + consumer];
+	}
+
+	static void name_thread(const std::string& stage, int worker)
+	{
+		// 15 characters max
+		std::string name = (stage + "/" + std::to_string(worker)).substr(0, 15);
+		pthread_setname_np(pthread_self(), name.c_str());
+	}
+
+	void run_source()
+	{
+		Stage& stage = *stages_[0];
+		Stage* next = (stages_.size() > 1) ? stages_[1].get() : nullptr;
+		name_thread(stage.name, 0);
+
+		// packet stays with the source when the fn fails or the next stage is full, is refilled next time
+		Packet packet;
+		bool handed_over = false;
+		uint64_t ticket = 0;
+		while (!stopping_.load(std::memory_order_acquire))
+		{
+			if (handed_over)
+			{
+				packet = Packet{};
+				for (size_t i = 0; i < returns_.size(); i++)
+					if (returns_[(ticket + i) % returns_.size()]->try_pop(packet))
+						break;
+				handed_over = false;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			if (!stage.fns[0](packet.item))
+				continue;
+			auto produced = std::chrono::steady_clock::now();
+
+			packet.ticket = ticket;
+			packet.dropped = false;
+			if (next)
+			{
+				if (!queue(*next, 0, static_cast<int>(ticket % next->workers)).try_push(std::move(packet)))
+				{
+					stage.stats.record_overflow();
+					continue;
+				}
+				handed_over = true;
+			}
+			ticket++;
+			stage.stats.record(ms_between(start, produced), 0.0, 0.0, false);
+		}
+	}
+
+	void run_worker(size_t index, int worker)
+	{
+		Stage& stage = *stages_[index];
+		Stage& prev = *stages_[index - 1];
+		Stage* next = (index + 1 < stages_.size()) ? stages_[index + 1].get() : nullptr;
+		name_thread(stage.name, worker);
+
+		for (uint64_t ticket = worker; ; ticket += stage.workers)
+		{
+			Packet packet;
+			auto wait_start = std::chrono::steady_clock::now();
+			if (!queue(stage, static_cast<int>(ticket % prev.workers), worker).pop(packet, stopping_))
+				return;
+			assert(packet.ticket == ticket);
+
+			auto work_start = std::chrono::steady_clock::now();
+			bool passthrough = packet.dropped;
+			if (!passthrough)
+				packet.dropped = !stage.fns[worker](packet.item);
+			bool dropped_here = !passthrough && packet.dropped;
+			auto work_end = std::chrono::steady_clock::now();
+
+			if (next && !queue(*next, worker, static_cast<int>(ticket % next->workers)).push(std::move(packet), stopping_))
+				return;
+			if (!next)
+			{
+				// back to the source, never waits: with the return queue full the item is just freed
+				if (recycle_)
+					recycle_(packet.item);
+				returns_[worker]->try_push(std::move(packet));
+			}
+
+			if (!passthrough)
+				stage.stats.record(ms_between(work_start, work_end), ms_between(wait_start, work_start),
+						ms_between(work_end, std::chrono::steady_clock::now()), dropped_here);
+		}
+	}
+
+public:
+	StagePipeline() = default;
+	StagePipeline(const StagePipeline&) = delete;
+	StagePipeline& operator=(const StagePipeline&) = delete;
+
+	~StagePipeline()
+	{
+		stop();
+	}
+
+	// queue_depth: items waiting in front of each worker of this stage (ignored for the source)
+	StagePipeline& add_stage_per_worker(const std::string& name, StageFactory make_fn, int workers = 1, size_t queue_depth = 2)
+	{
+		assert(!started_ && workers >= 1);
+		assert((!stages_.empty() || workers == 1) && "the source numbers the items, it has to be a single worker");
+		std::unique_ptr<Stage> stage = std::make_unique<Stage>();
+		stage->name = name;
+		stage->workers = workers;
+		stage->queue_depth = queue_depth;
+		for (int worker = 0; worker < workers; worker++)
+			stage->fns.push_back(make_fn(worker));
+		stages_.push_back(std::move(stage));
+		return *this;
+	}
+
+	// same fn for every worker, has to be thread-safe if workers > 1
+	StagePipeline& add_stage(const std::string& name, StageFn fn, int workers = 1, size_t queue_depth = 2)
+	{
+		return add_stage_per_worker(name, [fn](int) { return fn; }, workers, queue_depth);
+	}
+
+	// fn runs on the last stage worker(s), with several of them it has to be thread-safe
+	StagePipeline& set_recycle(RecycleFn fn)
+	{
+		assert(!started_);
+		recycle_ = std::move(fn);
+		return *this;
+	}
+
+	// items the queues and workers can hold at once, what a pool feeding the source has to cover
+	size_t capacity() const
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < stages_.size(); i++)
+		{
+			total += stages_[i]->workers;
+			if (i > 0)
+				total += stages_[i - 1]->workers * stages_[i]->workers * stages_[i]->queue_depth;
+		}
+		return total;
+	}
+
+	void start()
+	{
+		assert(!started_ && !stages_.empty());
+		for (size_t i = 1; i < stages_.size(); i++)
+		{
+			Stage& stage = *stages_[i];
+			stage.inputs.clear();
+			for (int q = 0; q < stages_[i - 1]->workers * stage.workers; q++)
+				stage.inputs.push_back(std::make_unique<Queue>(stage.queue_depth));
+		}
+		// room for every item in flight, a last stage worker never finds its return queue full
+		returns_.clear();
+		if (stages_.size() > 1)
+			for (int worker = 0; worker < stages_.back()->workers; worker++)
+				returns_.push_back(std::make_unique<Queue>(capacity()));
+
+		started_ = true;
+		stopping_.store(false, std::memory_order_release);
+		start_time_ = std::chrono::steady_clock::now();
+		threads_.emplace_back(&StagePipeline::run_source, this);
+		for (size_t i = 1; i < stages_.size(); i++)
+			for (int worker = 0; worker < stages_[i]->workers; worker++)
+				threads_.emplace_back(&StagePipeline::run_worker, this, i, worker);
+	}
+
+	// Items still in the queues are dropped
+	void stop()
+	{
+		if (!started_)
+			return;
+		stopping_.store(true, std::memory_order_release);
+		for (auto& stage : stages_)
+			for (auto& input : stage->inputs)
+				input->wake();
+		for (auto& thread : threads_)
+			thread.join();
+		threads_.clear();
+		started_ = false;
+	}
+
+	void print_stage_stats(std::ostream& out = std::cout)
+	{
+		double elapsed_s = std::max(1e-9, ms_between(start_time_, std::chrono::steady_clock::now()) / 1000.0);
+		out << std::left << std::setw(12) << "stage" << std::right
+			<< std::setw(4) << "wk" << std::setw(10) << "items" << std::setw(10) << "per_s"
+			<< std::setw(9) << "avg_ms" << std::setw(9) << "p99_ms" << std::setw(9) << "max_ms"
+			<< std::setw(10) << "starved" << std::setw(10) << "blocked"
+			<< std::setw(8) << "dropped" << std::setw(10) << "overflow" << "\n";
+		for (auto& stage : stages_)
+			stage->stats.print(out, stage->name, stage->workers, elapsed_s);
+		out.flush();
+	}
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "../frame_notifier.h"
+#include "../../../../cpp_practice_mini_projects/simple_lock_free_queue/lock_free_queue.h"
+
+/**
+* Bounded spsc queue between two pipeline stage workers, lockFree_spsc_Queue plus blocking on both ends.
+* The consumer sleeps on a push counter while empty, the producer on a pop counter while full (backpressure),
+* both futex based (FrameNotifier), so an idle stage costs no wakeups.
+* Blocking calls give up once `stop` is set and wake() was called.
+*/
+
+template <typename T>
+class StageQueue {
+
+private:
+	// waits are cut into slices, a missed wake() only delays a shutdown
+	static constexpr std::chrono::milliseconds WAIT_SLICE{50};
+
+	lockFree_spsc_Queue<T> queue_;
+	FrameNotifier pushed_;
+	FrameNotifier popped_;
+
+public:
+	explicit StageQueue(size_t depth) : queue_(depth) {}
+
+	StageQueue(const StageQueue&) = delete;
+	StageQueue& operator=(const StageQueue&) = delete;
+
+	// Producer: false if the queue is full, item is left alone then
+	bool try_push(T&& item)
+	{
+		if (!queue_.push(std::move(item)))
+			return false;
+		pushed_.notify();
+		return true;
+	}
+
+	// Producer: waits while full. false if stopped first
+	bool push(T&& item, const std::atomic<bool>& stop)
+	{
+		while (true)
+		{
+			uint32_t seen = popped_.count();
+			if (try_push(std::move(item)))
+				return true;
+			if (stop.load(std::memory_order_acquire))
+				return false;
+			popped_.wait(seen, WAIT_SLICE);
+		}
+	}
+
+	// Consumer: false if the queue is empty, out is left alone then
+	bool try_pop(T& out)
+	{
+		if (!queue_.pop(out))
+			return false;
+		popped_.notify();
+		return true;
+	}
+
+	// Consumer: waits while empty. false if stopped first
+	bool pop(T& out, const std::atomic<bool>& stop)
+	{
+		while (true)
+		{
+			uint32_t seen = pushed_.count();
+			if (try_pop(out))
+				return true;
+			if (stop.load(std::memory_order_acquire))
+				return false;
+			pushed_.wait(seen, WAIT_SLICE);
+		}
+	}
+
+	// Wake both ends so they see the stop flag
+	void wake()
+	{
+		pushed_.notify();
+		popped_.notify();
+	}
+
+	size_t capacity() const
+	{
+		return queue_.capacity();
+	}
+};
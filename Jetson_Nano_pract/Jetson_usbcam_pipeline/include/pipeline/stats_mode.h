@@ -2,6 +2,7 @@
 
 #include <string>
 #include <chrono>
+#include <cstdint>
 #include <nvtx3/nvtx3.hpp>
 
 using Timepoint = std::chrono::steady_clock::time_point;
@@ -23,6 +24,8 @@ public:
 	void record_frame(const Timepoint&, const Timepoint ,const int&) {}
 	void record_null_frame() {}
 	void record_read_failure() {}
+	void record_capture(uint64_t) {}
+	void record_pool_miss() {}
 	
 	void start_print_stats(int period = 1000) {}
 	void stop_print_stats() {}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+* Triple buffer: latest-value exchange between one writer and one reader, no locks, one atomic exchange per side
+*
+* Three slots: back (writer only), front (reader only) and middle (handed over).
+* publish(): the writer swaps its finished back slot into the middle and continues in whatever was there.
+* update(): if the middle holds something the reader has not seen, the reader swaps it with its front slot.
+* Neither side waits, the writer never touches the slot the reader is looking at, and a value the reader
+* did not get to is simply overwritten (latest wins, like the atomic shared_ptr it replaces).
+*
+* Typical use:
+*	writer:	buf.write_buffer() = value; buf.publish();
+*	reader:	if (buf.update()) use(buf.read_buffer());	// valid until the reader's next update()
+*/
+
+template <typename T>
+class TripleBuffer {
+
+private:
+	// middle_ holds the middle slot's index in bits 0-1, FRESH is set while the reader has not taken it yet
+	static constexpr uint8_t INDEX_MASK = 3;
+	static constexpr uint8_t FRESH = 4;
+
+	// writer and reader work on different slots, keep them on different cache lines
+	struct alignas(64) Slot {
+		T value{};
+	};
+
+	Slot slots_[3];
+	alignas(64) std::atomic<uint8_t> middle_{1};
+	alignas(64) uint8_t back_ = 0;	// writer only
+	alignas(64) uint8_t front_ = 2;	// reader only
+
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer: slot to fill before the next publish(). Holds an old value (from two publishes back, or one the reader skipped)
+	T& write_buffer()
+	{
+		return slots_[back_].value;
+	}
+
+	// Writer: make the write buffer the newest value
+	void publish()
+	{
+		// release: the reader sees the filled slot; acquire: the reader is done with the slot we get back
+		uint8_t old = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel);
+		back_ = old & INDEX_MASK;
+	}
+
+	// Reader: take the newest value if there is one, false if read_buffer() is still the newest
+	bool update()
+	{
+		if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+			return false;
+
+		uint8_t old = middle_.exchange(front_, std::memory_order_acq_rel);
+		front_ = old & INDEX_MASK;
+		return true;
+	}
+
+	// Reader: the value taken by the last update(), default constructed before the first one
+	const T& read_buffer() const
+	{
+		return slots_[front_].value;
+	}
+};
@@ -4,6 +4,7 @@
 #include <pthread.h>
 #include "../include/pipeline/producer.h"
 #include "../include/pipeline/consumer.h"
+#include "../include/pipeline/classification_pipeline.h"
 #include "../include/pipeline/stats_mode.h"
 
 using namespace std;
@@ -20,7 +21,10 @@ int main()
 	pthread_setname_np(pthread_self(), "MainThread");
 	
 	
-	FrameSharedState latest_frame;
+	// LatestOnly/TripleBuffer: consumer always gets the newest frame (TripleBuffer without locks or refcounting).
+	// Queue: every frame in order, up to a depth behind, OverflowPolicy says what happens when it falls further behind
+	FrameSharedState latest_frame(ExchangeMode::TripleBuffer);
+	//FrameSharedState latest_frame(ExchangeMode::Queue, 4, OverflowPolicy::DropOldest);
 	std::atomic<bool> running{true};
 	int device_id =0;
 	int screen_refresh_interval_ms = 10;
@@ -29,10 +33,31 @@ int main()
 	StatsType stats = StatsType("recorded_frame_stats.csv");
 	//StatsType stats;
 	
+	std::string model_path = "/home/darshana/practice/Practice_miniProjects_repo/Jetson_Nano_pract/Jetson_usbcam_pipeline/models/image_classification_mobilenetv2_2022apr.onnx";
+	
+	// true: staged pipeline, capture -> preprocess -> infer (infer_workers threads) -> overlay -> display.
+	// false: the producer/consumer pair below, all processing on the consumer thread
+	bool use_stage_pipeline = true;
+	int infer_workers = 2;
+	
+	if (use_stage_pipeline)
+	{
+		ClassificationPipeline app(running,stats,model_path,infer_workers,device_id,screen_refresh_interval_ms);
+		
+		stats.start_print_stats();
+		app.run();
+		stats.stop_print_stats();
+		
+		app.print_stage_stats();
+		cv::destroyAllWindows();
+		return 0;
+	}
+	
 	Producer cam_feed(latest_frame,running,stats,device_id);
-	Consumer display_feed(latest_frame,running,stats,screen_refresh_interval_ms);
+	// PublishNotify: consumer sleeps until a frame is published. SleepPoll: the old 1ms/5ms polling, for comparison
+	Consumer display_feed(latest_frame,running,stats,screen_refresh_interval_ms,WakeupMode::PublishNotify);
 	
-	ImageClassifier classifier("/home/darshana/practice/Practice_miniProjects_repo/Jetson_Nano_pract/Jetson_usbcam_pipeline/models/image_classification_mobilenetv2_2022apr.onnx");
+	ImageClassifier classifier(model_path);
 	
 	stats.start_print_stats();
 	
@@ -66,6 +66,7 @@ private:
             {
                 std::cerr << "Task thown exception" << std::endl;
             }
+            pprof::instance().record(ActorModel::Profile::EventType::PoolTaskEnd,0,0, 1234);
             // Notify that a task has been completed
             completed_tasks++;
         }
@@ -125,6 +126,7 @@ public:
             throw std::runtime_error("Cannot enqueue new tasks as thread pool is stopped");
         taskList.emplace([survivorPtr_pkTask]()
                          { (*survivorPtr_pkTask)(); });
+        pprof::instance().record(ActorModel::Profile::EventType::PoolEnqueue,0,0, 1234);
         mLock.unlock();
         cond_.notify_one();
         return result;
@@ -152,16 +154,23 @@ public:
         // Join all worker threads
     }
 
+    // Wait for the workers to run the remaining tasks and exit, pool must be stopped first
+    void joinWorkers()
+    {
+        for (auto &worker : worker_threads)
+            if (worker.joinable())
+                worker.join();
+    }
+
     ~ThreadPool_Q()
     {
         // Stop the pool and notify all worker threads
-        std::cout << "ThreadPool stopped" << std::endl;
+        ACTOR_LOG_INFO("ThreadPool", "ThreadPool stopped");
 
         if (stop_pool.exchange(false))
             stopPool();
         
-        for (auto &worker : worker_threads)
-            worker.join();
+        joinWorkers();
     }
 };
 
@@ -11,6 +11,7 @@
 #include <chrono>
 #include <condition_variable>
 #include "../simple_mpmc_queue/mpmc_queue_bounded.h"
+#include "actor_model_logger_tracer.h"
 
 template <typename Task> class Actor;
 template <typename Task> class ActorSystem;
@@ -103,7 +104,7 @@ private:
             if (auto actor_system = owning_system_.lock())
                 actor_system->notifyActorFailure(this->shared_from_this());
         
-        std::cout <<name_ <<": Stopped dispatcher thread" <<std::endl;
+        ACTOR_LOG_INFO(name_, "Stopped dispatcher thread");
     }
 
     // Open a msg from mailbox and execute the task
@@ -112,7 +113,7 @@ private:
         Message<Task> msg;
         if(mailbox_q->try_pop(msg))
         {
-            std::cout << name_ << ": "; 
+            ACTOR_LOG_DEBUG(name_, "Handling msg");
             try
             {
                 msg.task(); // Executes task
@@ -123,7 +124,7 @@ private:
             }
             catch(...)
             {
-                std::cout << "Exception caught in receive()" << std::endl;
+                ACTOR_LOG_ERROR(name_, "Exception caught in receive()");
                 actor_alive_.store(false,std::memory_order_release);
                 actor_state_.store(ActorState::FAILED,std::memory_order_release);
 
@@ -140,7 +141,7 @@ private:
         Message<Task> remaining_msg;
         while(mailbox_q->try_pop(remaining_msg))
         {
-            std::cout << name_ << ": "; 
+            ACTOR_LOG_DEBUG(name_, "Handling msg");
             try
             {
                 remaining_msg.task();   // Execute task
@@ -162,8 +163,7 @@ private:
     void handleReply(const Message<Task>& msg, bool is_success=true)
     {
         if (auto sender = msg.sender.lock())
-            send(sender,[this,is_success](){std::cout << "Message handled by Actor "<<this->name_ << ": " 
-                                    << (is_success?"Successfully":"Failed") << std::endl;});
+            send(sender,[this,is_success](){ACTOR_LOG_INFO(this->name_, is_success ? "Message handled successfully" : "Message handling failed");});
     }
 
 public:
@@ -252,7 +252,7 @@ public:
 
     void recoveryMechanism()
     {
-        std::cout << "Actor's recovery mechanism" << std::endl;
+        ACTOR_LOG_INFO(name_, "Actor's recovery mechanism");
     }
 
     // Stop the mailbox checker thread
@@ -260,7 +260,7 @@ public:
     {
         if (actor_alive_.exchange(false,std::memory_order_acq_rel) || isFailedState())
         {
-            std::cout << "Stopping Actor: " << name_ << std::endl;
+            ACTOR_LOG_INFO(name_, "Stopping Actor");
             new_mail_arrived_.release();
             if(dispatcher_.joinable())
                 dispatcher_.join();
@@ -271,7 +271,7 @@ public:
     // Destructor
     ~Actor()
     {
-        std::cout << name_ << ": Destrutor Called" << std::endl;
+        ACTOR_LOG_DEBUG(name_, "Destrutor Called");
         stopActor();
     }
 
@@ -327,10 +327,10 @@ public:
         std::lock_guard<std::mutex> rlock(registry_lock_);
         if((actor_registry_.find(actor->name_) != actor_registry_.end()) && actor_registry_[actor->name_].lock())
         {
-            std::cout << "Name: "<<actor->name_<<" is taken" << std::endl;
+            ACTOR_LOGF_WARN("ActorSystem", "Name: {} is taken", actor->name_);
             return false;
         }
-        std::cout << "Registering Actor: " << actor->name_ << " " << actor.get()<<  std::endl;
+        ACTOR_LOG_INFO(actor->name_, "Registering Actor");
         actor_registry_[actor->name_] = std::weak_ptr<Actor<Task>>(actor);
         return true;
     }
@@ -356,7 +356,8 @@ public:
             if ((idx != -1) && 
                 (idx >= 0 && (size_t)idx< total_actors_ ) ) // if idx is in valid range
             {
-                std::shared_ptr<Actor<Task>> new_actor= std::make_shared<Actor<Task>>(mailbox_capacity,curr_size,name);
+                // id must be the slot idx, cleanup_actors() finds the actor by its id on the next failure
+                std::shared_ptr<Actor<Task>> new_actor= std::make_shared<Actor<Task>>(mailbox_capacity,idx,name);
 
                 if ( registerActor(new_actor) )
                 {
@@ -427,7 +428,7 @@ public:
 
         if ( !receiver->addToMailbox(Message<Task>{std::move(task),{},false}) )
         {
-            std::cout << receiver->name_ <<":Actor is stopped! Mailbox is closed for new mails!" << std::endl;
+            ACTOR_LOG_WARN(receiver->name_, "Actor is stopped! Mailbox is closed for new mails!");
             return false;
         }
         return true;
@@ -479,17 +480,17 @@ public:
     // Just logs the failure if an exception occurs when an actor is executing a task
     void logFailure(std::string actor_name,Message<Task>&& msg)
     {
-        std::cout << "Terminating Actor: "<< actor_name<< " due to execption" << std::endl;
+        ACTOR_LOG_ERROR(actor_name, "Terminating Actor due to execption");
         if(msg.request_reply)
         {
             if (auto sender = msg.sender.lock())
-                send(sender->name_,[actor_name](){std::cout << "Task failed with exception by Actor: "<< actor_name << std::endl;});
+                send(sender->name_,[actor_name](){ACTOR_LOG_WARN(actor_name, "Task failed with exception");});
         }
     }
 
     void recoveryPolicy(std::shared_ptr<Actor<Task>> actor)
     {
-        std::cout <<"Add recovery policy here for Actor: " << actor->name_ << std::endl;
+        ACTOR_LOG_INFO(actor->name_, "Add recovery policy here");
         actor->recoveryMechanism();
     }
 
@@ -499,7 +500,7 @@ public:
         std::lock_guard<std::mutex> rlock(registry_lock_);
         if (actor_pool_[idx])
         {
-            std::cout << "Unregistering actor: " << actor_pool_[idx]->name_ <<  "  " << actor_pool_[idx].get() <<std::endl;
+            ACTOR_LOG_INFO(actor_pool_[idx]->name_, "Unregistering actor");
             actor_registry_.erase(actor_pool_[idx]->name_);
             actor_pool_[idx].reset();
         }
@@ -0,0 +1,567 @@
+/* Throughput/latency benchmarks for both actor model versions
+    - Same source builds against actor_model.h (dispatcher thread per actor, -DBENCH_DISPATCHER_VERSION)
+      or actor_model_threadpool_version.h (default), see "make bench"
+    - Scenarios: ping-pong, fan-out/fan-in, ring token passing, skewed hot actor load, restart storm,
+      spawn/stop churn, plus the per call cost of the async logger and the Profiler
+    - Built with logging compiled out (ACTOR_LOG_LEVEL_OFF), std::cout is muted as well while running
+      in case anything still prints, only the results go to stdout.
+      Profiler tracing is off for the actor scenarios: the thread pool ActorSystem turns it on in its constructor,
+      BenchSystem turns it off again (actor_model.h does not trace). Only the two Profiler benchmarks record
+*/
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+
+#ifdef BENCH_DISPATCHER_VERSION
+#include <unordered_map>
+#include <queue>
+#include "actor_model.h"
+#else
+#include "actor_model_threadpool_version.h"
+#endif
+
+using Job = std::function<void()> ;
+using Clock = std::chrono::steady_clock;
+
+static std::ostream* report = &std::cout;   // real stdout, std::cout itself gets muted in main()
+static std::atomic<size_t> gave_up_sends{0};
+
+// Same tiny interface over both versions, so every scenario is written only once
+class BenchSystem
+{
+#ifdef BENCH_DISPATCHER_VERSION
+private:
+    std::shared_ptr<ActorSystem<Job>> system_;
+    std::vector<std::shared_ptr<Actor<Job>>> actors_;   // cached, a registry lookup per msg would dominate
+    std::vector<std::string> names_;
+
+public:
+    static constexpr const char* version = "dispatcher thread per actor (actor_model.h)";
+
+    explicit BenchSystem(size_t max_actors): system_(std::make_shared<ActorSystem<Job>>(max_actors)) {}
+
+    size_t spawn(size_t mailbox_capacity, const std::string& name)
+    {
+        actors_.push_back(system_->spawn(mailbox_capacity,name));
+        names_.push_back(name);
+        return actors_.size()-1;
+    }
+
+    bool send(size_t id, Job&& job)
+    {
+        const std::shared_ptr<Actor<Job>>& actor = actors_[id];
+        if (!actor)
+            return false;
+        return actor->addToMailbox(Message<Job>{std::move(job),nullptr,false});
+    }
+
+    // Every actor has its own thread here already
+    void dedicate(size_t) {}
+
+    // Failed actors are replaced by a new Actor object under the same name, pick it up.
+    // Only call this while no actor is sending to id
+    void refresh(size_t id)
+    {
+        if (!actors_[id] || !actors_[id]->isAlive())
+            actors_[id] = system_->getActor(names_[id]);
+    }
+#else
+private:
+    std::shared_ptr<ActorSystem<Job>> system_;
+    std::vector<ActorHandle> handles_;
+    std::string admin_ = "";    // Message wants a sender name
+
+public:
+    static constexpr const char* version = "thread pool (actor_model_threadpool_version.h)";
+
+    explicit BenchSystem(size_t max_actors): system_(std::make_shared<ActorSystem<Job>>(max_actors))
+    {
+        // ActorSystem() enables tracing, every msg would cost a few trace events the dispatcher version doesn't pay
+        ActorModel::Profile::Profiler::instance().disableTrace();
+    }
+
+    size_t spawn(size_t mailbox_capacity, const std::string& name)
+    {
+        handles_.push_back(system_->spawn(mailbox_capacity,name));
+        return handles_.size()-1;
+    }
+
+    bool send(size_t id, Job&& job)
+    {
+        return system_->send(handles_[id].idx,Message<Job>{std::move(job),admin_,false});
+    }
+
+    void dedicate(size_t id)
+    {
+        system_->setDispatchPolicy(handles_[id],DispatchPolicy(DispatchMode::DEDICATED));
+    }
+
+    // Restarts happen in place, handles stay valid
+    void refresh(size_t) {}
+#endif
+};
+
+// Retry on full mailbox / restarting actor. Gives up after a while, so that a stuck run still finishes and reports it
+template <typename Func>
+bool sendRetry(BenchSystem& system, size_t id, const Func& func, size_t max_tries = 1 << 20)
+{
+    for (size_t tries=0; tries<max_tries; tries++)
+    {
+        if (system.send(id,Job(func)))
+            return true;
+        std::this_thread::yield();
+    }
+    gave_up_sends.fetch_add(1,std::memory_order_relaxed);
+    return false;
+}
+
+uint64_t elapsedNs(Clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+}
+
+bool waitUntil(const std::function<bool()>& done, std::chrono::seconds timeout = std::chrono::seconds(30))
+{
+    auto deadline = Clock::now() + timeout;
+    while (!done())
+    {
+        if (Clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+void printThroughput(const std::string& scenario, size_t msgs, uint64_t elapsed_ns, bool completed)
+{
+    *report << std::left << std::setw(36) << scenario << std::right << std::fixed << std::setprecision(0)
+            << std::setw(12) << msgs*1e9/elapsed_ns << " msgs/s  (" << msgs << " msgs in "
+            << std::setprecision(1) << elapsed_ns/1e6 << " ms)" << (completed ? "" : "  TIMED OUT") << std::endl;
+}
+
+// latencies in ns, sorted in place
+void printLatency(const std::string& scenario, std::vector<uint64_t>& latencies)
+{
+    if (latencies.empty())
+        return;
+    std::sort(latencies.begin(),latencies.end());
+    auto percentile = [&latencies](double p){
+        return latencies[std::min(latencies.size()-1,static_cast<size_t>(p*latencies.size()))]/1000.0;
+    };
+    *report << std::left << std::setw(36) << (scenario + " latency") << std::right << std::fixed << std::setprecision(1)
+            << "p50 " << percentile(0.50) << "us  p90 " << percentile(0.90) << "us  p99 " << percentile(0.99)
+            << "us  p99.9 " << percentile(0.999) << "us  max " << latencies.back()/1000.0 << "us" << std::endl;
+}
+
+// 1. Two actors bouncing a msg back and forth, one msg in flight: pure per-hop latency
+struct PingPongState
+{
+    BenchSystem* system;
+    size_t ping_id;
+    size_t pong_id;
+    size_t rounds;
+    Clock::time_point sent_at;      // touched only by the ping actor
+    std::vector<uint64_t> round_trips;
+    std::atomic<bool> done{false};
+};
+
+void ping(PingPongState* state, size_t round);
+
+void pong(PingPongState* state, size_t round)
+{
+    sendRetry(*state->system,state->ping_id,[state,round](){
+        state->round_trips.push_back(elapsedNs(state->sent_at));
+        if (round+1 < state->rounds)
+            ping(state,round+1);
+        else
+            state->done.store(true,std::memory_order_release);
+    });
+}
+
+void ping(PingPongState* state, size_t round)
+{
+    state->sent_at = Clock::now();
+    sendRetry(*state->system,state->pong_id,[state,round](){ pong(state,round); });
+}
+
+void benchPingPong(size_t rounds)
+{
+    BenchSystem system(2);
+    PingPongState state;
+    state.system = &system;
+    state.ping_id = system.spawn(16,"ping");
+    state.pong_id = system.spawn(16,"pong");
+    state.rounds = rounds;
+    state.round_trips.reserve(rounds);
+
+    auto start = Clock::now();
+    sendRetry(system,state.ping_id,[&state](){ ping(&state,0); });
+    bool completed = waitUntil([&state](){ return state.done.load(std::memory_order_acquire); });
+    uint64_t elapsed = elapsedNs(start);
+
+    printThroughput("ping-pong",2*state.round_trips.size(),elapsed,completed);
+    printLatency("ping-pong round trip",state.round_trips);
+}
+
+// 2. Producer spreads msgs over workers, every worker forwards its result to one collector
+void benchFanOutFanIn(size_t num_workers, size_t msgs)
+{
+    BenchSystem system(num_workers+1);
+    std::vector<size_t> workers;
+    for (size_t i=0; i<num_workers; i++)
+        workers.push_back(system.spawn(1024,"worker" + std::to_string(i)));
+    size_t collector = system.spawn(1 << 16,"collector");
+
+    std::vector<uint64_t> latencies(msgs);  // slot per msg, written only by the collector
+    std::atomic<size_t> collected{0};
+
+    auto start = Clock::now();
+    for (size_t seq=0; seq<msgs; seq++)
+    {
+        Clock::time_point created = Clock::now();
+        sendRetry(system,workers[seq % num_workers],[&system,&latencies,&collected,collector,seq,created](){
+            sendRetry(system,collector,[&latencies,&collected,seq,created](){
+                latencies[seq] = elapsedNs(created);
+                collected.fetch_add(1,std::memory_order_release);
+            });
+        });
+    }
+    bool completed = waitUntil([&](){ return collected.load(std::memory_order_acquire) == msgs; });
+    uint64_t elapsed = elapsedNs(start);
+
+    latencies.resize(collected.load());
+    printThroughput("fan-out/fan-in x" + std::to_string(num_workers),2*collected.load(),elapsed,completed);
+    printLatency("fan-out/fan-in",latencies);
+}
+
+// 3. Ring of actors passing tokens to their neighbour
+struct RingState
+{
+    BenchSystem* system;
+    std::vector<size_t> members;
+    std::atomic<size_t> hops{0};
+    std::atomic<size_t> finished_tokens{0};
+};
+
+void passToken(RingState* state, size_t position, size_t hops_left)
+{
+    state->hops.fetch_add(1,std::memory_order_relaxed);
+    if (!hops_left)
+    {
+        state->finished_tokens.fetch_add(1,std::memory_order_release);
+        return;
+    }
+    size_t next = (position+1) % state->members.size();
+    if (!sendRetry(*state->system,state->members[next],[state,next,hops_left](){ passToken(state,next,hops_left-1); }))
+        state->finished_tokens.fetch_add(1,std::memory_order_release);   // lost token, don't wait for it forever
+}
+
+void benchRing(size_t ring_size, size_t tokens, size_t hops_per_token)
+{
+    BenchSystem system(ring_size);
+    RingState state;
+    state.system = &system;
+    for (size_t i=0; i<ring_size; i++)
+        state.members.push_back(system.spawn(64,"ring" + std::to_string(i)));
+
+    auto start = Clock::now();
+    for (size_t token=0; token<tokens; token++)
+    {
+        size_t position = (token*ring_size)/tokens;     // spread the tokens around the ring
+        sendRetry(system,state.members[position],[&state,position,hops_per_token](){ passToken(&state,position,hops_per_token); });
+    }
+    bool completed = waitUntil([&](){ return state.finished_tokens.load(std::memory_order_acquire) == tokens; });
+    uint64_t elapsed = elapsedNs(start);
+
+    printThroughput("ring " + std::to_string(ring_size) + " actors, " + std::to_string(tokens) + " tokens",
+                    state.hops.load(),elapsed,completed);
+}
+
+// 4. Most of the traffic goes to one hot actor, the rest is spread evenly
+void benchSkewed(size_t num_actors, size_t msgs, double hot_share, bool dedicated_hot = false)
+{
+    BenchSystem system(num_actors);
+    std::vector<size_t> actors;
+    for (size_t i=0; i<num_actors; i++)
+        actors.push_back(system.spawn(1024,"skewed" + std::to_string(i)));
+    if (dedicated_hot)
+        system.dedicate(actors[0]);
+
+    std::vector<uint64_t> latencies(msgs);
+    std::atomic<size_t> handled{0};
+    std::mt19937 rng(42);   // fixed seed, every run and both versions see the same sequence
+    std::uniform_real_distribution<double> pick_hot(0.0,1.0);
+    std::uniform_int_distribution<size_t> pick_cold(1,num_actors-1);
+
+    auto start = Clock::now();
+    for (size_t seq=0; seq<msgs; seq++)
+    {
+        size_t target = (pick_hot(rng) < hot_share) ? actors[0] : actors[pick_cold(rng)];
+        Clock::time_point created = Clock::now();
+        sendRetry(system,target,[&latencies,&handled,seq,created](){
+            latencies[seq] = elapsedNs(created);
+            handled.fetch_add(1,std::memory_order_release);
+        });
+    }
+    bool completed = waitUntil([&](){ return handled.load(std::memory_order_acquire) == msgs; });
+    uint64_t elapsed = elapsedNs(start);
+
+    latencies.resize(handled.load());
+    std::string scenario = "skewed " + std::to_string(static_cast<int>(hot_share*100)) + "% hot" + (dedicated_hot ? " dedicated" : "");
+    printThroughput(scenario,handled.load(),elapsed,completed);
+    printLatency(scenario,latencies);
+}
+
+// 5. Actors crash over and over, measured from sending the crashing msg till a probe msg runs on the recovered actor
+void benchRestartStorm(size_t num_actors, size_t crashes_per_actor)
+{
+    BenchSystem system(num_actors);
+    std::vector<size_t> actors;
+    for (size_t i=0; i<num_actors; i++)
+        actors.push_back(system.spawn(16,"crashy" + std::to_string(i)));
+
+    std::vector<uint64_t> recoveries;
+    recoveries.reserve(num_actors*crashes_per_actor);
+
+    auto start = Clock::now();
+    for (size_t round=0; round<crashes_per_actor; round++)
+    {
+        for (size_t id: actors)
+        {
+            std::atomic<bool> crashed{false};
+            std::atomic<bool> probed{false};
+            Clock::time_point crashed_at = Clock::now();
+            sendRetry(system,id,[&crashed](){
+                crashed.store(true,std::memory_order_release);
+                throw std::runtime_error("crash");
+            });
+            while (!crashed.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            // dispatcher version drops the mailbox of a failed actor, a probe that sneaks in just before it dies is lost,
+            // so give every probe a short while only, and send another one
+            bool recovered = false;
+            auto deadline = Clock::now() + std::chrono::seconds(5);
+            while (!recovered && (Clock::now() < deadline))
+            {
+                system.refresh(id);
+                if (!system.send(id,[&probed](){ probed.store(true,std::memory_order_release); }))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                auto probe_deadline = Clock::now() + std::chrono::milliseconds(1);
+                while (!(recovered = probed.load(std::memory_order_acquire)) && (Clock::now() < probe_deadline))
+                    std::this_thread::yield();
+            }
+            if (recovered)
+                recoveries.push_back(elapsedNs(crashed_at));
+        }
+    }
+    uint64_t elapsed = elapsedNs(start);
+
+    *report << std::left << std::setw(36) << "restart storm" << std::right << std::fixed << std::setprecision(0)
+            << std::setw(12) << recoveries.size()*1e9/elapsed << " restarts/s  (" << recoveries.size() << " of "
+            << num_actors*crashes_per_actor << " recovered)" << std::endl;
+    printLatency("restart storm",recoveries);
+}
+
+// 6. Cost of one async log call on the calling thread. Called directly, the ACTOR_LOG macros are compiled out here.
+// Bursts smaller than a thread's ring, with pauses for the writer, so we time the logging path and not the drop path
+void benchLogger(size_t num_threads, size_t bursts = 200, size_t burst_size = 512)
+{
+    using namespace ActorModel::Logger;
+    uint64_t dropped_before = AsyncLogger::instance().droppedCount();
+    std::atomic<uint64_t> total_ns{0};
+
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<num_threads; t++)
+    {
+        threads.emplace_back([&total_ns,t,bursts,burst_size](){
+            std::string component = "logger" + std::to_string(t);
+            uint64_t spent = 0;
+            for (size_t burst=0; burst<bursts; burst++)
+            {
+                auto start = Clock::now();
+                for (size_t i=0; i<burst_size; i++)
+                    logf(Level::Info,component,"msg {} of burst {}, took {}us",i,burst,3.5);
+                spent += elapsedNs(start);
+                std::this_thread::sleep_for(std::chrono::milliseconds(3));
+            }
+            total_ns.fetch_add(spent,std::memory_order_relaxed);
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+
+    *report << std::left << std::setw(36) << ("async log call, " + std::to_string(num_threads) + " threads") << std::right
+            << std::fixed << std::setprecision(1) << std::setw(12) << double(total_ns.load())/(num_threads*bursts*burst_size)
+            << " ns/call  (dropped " << AsyncLogger::instance().droppedCount() - dropped_before << ")" << std::endl;
+}
+
+// 7. Cost of one Profiler::record on the calling thread, every thread writes to its own trace buffer.
+// Same burst/pause pattern as the logger, buffers are 8192 events per thread.
+// label/configure: a run with some Profiler filter set, reset to record everything afterwards
+void benchTracer(size_t num_threads, std::string label = "trace event", std::function<void()> configure = nullptr,
+                 size_t bursts = 200, size_t burst_size = 512)
+{
+    using namespace ActorModel::Profile;
+    Profiler::instance().enableTrace();
+    if (configure)
+        configure();
+    TraceStats before = Profiler::instance().traceStats();
+    std::atomic<uint64_t> total_ns{0};
+
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<num_threads; t++)
+    {
+        threads.emplace_back([&total_ns,t,bursts,burst_size](){
+            uint64_t spent = 0;
+            for (size_t burst=0; burst<bursts; burst++)
+            {
+                auto start = Clock::now();
+                for (size_t i=0; i<burst_size; i++)
+                    Profiler::instance().record(EventType::Enqueue,t,burst,static_cast<uint32_t>(i));
+                spent += elapsedNs(start);
+                std::this_thread::sleep_for(std::chrono::milliseconds(3));
+            }
+            total_ns.fetch_add(spent,std::memory_order_relaxed);
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+
+    *report << std::left << std::setw(36) << (label + ", " + std::to_string(num_threads) + " threads") << std::right
+            << std::fixed << std::setprecision(1) << std::setw(12) << double(total_ns.load())/(num_threads*bursts*burst_size)
+            << " ns/event  (dropped " << Profiler::instance().traceStats().ring_dropped - before.ring_dropped
+            << ", capped " << Profiler::instance().traceStats().rate_capped - before.rate_capped << ")" << std::endl;
+
+    Profiler::instance().setEventMask(Profiler::ALL_EVENTS);
+    Profiler::instance().setSampling(1);
+    Profiler::instance().setRateCap(0);
+    Profiler::instance().disableTrace();
+}
+
+// 8. CPU the Profiler's flusher thread spends per million events (merge, serialise, write). Threads record flat out
+// in bursts a bit smaller than their trace buffers, then we wait for the flusher to write everything
+void benchTraceFlusher(size_t num_threads, size_t bursts = 100, size_t burst_size = 4096)
+{
+    using namespace ActorModel::Profile;
+    Profiler::instance().enableTrace();
+    TraceStats before = Profiler::instance().traceStats();
+
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<num_threads; t++)
+    {
+        threads.emplace_back([t,bursts,burst_size](){
+            for (size_t burst=0; burst<bursts; burst++)
+            {
+                for (size_t i=0; i<burst_size; i++)
+                    Profiler::instance().record(EventType::Enqueue,t,burst,static_cast<uint32_t>(i));
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+
+    uint64_t recorded = num_threads*bursts*burst_size;
+    TraceStats after;
+    waitUntil([&](){
+        after = Profiler::instance().traceStats();
+        return (after.written - before.written + after.ring_dropped - before.ring_dropped) >= recorded;
+    },std::chrono::seconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));     // flusher cpu counter is updated after each round
+    after = Profiler::instance().traceStats();
+
+    uint64_t written = after.written - before.written;
+    *report << std::left << std::setw(36) << ("trace flusher, " + std::to_string(num_threads) + " threads") << std::right
+            << std::fixed << std::setprecision(1) << std::setw(12)
+            << (written ? double(after.flusher_cpu_ns - before.flusher_cpu_ns)/1e6/(written/1e6) : 0.0)
+            << " ms cpu/M events  (" << written << " written, " << after.ring_dropped - before.ring_dropped << " dropped)" << std::endl;
+    Profiler::instance().disableTrace();
+}
+
+// 9. Threads spawning and stopping actors as fast as they can, every thread cycles over a few names,
+// so names and slots get reused all the time. actor_model.h has no stop() and spawns from one thread only
+void benchSpawnStop(size_t num_threads, [[maybe_unused]] size_t cycles_per_thread)
+{
+#ifdef BENCH_DISPATCHER_VERSION
+    *report << std::left << std::setw(36) << ("spawn+stop, " + std::to_string(num_threads) + " threads")
+            << "n/a for this version" << std::endl;
+#else
+    std::shared_ptr<ActorSystem<Job>> system = std::make_shared<ActorSystem<Job>>(64);
+    ActorModel::Profile::Profiler::instance().disableTrace();
+    std::atomic<size_t> cycles{0};
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (size_t t=0; t<num_threads; t++)
+    {
+        threads.emplace_back([&system,&cycles,t,cycles_per_thread](){
+            std::vector<std::string> names;
+            for (size_t k=0; k<8; k++)
+                names.push_back("churn" + std::to_string(t) + "_" + std::to_string(k));
+            size_t done = 0;
+            for (size_t i=0; i<cycles_per_thread; i++)
+            {
+                ActorHandle handle = system->spawn(2,names[i % names.size()]);
+                if ((handle.name != "") && system->stop(handle))
+                    done++;
+            }
+            cycles.fetch_add(done,std::memory_order_relaxed);
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+    uint64_t elapsed = elapsedNs(start);
+
+    *report << std::left << std::setw(36) << ("spawn+stop, " + std::to_string(num_threads) + " threads") << std::right
+            << std::fixed << std::setprecision(0) << std::setw(12) << cycles.load()*1e9/elapsed << " cycles/s  ("
+            << cycles.load() << " of " << num_threads*cycles_per_thread << " in " << std::setprecision(1)
+            << elapsed/1e6 << " ms)" << std::endl;
+#endif
+}
+
+int main()
+{
+    // keep the real stdout for results, mute std::cout (actor logs, per msg prints of actor_model.h)
+    std::ostream console(std::cout.rdbuf());
+    report = &console;
+    std::cout.rdbuf(nullptr);
+
+    console << "Actor model benchmarks: " << BenchSystem::version << std::endl;
+    benchPingPong(20000);
+    benchFanOutFanIn(8,100000);
+    benchRing(64,1,100000);
+    benchRing(64,16,10000);
+    benchSkewed(32,100000,0.8);
+    benchSkewed(32,100000,0.8,true);
+    benchRestartStorm(8,100);
+    benchSpawnStop(1,1000000);
+    benchSpawnStop(4,250000);
+    benchLogger(1);
+    benchLogger(4);
+    benchTracer(1);
+    benchTracer(16);
+    using ActorModel::Profile::Profiler;
+    benchTracer(1,"trace event masked out",[](){
+        Profiler::instance().setEventMask(Profiler::ALL_EVENTS & ~Profiler::eventBit(ActorModel::Profile::EventType::Enqueue)); });
+    benchTracer(16,"trace event 1-in-16",[](){ Profiler::instance().setSampling(16); });
+    benchTracer(16,"trace event capped 100k/s",[](){ Profiler::instance().setRateCap(100000); });
+    benchTraceFlusher(1);
+    benchTraceFlusher(16,100,512);
+    if (gave_up_sends.load())
+        console << "Sends given up after retries: " << gave_up_sends.load() << std::endl;
+
+    // std::cout stays muted, the async logger still flushes what the logger benchmark wrote when it shuts down
+    return 0;
+}
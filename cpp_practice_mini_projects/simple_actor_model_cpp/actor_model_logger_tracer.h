@@ -11,8 +11,81 @@
 #include <string>
 #include <time.h>
 #include <filesystem>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <shared_mutex>
+#include <queue>
+#include <functional>
+#include <cstddef>
+#include <condition_variable>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 #include "../simple_mpmc_queue/mpmc_queue_bounded.h"
 
+// Compile time log level, anything below it compiles to nothing (args are not even evaluated).
+// ACTOR_LOG_X(component, msg) logs a ready string, ACTOR_LOGF_X(component, "fmt {} {}", args...) leaves formatting to the writer thread
+// Build with -DACTOR_LOG_LEVEL=ACTOR_LOG_LEVEL_OFF for benchmarks
+#define ACTOR_LOG_LEVEL_DEBUG 0
+#define ACTOR_LOG_LEVEL_INFO 1
+#define ACTOR_LOG_LEVEL_WARN 2
+#define ACTOR_LOG_LEVEL_ERROR 3
+#define ACTOR_LOG_LEVEL_FATAL 4
+#define ACTOR_LOG_LEVEL_OFF 5
+
+#ifndef ACTOR_LOG_LEVEL
+#define ACTOR_LOG_LEVEL ACTOR_LOG_LEVEL_INFO
+#endif
+
+#if ACTOR_LOG_LEVEL <= ACTOR_LOG_LEVEL_DEBUG
+#define ACTOR_LOG_DEBUG(component, msg) ActorModel::Logger::log(ActorModel::Logger::Level::Debug, component, msg)
+#define ACTOR_LOGF_DEBUG(component, ...) ActorModel::Logger::logf(ActorModel::Logger::Level::Debug, component, __VA_ARGS__)
+#else
+#define ACTOR_LOG_DEBUG(component, msg) ((void)0)
+#define ACTOR_LOGF_DEBUG(component, ...) ((void)0)
+#endif
+
+#if ACTOR_LOG_LEVEL <= ACTOR_LOG_LEVEL_INFO
+#define ACTOR_LOG_INFO(component, msg) ActorModel::Logger::log(ActorModel::Logger::Level::Info, component, msg)
+#define ACTOR_LOGF_INFO(component, ...) ActorModel::Logger::logf(ActorModel::Logger::Level::Info, component, __VA_ARGS__)
+#else
+#define ACTOR_LOG_INFO(component, msg) ((void)0)
+#define ACTOR_LOGF_INFO(component, ...) ((void)0)
+#endif
+
+#if ACTOR_LOG_LEVEL <= ACTOR_LOG_LEVEL_WARN
+#define ACTOR_LOG_WARN(component, msg) ActorModel::Logger::log(ActorModel::Logger::Level::Warn, component, msg)
+#define ACTOR_LOGF_WARN(component, ...) ActorModel::Logger::logf(ActorModel::Logger::Level::Warn, component, __VA_ARGS__)
+#else
+#define ACTOR_LOG_WARN(component, msg) ((void)0)
+#define ACTOR_LOGF_WARN(component, ...) ((void)0)
+#endif
+
+#if ACTOR_LOG_LEVEL <= ACTOR_LOG_LEVEL_ERROR
+#define ACTOR_LOG_ERROR(component, msg) ActorModel::Logger::log(ActorModel::Logger::Level::Error, component, msg)
+#define ACTOR_LOGF_ERROR(component, ...) ActorModel::Logger::logf(ActorModel::Logger::Level::Error, component, __VA_ARGS__)
+#else
+#define ACTOR_LOG_ERROR(component, msg) ((void)0)
+#define ACTOR_LOGF_ERROR(component, ...) ((void)0)
+#endif
+
+#if ACTOR_LOG_LEVEL <= ACTOR_LOG_LEVEL_FATAL
+#define ACTOR_LOG_FATAL(component, msg) ActorModel::Logger::log(ActorModel::Logger::Level::Fatal, component, msg)
+#define ACTOR_LOGF_FATAL(component, ...) ActorModel::Logger::logf(ActorModel::Logger::Level::Fatal, component, __VA_ARGS__)
+#else
+#define ACTOR_LOG_FATAL(component, msg) ((void)0)
+#define ACTOR_LOGF_FATAL(component, ...) ((void)0)
+#endif
+
 /**
  * TODO:
  * 1. Add payload and component info to trace logs
@@ -25,6 +98,155 @@
 namespace ActorModel
 {
 
+    /* Bounded single producer single consumer ring, written in place:
+        producer fills the slot from claim(), then publish(). Capacity is rounded up to a power of 2
+    */
+    template <typename T>
+    class SpscRing
+    {
+    private:
+        alignas(64) std::atomic<size_t> head;   // consumer side
+        size_t cached_tail;
+        alignas(64) std::atomic<size_t> tail;   // producer side
+        size_t cached_head;
+        size_t mask;
+        std::unique_ptr<T[]> slots;
+
+    public:
+        std::atomic<bool> orphaned;     // producer thread is gone, ring can go once it is empty
+
+        explicit SpscRing(size_t capacity): head(0), cached_tail(0), tail(0), cached_head(0), orphaned(false)
+        {
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            mask = size-1;
+            slots = std::make_unique<T[]>(size);
+        }
+
+        T* claim()
+        {
+            size_t back = tail.load(std::memory_order_relaxed);
+            if (back - cached_head > mask)
+            {
+                cached_head = head.load(std::memory_order_acquire);
+                if (back - cached_head > mask)
+                    return nullptr;
+            }
+            return &slots[back & mask];
+        }
+
+        void publish()
+        {
+            tail.store(tail.load(std::memory_order_relaxed)+1,std::memory_order_release);
+        }
+
+        // Producer side: at least level items waiting? Only reads the consumer's head once the cached one says so
+        bool aboveHighWater(size_t level)
+        {
+            size_t back = tail.load(std::memory_order_relaxed);
+            if (back - cached_head < level)
+                return false;
+            cached_head = head.load(std::memory_order_acquire);
+            return (back - cached_head >= level);
+        }
+
+        const T* front()
+        {
+            size_t front_idx = head.load(std::memory_order_relaxed);
+            if (front_idx == cached_tail)
+            {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (front_idx == cached_tail)
+                    return nullptr;
+            }
+            return &slots[front_idx & mask];
+        }
+
+        void popFront()
+        {
+            head.store(head.load(std::memory_order_relaxed)+1,std::memory_order_release);
+        }
+
+        bool pop(T& out)
+        {
+            const T* item = front();
+            if (!item)
+                return false;
+            out = *item;
+            popFront();
+            return true;
+        }
+
+        bool empty()
+        {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+    };
+
+    // One SpscRing per producer thread, attached on the thread's first use, detached when the thread exits.
+    // Consumer side is a single thread walking all rings with drain()
+    template <typename T>
+    class ThreadRings
+    {
+    private:
+        std::mutex mtx;     // only taken when a thread attaches and by drain()
+        std::vector<std::shared_ptr<SpscRing<T>>> rings;
+        size_t ring_capacity;
+
+        struct LocalRing
+        {
+            std::shared_ptr<SpscRing<T>> ring;
+            ~LocalRing()
+            {
+                if (ring)
+                    ring->orphaned.store(true,std::memory_order_release);
+            }
+        };
+
+    public:
+        explicit ThreadRings(size_t capacity): ring_capacity(capacity) {}
+
+        // thread_local is per T, so this assumes one ThreadRings instance per T (they are all singletons)
+        SpscRing<T>& local()
+        {
+            thread_local LocalRing local_ring;
+            if (!local_ring.ring)
+            {
+                local_ring.ring = std::make_shared<SpscRing<T>>(ring_capacity);
+                std::lock_guard<std::mutex> lock(mtx);
+                rings.push_back(local_ring.ring);
+            }
+            return *local_ring.ring;
+        }
+
+        template <typename Func>
+        void drain(Func&& func)
+        {
+            withRings([&func](std::vector<std::shared_ptr<SpscRing<T>>>& all_rings){
+                for (auto& ring: all_rings)
+                    func(*ring);
+            });
+        }
+
+        // all rings at once, for consumers that merge them
+        template <typename Func>
+        void withRings(Func&& func)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            func(rings);
+            // rings of exited threads, once emptied
+            rings.erase(std::remove_if(rings.begin(),rings.end(),[](const std::shared_ptr<SpscRing<T>>& ring){
+                            return ring->orphaned.load(std::memory_order_acquire) && ring->empty(); }),rings.end());
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return rings.size();
+        }
+    };
+
     namespace Logger{
 
         enum class Level{
@@ -54,20 +276,383 @@ namespace ActorModel
             return mtx;
         }
 
-        inline void log(Level level, std::string_view component, std::string_view log_msg)
+        // "%F %T [LEVEL]\tcomponent: msg\n", the date part is only re-formatted when the second changes
+        inline void appendLogLine(std::string& out, Level level, std::string_view component, std::string_view log_msg,
+                            std::chrono::system_clock::time_point time)
         {
-            auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-            std::tm tstamp;
-            localtime_r(&now,&tstamp);
+            thread_local time_t cached_second = -1;
+            thread_local char cached_stamp[32];
+            time_t now = std::chrono::system_clock::to_time_t(time);
+            if (now != cached_second)
+            {
+                std::tm tstamp;
+                localtime_r(&now,&tstamp);
+                std::strftime(cached_stamp,sizeof(cached_stamp),"%F %T",&tstamp);
+                cached_second = now;
+            }
+            out += cached_stamp;
+            out += " [";
+            out += level_to_str(level);
+            out += "]\t";
+            out += component;
+            out += ": ";
+            out += log_msg;
+            out += "\n";
+        }
 
-            std::ostringstream oss;
+        // Format and print right away, on the calling thread
+        inline void log_sync(Level level, std::string_view component, std::string_view log_msg,
+                            std::chrono::system_clock::time_point time = std::chrono::system_clock::now())
+        {
+            std::string line;
+            appendLogLine(line,level,component,log_msg,time);
 
-            oss << std::put_time(&tstamp,"%F %T") << " [" << level_to_str(level) << "]\t" << component << ": " << log_msg << "\n";
+            std::lock_guard<std::mutex> log_lock(log_mtx());
+            std::cout << line;
+        }
 
-            //oss << now << " [" << level_to_str(level) << "]\t" << component << ": " << log_msg << "\n";
+        constexpr size_t MAX_LOG_ARGS = 4;
+        constexpr size_t LOG_TEXT_SIZE = 104;   // copied string args of one record, longer ones get truncated
 
-            std::lock_guard<std::mutex> log_lock(log_mtx());
-            std::cout << oss.str();
+        struct LogArg
+        {
+            enum class Type : uint8_t { Int, Uint, Double, Text };
+            Type type;
+            uint8_t text_len;
+            uint16_t text_offset;   // Text args live in LogEntry::text
+            union {
+                int64_t i;
+                uint64_t u;
+                double d;
+            };
+        };
+
+        // Fixed size, trivially copyable record (3 cachelines). fmt must be a string literal, only its pointer is stored
+        struct LogEntry
+        {
+            uint64_t time;      // LogClock ticks
+            const char* fmt;    // "{}" placeholders
+            uint32_t component; // interned id, see ComponentTable
+            Level level;
+            uint8_t num_args;
+            uint16_t text_used;
+            LogArg args[MAX_LOG_ARGS];
+            char text[LOG_TEXT_SIZE];
+        };
+
+        template <typename V>
+        inline void addLogArg(LogEntry& entry, const V& value)
+        {
+            LogArg& arg = entry.args[entry.num_args++];
+            if constexpr (std::is_same_v<V,bool>)
+            {
+                arg.type = LogArg::Type::Uint;
+                arg.u = value;
+            }
+            else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>)
+            {
+                arg.type = LogArg::Type::Int;
+                arg.i = value;
+            }
+            else if constexpr (std::is_integral_v<V> || std::is_enum_v<V>)
+            {
+                arg.type = LogArg::Type::Uint;
+                arg.u = static_cast<uint64_t>(value);
+            }
+            else if constexpr (std::is_floating_point_v<V>)
+            {
+                arg.type = LogArg::Type::Double;
+                arg.d = value;
+            }
+            else
+            {
+                // strings (std::string, string_view, char*) are copied, their memory may be gone before the writer runs
+                std::string_view text(value);
+                size_t len = std::min({text.size(), LOG_TEXT_SIZE - entry.text_used, size_t(255)});
+                std::memcpy(entry.text + entry.text_used, text.data(), len);
+                arg.type = LogArg::Type::Text;
+                arg.text_offset = entry.text_used;
+                arg.text_len = static_cast<uint8_t>(len);
+                entry.text_used += len;
+            }
+        }
+
+        // Component names (actor names, "ActorSystem"...) to small ids, each thread caches the ids it has seen.
+        // Owner only keeps the thread_local caches of different tables (logger, profiler) apart
+        template <typename Owner>
+        class ComponentTable
+        {
+        private:
+            struct StringHash
+            {
+                using is_transparent = void;
+                size_t operator()(std::string_view sv) const { return std::hash<std::string_view>{}(sv); }
+            };
+            using IdMap = std::unordered_map<std::string,uint32_t,StringHash,std::equal_to<>>;
+
+            std::shared_mutex mtx;
+            IdMap ids;
+            std::deque<std::string> names;  // deque, so that names never move
+
+        public:
+            uint32_t intern(std::string_view component)
+            {
+                // same name as last time (an actor logging a few lines in a row), skip the hash.
+                // Compared by content, a caller may reuse one std::string buffer for different names
+                thread_local std::string last_name;
+                thread_local uint32_t last_id = UINT32_MAX;
+                if ((last_id != UINT32_MAX) && (component == last_name))
+                    return last_id;
+                last_id = internSlow(component);
+                last_name.assign(component);
+                return last_id;
+            }
+
+            uint32_t internSlow(std::string_view component)
+            {
+                thread_local IdMap cache;
+                auto cached = cache.find(component);
+                if (cached != cache.end())
+                    return cached->second;
+
+                uint32_t id;
+                {
+                    std::unique_lock<std::shared_mutex> wlock(mtx);
+                    auto it = ids.find(component);
+                    if (it == ids.end())
+                    {
+                        names.emplace_back(component);
+                        it = ids.emplace(names.back(),static_cast<uint32_t>(names.size()-1)).first;
+                    }
+                    id = it->second;
+                }
+                cache.emplace(std::string(component),id);
+                return id;
+            }
+
+            std::string_view name(uint32_t id)
+            {
+                std::shared_lock<std::shared_mutex> rlock(mtx);
+                return (id < names.size()) ? std::string_view(names[id]) : std::string_view("?");
+            }
+
+            size_t size()
+            {
+                std::shared_lock<std::shared_mutex> rlock(mtx);
+                return names.size();
+            }
+        };
+
+        /* Timestamps for log records: TSC where we have it (about half the cost of steady_clock::now() on our boxes),
+            steady_clock ns elsewhere. Writer converts ticks to wall time with a calibration against steady_clock
+        */
+        struct LogClock
+        {
+            static uint64_t ticks()
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                return __rdtsc();
+#else
+                return steadyNs();
+#endif
+            }
+
+            static uint64_t steadyNs()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+        };
+
+        // LogClock ticks -> ns since base / wall clock. Consumer side only (logger writer, profiler flusher), not thread safe
+        struct TickCalibration
+        {
+            std::chrono::system_clock::time_point wall_base;    // wall clock at tick_base/steady_base
+            uint64_t tick_base;
+            uint64_t steady_base;
+            double ticks_per_ns;
+
+            TickCalibration()
+            {
+                wall_base = std::chrono::system_clock::now();
+                steady_base = LogClock::steadyNs();
+                tick_base = LogClock::ticks();
+                // rough first estimate over ~100us, so that records of the first ms don't come out scaled wrong
+                while (LogClock::steadyNs() - steady_base < 100000) {}
+                ticks_per_ns = 1.0;
+                update(0);
+            }
+
+            // re-calibrate ticks against steady_clock, more precise the longer we run
+            void update(uint64_t min_elapsed_ns = 1000000)
+            {
+                uint64_t steady_now = LogClock::steadyNs();
+                uint64_t tick_now = LogClock::ticks();
+                uint64_t steady_elapsed = steady_now - steady_base;
+                if (steady_elapsed > min_elapsed_ns)
+                    ticks_per_ns = double(tick_now - tick_base)/steady_elapsed;
+            }
+
+            int64_t sinceBaseNs(uint64_t ticks) const
+            {
+                return static_cast<int64_t>(static_cast<int64_t>(ticks - tick_base)/ticks_per_ns);
+            }
+
+            uint64_t ticksFor(uint64_t ns) const
+            {
+                return static_cast<uint64_t>(ns*ticks_per_ns);
+            }
+
+            std::chrono::system_clock::time_point wallTime(uint64_t ticks) const
+            {
+                return wall_base + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(sinceBaseNs(ticks)));
+            }
+        };
+
+        /* Async logger
+            - Hot path: find this thread's ring (thread_local), intern the component (thread_local cache hit),
+              fill a LogEntry in place, publish. No formatting, no locks, no allocation
+            - One writer thread pulls everything from all rings, sorts the batch by time, then formats and writes
+            - Ring full means the record is dropped and counted, logging never blocks an actor
+        */
+        class AsyncLogger
+        {
+        private:
+            ThreadRings<LogEntry> rings;
+            ComponentTable<AsyncLogger> components;
+            std::atomic<bool> running;
+            std::atomic<uint64_t> dropped;
+            TickCalibration clock;
+            std::vector<LogEntry> batch;
+            std::thread writer;
+
+            AsyncLogger(): rings(1024), running(true), dropped(0)
+            {
+                writer = std::thread([this](){ writerLoop(); });
+            }
+
+            void writerLoop()
+            {
+                while (running.load(std::memory_order_acquire))
+                {
+                    if (!flush())
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                flush();
+            }
+
+            void format(const LogEntry& entry, std::string& out)
+            {
+                out.clear();
+                size_t next_arg = 0;
+                for (const char* c = entry.fmt; *c; c++)
+                {
+                    if ((c[0] != '{') || (c[1] != '}') || (next_arg >= entry.num_args))
+                    {
+                        out += *c;
+                        continue;
+                    }
+                    const LogArg& arg = entry.args[next_arg++];
+                    switch (arg.type)
+                    {
+                        case LogArg::Type::Int:
+                            out += std::to_string(arg.i);
+                            break;
+                        case LogArg::Type::Uint:
+                            out += std::to_string(arg.u);
+                            break;
+                        case LogArg::Type::Double:
+                            out += std::to_string(arg.d);
+                            break;
+                        case LogArg::Type::Text:
+                            out.append(entry.text + arg.text_offset,arg.text_len);
+                            break;
+                    }
+                    c++;
+                }
+            }
+
+        public:
+            inline static AsyncLogger& instance()
+            {
+                static AsyncLogger logger;
+                return logger;
+            }
+
+            template <typename... Args>
+            inline void write(Level level, std::string_view component, const char* fmt, const Args&... args)
+            {
+                static_assert(sizeof...(Args) <= MAX_LOG_ARGS, "too many log args");
+                SpscRing<LogEntry>& ring = rings.local();
+                LogEntry* entry = ring.claim();
+                if (!entry)
+                {
+                    dropped.fetch_add(1,std::memory_order_relaxed);
+                    return;
+                }
+                entry->time = LogClock::ticks();
+                entry->fmt = fmt;
+                entry->component = components.intern(component);
+                entry->level = level;
+                entry->num_args = 0;
+                entry->text_used = 0;
+                (addLogArg(*entry,args), ...);
+                ring.publish();
+            }
+
+            // Write out everything logged so far, returns false if there was nothing. Writer thread only
+            bool flush()
+            {
+                batch.clear();
+                rings.drain([this](SpscRing<LogEntry>& ring){
+                    LogEntry entry;
+                    while (ring.pop(entry))
+                        batch.push_back(entry);
+                });
+                if (batch.empty())
+                    return false;
+
+                // rings are per thread, sort so the output is in time order across threads
+                std::stable_sort(batch.begin(),batch.end(),[](const LogEntry& a, const LogEntry& b){ return a.time < b.time; });
+
+                clock.update();
+
+                std::string msg;
+                std::string out;
+                for (const LogEntry& entry: batch)
+                {
+                    format(entry,msg);
+                    appendLogLine(out,entry.level,components.name(entry.component),msg,clock.wallTime(entry.time));
+                }
+                std::lock_guard<std::mutex> log_lock(log_mtx());
+                std::cout << out;
+                return true;
+            }
+
+            uint64_t droppedCount() const
+            {
+                return dropped.load(std::memory_order_relaxed);
+            }
+
+            ~AsyncLogger()
+            {
+                running.store(false,std::memory_order_release);
+                if (writer.joinable())
+                    writer.join();
+                if (dropped.load())
+                    log_sync(Level::Warn,"Logger",std::to_string(dropped.load()) + " log records dropped");
+            }
+        };
+
+        // fmt must be a string literal with "{}" placeholders, args are numbers or strings (strings get copied)
+        template <typename... Args>
+        inline void logf(Level level, std::string_view component, const char* fmt, const Args&... args)
+        {
+            AsyncLogger::instance().write(level,component,fmt,args...);
+        }
+
+        inline void log(Level level, std::string_view component, std::string_view log_msg)
+        {
+            AsyncLogger::instance().write(level,component,"{}",log_msg);
         }
     };
 
@@ -75,7 +660,7 @@ namespace ActorModel
     {
         using namespace std::chrono;
 
-        enum class EventType{
+        enum class EventType : uint32_t {
             Register,
             Unregister,
             Restart,
@@ -87,6 +672,11 @@ namespace ActorModel
             StopSystem,
             PoolEnqueue,
             PoolDequeue,
+            DropNewest,
+            DropOldest,
+            DeadLetter,
+            BlockTimeout,
+            PoolTaskEnd,
             MaxEvent
         };
 
@@ -116,79 +706,531 @@ namespace ActorModel
                     return "PoolEnqueue";
                 case EventType::PoolDequeue:
                     return "PoolDequeue";
+                case EventType::DropNewest:
+                    return "DropNewest";
+                case EventType::DropOldest:
+                    return "DropOldest";
+                case EventType::DeadLetter:
+                    return "DeadLetter";
+                case EventType::BlockTimeout:
+                    return "BlockTimeout";
+                case EventType::PoolTaskEnd:
+                    return "PoolTaskEnd";
                 case EventType::MaxEvent:
                     return "INVALID";
             }
             return "INVALID";
         }
 
+        // Trivially copyable, 40 bytes. time is LogClock ticks while buffered, ns since trace start in the trace file
         struct Event {
-            EventType type;
-            uint64_t time_stamp;
-            std::string component;
-            size_t actor_id;
+            uint64_t time;
+            uint64_t actor_id;
             uint64_t gen_id;
-            std::thread::id thread_id;
             uint32_t payload;
+            uint32_t thread_idx;    // small per thread index, see Profiler::threadIndex()
+            uint32_t component;     // interned name, 0 = none
+            EventType type;
+        };
+        static_assert(std::is_trivially_copyable_v<Event>, "Event is memcpy'd into trace buffers and the trace file");
+
+        /* Binary trace file (log/actor_trace_<ms>.bin), read back by trace_to_csv:
+            TraceFileHeader | Event * event_count | string table
+            String table entries are TraceString followed by len bytes of name, one table for event type names,
+            component names and thread ids. event_count/string_table_offset are filled in when the trace is closed,
+            string_table_offset = 0 means the process died before that
+        */
+        inline constexpr char TRACE_MAGIC[8] = {'A','C','T','T','R','A','C','E'};
+        inline constexpr uint32_t TRACE_VERSION = 1;
+
+        struct TraceFileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t event_size;        // sizeof(Event) of the writer
+            uint64_t start_wall_ns;     // system_clock ns since epoch at time 0 of the trace
+            uint64_t event_count;
+            uint64_t string_table_offset;
+        };
+
+        enum class TraceStringKind : uint32_t { EventType, Component, Thread };
+
+        struct TraceString {
+            TraceStringKind kind;
+            uint32_t id;
+            uint32_t len;
+        };
+
+        /* Writes the trace file for the Profiler's flusher
+            - Events are serialised into one of two 1 MB page aligned buffers. A full buffer goes to the io thread,
+              which pwrite()s it, while the flusher fills the other one. The flusher only waits when it fills
+              faster than the disk takes it
+            - With a max file size set, a buffer that would go past it starts a new file first:
+              <base>_1.bin, <base>_2.bin... Every file gets its own header and the full string table, so each one
+              can be read on its own
+            - string_table builds the table bytes, asked for whenever a file is finished
+        */
+        class TraceFileWriter
+        {
+        public:
+            static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+        private:
+            struct IoJob {
+                int fd;
+                const char* data;
+                size_t len;
+                uint64_t offset;
+            };
+
+            std::string base_name;      // without .bin
+            uint64_t start_wall_ns;
+            std::function<std::string()> string_table;
+            std::atomic<uint64_t> max_file_size;
+            std::string file_name;
+            int fd;
+            size_t file_index;
+            uint64_t file_offset;       // where the next buffer goes
+            uint64_t events_in_file;
+
+            char* buffers[2];
+            size_t fill_idx;
+            size_t fill_used;
+            size_t fill_events;
 
-            Event(){}
-            Event(EventType etype, size_t act_id,uint64_t genid, uint32_t payload_): 
-                type(etype),actor_id(act_id),gen_id(genid) ,payload(payload_) 
+            std::mutex io_mtx;
+            std::condition_variable io_cv;
+            bool io_pending;
+            bool io_stop;
+            IoJob io_job;
+            std::thread io_thread;
+            std::atomic<uint64_t> io_cpu_ns;
+
+            static void writeAll(int file, const char* data, size_t len, uint64_t offset)
             {
-                time_stamp = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-                thread_id = std::this_thread::get_id();
+                while (len)
+                {
+                    ssize_t done = ::pwrite(file,data,len,static_cast<off_t>(offset));
+                    if (done < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        ACTOR_LOG_ERROR("Profiler","trace write failed");
+                        return;
+                    }
+                    data += done;
+                    len -= done;
+                    offset += done;
+                }
+            }
+
+            void ioLoop()
+            {
+                std::unique_lock<std::mutex> lock(io_mtx);
+                while (true)
+                {
+                    io_cv.wait(lock,[this](){ return io_pending || io_stop; });
+                    if (!io_pending)
+                        return;
+                    IoJob job = io_job;
+                    lock.unlock();
+                    writeAll(job.fd,job.data,job.len,job.offset);
+                    timespec ts;
+                    clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+                    io_cpu_ns.store(static_cast<uint64_t>(ts.tv_sec)*1000000000ull + ts.tv_nsec,std::memory_order_relaxed);
+                    lock.lock();
+                    io_pending = false;
+                    io_cv.notify_all();
+                }
+            }
+
+            void waitIoIdle()
+            {
+                std::unique_lock<std::mutex> lock(io_mtx);
+                io_cv.wait(lock,[this](){ return !io_pending; });
+            }
+
+            void openFile()
+            {
+                file_name = base_name + (file_index ? "_" + std::to_string(file_index) : "") + ".bin";
+                fd = ::open(file_name.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+                if (fd < 0)
+                    ACTOR_LOG_ERROR("Profiler","cannot open trace file " + file_name);
+                TraceFileHeader header{};
+                std::memcpy(header.magic,TRACE_MAGIC,sizeof(header.magic));
+                header.version = TRACE_VERSION;
+                header.event_size = sizeof(Event);
+                header.start_wall_ns = start_wall_ns;
+                if (fd >= 0)
+                    writeAll(fd,reinterpret_cast<const char*>(&header),sizeof(header),0);
+                file_offset = sizeof(header);
+                events_in_file = 0;
+            }
+
+            // io thread must be idle: string table after the events, then patch the header
+            void finishFile()
+            {
+                if (fd < 0)
+                    return;
+                std::string table = string_table ? string_table() : std::string();
+                writeAll(fd,table.data(),table.size(),file_offset);
+                uint64_t table_offset = file_offset;
+                writeAll(fd,reinterpret_cast<const char*>(&events_in_file),sizeof(events_in_file),offsetof(TraceFileHeader,event_count));
+                writeAll(fd,reinterpret_cast<const char*>(&table_offset),sizeof(table_offset),offsetof(TraceFileHeader,string_table_offset));
+                ::close(fd);
+                fd = -1;
+            }
+
+            // hand the fill buffer to the io thread and switch to the other one
+            void handOver()
+            {
+                if (!fill_used)
+                    return;
+                waitIoIdle();   // the other buffer is free once its write is done
+                uint64_t max_size = max_file_size.load(std::memory_order_relaxed);
+                if (max_size && events_in_file && (file_offset + fill_used > max_size))
+                {
+                    finishFile();
+                    file_index++;
+                    openFile();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(io_mtx);
+                    io_job = IoJob{fd,buffers[fill_idx],fill_used,file_offset};
+                    io_pending = (fd >= 0);
+                }
+                io_cv.notify_all();
+                file_offset += fill_used;
+                events_in_file += fill_events;
+                fill_idx ^= 1;
+                fill_used = 0;
+                fill_events = 0;
+            }
+
+        public:
+            TraceFileWriter(std::string base, uint64_t wall_ns, std::function<std::string()> table)
+                : base_name(std::move(base)), start_wall_ns(wall_ns), string_table(std::move(table)), max_file_size(0),
+                  fd(-1), file_index(0), file_offset(0), events_in_file(0), fill_idx(0), fill_used(0), fill_events(0),
+                  io_pending(false), io_stop(false), io_cpu_ns(0)
+            {
+                for (auto& buffer: buffers)
+                    buffer = static_cast<char*>(std::aligned_alloc(4096,BUFFER_SIZE));
+                openFile();
+                io_thread = std::thread([this](){ ioLoop(); });
+            }
+
+            ~TraceFileWriter()
+            {
+                close();
+                for (auto& buffer: buffers)
+                    std::free(buffer);
+            }
+
+            // slot for the next event, valid till the next call. Flusher thread only
+            Event* next()
+            {
+                if (fill_used + sizeof(Event) > BUFFER_SIZE)
+                    handOver();
+                return reinterpret_cast<Event*>(buffers[fill_idx] + fill_used);
+            }
+
+            void commit()
+            {
+                fill_used += sizeof(Event);
+                fill_events++;
+            }
+
+            // write out what is buffered, end of a flusher round
+            void flush()
+            {
+                handOver();
+            }
+
+            // flush, finish the file and stop the io thread
+            void close()
+            {
+                if (io_thread.joinable())
+                {
+                    handOver();
+                    waitIoIdle();
+                    finishFile();
+                    {
+                        std::lock_guard<std::mutex> lock(io_mtx);
+                        io_stop = true;
+                    }
+                    io_cv.notify_all();
+                    io_thread.join();
+                }
             }
 
+            // 0 = one file, no rotation
+            void setMaxFileSize(uint64_t bytes)
+            {
+                max_file_size.store(bytes,std::memory_order_relaxed);
+            }
+
+            const std::string& fileName() const
+            {
+                return file_name;
+            }
+
+            // cpu time of the io thread so far
+            uint64_t ioCpuNs() const
+            {
+                return io_cpu_ns.load(std::memory_order_relaxed);
+            }
+        };
+
+        // Counters of what did not make it into the trace (plus what did), see Profiler::traceStats()
+        struct TraceStats {
+            uint64_t written;       // events in the trace file so far
+            uint64_t ring_dropped;  // thread's trace buffer was full
+            uint64_t rate_capped;   // over the per second cap
+            uint64_t flusher_cpu_ns;    // cpu time of the flusher and its io thread so far
         };
 
+        /* Every recording thread gets its own SPSC trace buffer (attached on its first event), so actor and pool threads
+            don't CAS on one shared ring while we measure them. Flusher drains all buffers and merge-sorts them by timestamp,
+            a full buffer drops the event and counts it
+
+            Filters, all can be changed while running: event type mask, actor id set, 1-in-N sampling, per second cap.
+            They are folded into one word (active_filter): a bit per EventType, cleared while tracing is off, plus a bit per
+            filter that needs more than the mask. So an event that is off costs one relaxed load in record(),
+            and with only the mask set so does an event that is on
+        */
         class Profiler
         {
         
         private:
-            std::ofstream log_file;
-            std::string log_file_name;
-            std::atomic<bool> trace_enabled;
-            size_t ring_buf_size;
-            mpmcQueueBounded<Event> ring_buf;
+            std::atomic<bool> flusher_running;
+            size_t ring_buf_size;       // per thread
+            ThreadRings<Event> thread_bufs;
+            Logger::ComponentTable<Profiler> components;
+            Logger::TickCalibration clock;
+            std::atomic<uint64_t> dropped;
+
+            // filters, see setEventMask() etc. Setters take filter_mtx and re-publish active_filter
+            static constexpr uint32_t FILTER_ACTORS = 1u << 29;
+            static constexpr uint32_t FILTER_SAMPLING = 1u << 30;
+            static constexpr uint32_t FILTER_RATE_CAP = 1u << 31;
+            static constexpr uint32_t FILTER_SLOW_PATH = FILTER_ACTORS | FILTER_SAMPLING | FILTER_RATE_CAP;
+            static constexpr size_t MAX_FILTER_ACTORS = 4096;
+            std::atomic<uint32_t> active_filter;
+            std::mutex filter_mtx;
+            bool recording;
+            uint32_t event_mask;
+            bool actor_filter_on;
+            std::atomic<uint64_t> actor_bits[MAX_FILTER_ACTORS/64];
+            std::atomic<uint32_t> sample_every;
+            std::atomic<uint64_t> rate_cap;         // events per second, all threads together
+            std::atomic<uint64_t> rate_window;      // current second, in ticks/ticks_per_sec
+            std::atomic<uint64_t> rate_count;
+            std::atomic<uint64_t> ticks_per_sec;    // kept up to date by the flusher
+            std::atomic<uint64_t> rate_capped;
+            std::atomic<uint64_t> flusher_cpu_ns;
+
             std::thread flusher_thread;
+            std::mutex flush_mtx;       // flusher thread and the final flush in the destructor
+            std::mutex wake_mtx;
+            std::condition_variable flush_cv;
+            std::atomic<bool> flush_requested;      // a thread's buffer crossed the high water mark
+            std::unique_ptr<TraceFileWriter> trace_file;
+            uint64_t events_written;
+            std::mutex threads_mtx;
+            std::vector<std::string> thread_names;  // by thread_idx
+            size_t high_water;
+            static constexpr uint64_t HOLD_BACK_US = 2000;
+            static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(5);
+            static constexpr auto MIN_FLUSH_GAP = std::chrono::milliseconds(1);   // between rounds asked for by high water
 
 
-            Profiler(): trace_enabled{false},ring_buf_size{100000},ring_buf{ring_buf_size}
+            Profiler(): flusher_running{false},ring_buf_size{8192},thread_bufs{ring_buf_size},dropped{0},
+                        active_filter{0},recording{false},event_mask{ALL_EVENTS},actor_filter_on{false},sample_every{1},
+                        rate_cap{0},rate_window{0},rate_count{0},rate_capped{0},flusher_cpu_ns{0},flush_requested{false},
+                        events_written{0},high_water{ring_buf_size/2}
             {
-                //ring_buf = mpmcQueueBounded<Event>(ring_buf_size);
+                for (auto& bits: actor_bits)
+                    bits.store(0,std::memory_order_relaxed);
+                ticks_per_sec.store(clock.ticksFor(1000000000),std::memory_order_relaxed);
+                components.intern("");      // id 0, no component
                 std::filesystem::path logdir = "log";
                 try{
                     std::filesystem::create_directory(logdir);
                 }
                 catch(std::exception e)
                 {
-                    Logger::log(Logger::Level::Error, "Profiler",e.what());
+                    ACTOR_LOG_ERROR("Profiler",e.what());
                 }
                 
-                auto timestamp = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-                log_file_name = "log/actor_trace_"+ std::to_string(timestamp)+".csv";
-                
-                log_file.open(log_file_name,std::ios::out);
-                log_file <<"timestamp,actor_id,gen_id,thread_id,eventType\n";
+                auto timestamp = duration_cast<milliseconds>(clock.wall_base.time_since_epoch()).count();
+                trace_file = std::make_unique<TraceFileWriter>("log/actor_trace_"+ std::to_string(timestamp),
+                                    duration_cast<nanoseconds>(clock.wall_base.time_since_epoch()).count(),
+                                    [this](){ return stringTable(); });
+            }
+
+            static uint64_t threadCpuNs()
+            {
+                timespec ts;
+                clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+                return static_cast<uint64_t>(ts.tv_sec)*1000000000ull + ts.tv_nsec;
             }
 
+            // woken by a buffer crossing its high water mark, or every FLUSH_INTERVAL.
+            // A buffer stays above high water till its events are older than HOLD_BACK_US,
+            // so high water rounds are spaced by MIN_FLUSH_GAP instead of spinning meanwhile
             void event_flusher()
             {
-                while(Profile::Profiler::instance().trace_enabled.load(std::memory_order_acquire))
+                while(flusher_running.load(std::memory_order_acquire))
+                {
+                    bool requested;
+                    {
+                        std::unique_lock<std::mutex> lock(wake_mtx);
+                        requested = flush_cv.wait_for(lock,FLUSH_INTERVAL,[this](){
+                            return flush_requested.load(std::memory_order_relaxed) || !flusher_running.load(std::memory_order_relaxed); });
+                    }
+                    flush_requested.store(false,std::memory_order_relaxed);
+                    dump_events();
+                    flusher_cpu_ns.store(threadCpuNs(),std::memory_order_relaxed);
+                    if (requested)
+                        std::this_thread::sleep_for(MIN_FLUSH_GAP);
+                }
+            }
+
+            /* Merge all thread buffers in time order straight into the trace file buffers, nothing is copied on the way.
+                Every buffer is in time order on its own, so a buffer is done for this round once its front event is newer
+                than the watermark. The watermark (now - HOLD_BACK_US) leaves room for a thread that took its timestamp
+                but got descheduled before publishing the event. final = true writes everything
+            */
+            void dump_events(bool final = false)
+            {
+                std::lock_guard<std::mutex> lock(flush_mtx);
+                clock.update();
+                ticks_per_sec.store(clock.ticksFor(1000000000),std::memory_order_relaxed);
+                uint64_t watermark = final ? UINT64_MAX : Logger::LogClock::ticks() - clock.ticksFor(HOLD_BACK_US*1000);
+
+                thread_bufs.withRings([this,watermark](std::vector<std::shared_ptr<SpscRing<Event>>>& rings){
+                    using HeapItem = std::pair<uint64_t,size_t>;     // front event time, ring
+                    std::priority_queue<HeapItem,std::vector<HeapItem>,std::greater<HeapItem>> heap;
+                    for (size_t r=0; r<rings.size(); r++)
+                    {
+                        const Event* ev = rings[r]->front();
+                        if (ev && (ev->time <= watermark))
+                            heap.push({ev->time,r});
+                    }
+
+                    while (!heap.empty())
+                    {
+                        SpscRing<Event>& ring = *rings[heap.top().second];
+                        size_t r = heap.top().second;
+                        heap.pop();
+                        // keep taking from this ring while it stays the oldest, saves the heap ops for a lone busy thread
+                        uint64_t limit = heap.empty() ? watermark : std::min(watermark,heap.top().first);
+                        const Event* ev = ring.front();
+                        while (ev && (ev->time <= limit))
+                        {
+                            Event* out = trace_file->next();
+                            *out = *ev;
+                            out->time = static_cast<uint64_t>(std::max<int64_t>(0,clock.sinceBaseNs(ev->time)));
+                            trace_file->commit();
+                            events_written++;
+                            ring.popFront();
+                            ev = ring.front();
+                        }
+                        if (ev && (ev->time <= watermark))
+                            heap.push({ev->time,r});
+                    }
+                });
+                trace_file->flush();
+            }
+
+            void appendString(std::string& table, TraceStringKind kind, uint32_t id, std::string_view name)
+            {
+                TraceString entry{kind,id,static_cast<uint32_t>(name.size())};
+                table.append(reinterpret_cast<const char*>(&entry),sizeof(entry));
+                table.append(name);
+            }
+
+            // event type names, components and threads seen so far
+            std::string stringTable()
+            {
+                std::string table;
+                for (uint32_t et=0; et<static_cast<uint32_t>(EventType::MaxEvent); et++)
+                    appendString(table,TraceStringKind::EventType,et,evtToStr(static_cast<EventType>(et)));
+                size_t num_components = components.size();
+                for (uint32_t id=0; id<num_components; id++)
+                    appendString(table,TraceStringKind::Component,id,components.name(id));
+                std::lock_guard<std::mutex> lock(threads_mtx);
+                for (uint32_t idx=0; idx<thread_names.size(); idx++)
+                    appendString(table,TraceStringKind::Thread,idx,thread_names[idx]);
+                return table;
+            }
+
+            // filter_mtx held
+            void publishFilter()
+            {
+                uint32_t filter = 0;
+                if (recording && event_mask)
                 {
-                    dump_to_csv();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    filter = event_mask;
+                    if (actor_filter_on)
+                        filter |= FILTER_ACTORS;
+                    if (sample_every.load(std::memory_order_relaxed) > 1)
+                        filter |= FILTER_SAMPLING;
+                    if (rate_cap.load(std::memory_order_relaxed))
+                        filter |= FILTER_RATE_CAP;
                 }
+                active_filter.store(filter,std::memory_order_relaxed);
+            }
+
+            static constexpr bool hasActor(EventType type)
+            {
+                return (type != EventType::PoolEnqueue) && (type != EventType::PoolDequeue)
+                        && (type != EventType::PoolTaskEnd) && (type != EventType::StopSystem);
             }
 
-            void dump_to_csv()
+            // Everything after the mask, cheapest first. Only called when one of these filters is set
+            bool passesFilters(uint32_t filter, EventType type, uint64_t actor_id)
             {
-                Event ev;
-                while(ring_buf.try_pop(ev))
-                    log_file << ev.time_stamp<<","<<ev.actor_id<<","<< ev.gen_id<<","<<
-                            ev.thread_id << ","<< evtToStr(ev.type) <<"\n"  ;
+                if ((filter & FILTER_ACTORS) && hasActor(type))
+                {
+                    if ((actor_id >= MAX_FILTER_ACTORS)
+                        || !(actor_bits[actor_id/64].load(std::memory_order_relaxed) & (1ull << (actor_id%64))))
+                        return false;
+                }
+                if (filter & FILTER_SAMPLING)
+                {
+                    thread_local uint32_t seen = 0;
+                    if ((seen++ % sample_every.load(std::memory_order_relaxed)) != 0)
+                        return false;
+                }
+                if (filter & FILTER_RATE_CAP)
+                {
+                    // fixed one second windows, whoever sees a new window first resets the count
+                    uint64_t window = Logger::LogClock::ticks()/ticks_per_sec.load(std::memory_order_relaxed);
+                    uint64_t current = rate_window.load(std::memory_order_relaxed);
+                    if ((window > current) && rate_window.compare_exchange_strong(current,window,std::memory_order_relaxed))
+                        rate_count.store(0,std::memory_order_relaxed);
+                    if (rate_count.fetch_add(1,std::memory_order_relaxed) >= rate_cap.load(std::memory_order_relaxed))
+                    {
+                        rate_capped.fetch_add(1,std::memory_order_relaxed);
+                        return false;
+                    }
+                }
+                return true;
+            }
 
-                return;
+            // assigned on a thread's first event, its std::thread::id goes to the string table
+            uint32_t threadIndex()
+            {
+                thread_local uint32_t idx = UINT32_MAX;
+                if (idx == UINT32_MAX)
+                {
+                    std::ostringstream oss;
+                    oss << std::this_thread::get_id();
+                    std::lock_guard<std::mutex> lock(threads_mtx);
+                    idx = static_cast<uint32_t>(thread_names.size());
+                    thread_names.push_back(oss.str());
+                }
+                return idx;
             }
 
         public:
@@ -198,32 +1240,149 @@ namespace ActorModel
                 return prof;
             }
 
+            static constexpr uint32_t eventBit(EventType type)
+            {
+                return 1u << static_cast<uint32_t>(type);
+            }
+            static constexpr uint32_t ALL_EVENTS = (1u << static_cast<uint32_t>(EventType::MaxEvent)) - 1;
+            static_assert(static_cast<uint32_t>(EventType::MaxEvent) <= 29, "EventType bits run into the filter bits");
+
+            // Flusher keeps running till the Profiler goes away, disableTrace() only stops recording
             void enableTrace()
             {
-                if (!trace_enabled.exchange(true, std::memory_order_relaxed))
+                std::lock_guard<std::mutex> lock(filter_mtx);
+                recording = true;
+                publishFilter();
+                if (!flusher_running.exchange(true, std::memory_order_relaxed))
                     flusher_thread = std::thread([this](){event_flusher();});
             }
 
             void disableTrace()
             {
-                trace_enabled.store(false,std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(filter_mtx);
+                recording = false;
+                publishFilter();
+            }
+
+            bool isTraceEnabled() const
+            {
+                return active_filter.load(std::memory_order_relaxed) != 0;
+            }
+
+            // Only these event types are recorded, eventBit(EventType::Fail) | ..., ALL_EVENTS to record everything
+            void setEventMask(uint32_t mask)
+            {
+                std::lock_guard<std::mutex> lock(filter_mtx);
+                event_mask = mask & ALL_EVENTS;
+                publishFilter();
+            }
+
+            // Only events of these actors (and the ones without actor: pool, StopSystem). Empty = all actors.
+            // Ids >= MAX_FILTER_ACTORS can't be selected
+            void setActorFilter(const std::vector<size_t>& actor_ids)
+            {
+                std::lock_guard<std::mutex> lock(filter_mtx);
+                for (auto& bits: actor_bits)
+                    bits.store(0,std::memory_order_relaxed);
+                for (size_t id: actor_ids)
+                    if (id < MAX_FILTER_ACTORS)
+                        actor_bits[id/64].fetch_or(1ull << (id%64),std::memory_order_relaxed);
+                actor_filter_on = !actor_ids.empty();
+                publishFilter();
+            }
+
+            // Record every n-th event that passes the other filters, counted per thread. 1 = all of them.
+            // Sampling cuts slices in half (a DrainStart without its DrainEnd...), the exporters live with that
+            void setSampling(uint32_t one_in_n)
+            {
+                std::lock_guard<std::mutex> lock(filter_mtx);
+                sample_every.store(std::max<uint32_t>(one_in_n,1),std::memory_order_relaxed);
+                publishFilter();
+            }
+
+            // At most this many events per second over all threads, the rest is counted in rate_capped. 0 = no cap
+            void setRateCap(uint64_t events_per_sec)
+            {
+                std::lock_guard<std::mutex> lock(filter_mtx);
+                rate_cap.store(events_per_sec,std::memory_order_relaxed);
+                publishFilter();
+            }
+
+            TraceStats traceStats()
+            {
+                TraceStats stats;
+                {
+                    std::lock_guard<std::mutex> lock(flush_mtx);
+                    stats.written = events_written;
+                }
+                stats.ring_dropped = dropped.load(std::memory_order_relaxed);
+                stats.rate_capped = rate_capped.load(std::memory_order_relaxed);
+                stats.flusher_cpu_ns = flusher_cpu_ns.load(std::memory_order_relaxed) + trace_file->ioCpuNs();
+                return stats;
+            }
+
+            // component is optional (actor name on Register...), interned, so keep it to rare events
+            inline void record(EventType type, uint64_t actor_id, uint64_t gen_id, uint32_t payload, std::string_view component = {})
+            {
+                uint32_t filter = active_filter.load(std::memory_order_relaxed);
+                if (!(filter & eventBit(type)))
+                    return;
+                if ((filter & FILTER_SLOW_PATH) && !passesFilters(filter,type,actor_id))
+                    return;
+                {
+                    SpscRing<Event>& ring = thread_bufs.local();
+                    Event* slot = ring.claim();
+                    if (!slot)
+                    {
+                        dropped.fetch_add(1,std::memory_order_relaxed);
+                        return;
+                    }
+                    slot->time = Logger::LogClock::ticks();
+                    slot->actor_id = actor_id;
+                    slot->gen_id = gen_id;
+                    slot->payload = payload;
+                    slot->thread_idx = threadIndex();
+                    slot->component = component.empty() ? 0 : components.intern(component);
+                    slot->type = type;
+                    ring.publish();
+                    if (ring.aboveHighWater(high_water) && !flush_requested.load(std::memory_order_relaxed)
+                        && !flush_requested.exchange(true,std::memory_order_relaxed))
+                        flush_cv.notify_one();
+                }
+            }
+
+            uint64_t droppedCount() const
+            {
+                return dropped.load(std::memory_order_relaxed);
+            }
+
+            // current trace file, changes when the file is rotated
+            std::string traceFileName()
+            {
+                std::lock_guard<std::mutex> lock(flush_mtx);
+                return trace_file->fileName();
             }
 
-            template<typename... Args>
-            inline void record(Args&&... args)
+            // start a new trace file once this size would be passed, 0 = never (default)
+            void setMaxFileSize(uint64_t bytes)
             {
-                if (Profile::Profiler::instance().trace_enabled.load(std::memory_order_relaxed))
-                    ring_buf.try_emplace(std::forward<Args>(args)...);
+                trace_file->setMaxFileSize(bytes);
             }
 
             ~Profiler()
             {
                 disableTrace();
+                flusher_running.store(false,std::memory_order_release);
+                if (dropped.load())
+                    Logger::log_sync(Logger::Level::Warn,"Profiler",std::to_string(dropped.load())+" trace events dropped");
+                if (rate_capped.load())
+                    Logger::log_sync(Logger::Level::Warn,"Profiler",std::to_string(rate_capped.load())+" trace events over the rate cap");
+                flush_cv.notify_one();
                 if (flusher_thread.joinable())
                     flusher_thread.join();
 
-                dump_to_csv();
-                log_file.close();
+                dump_events(true);
+                trace_file->close();
             }
         };
     };
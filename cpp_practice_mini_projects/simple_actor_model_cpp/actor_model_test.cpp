@@ -8,7 +8,7 @@ using Job = std::function<void()> ;
 void pingpong(std::string& sender, std::string& receiver,int itr)
 {
     //std::cout << "Ping: " <<itr << std::endl;
-    ActorModel::Logger::log(ActorModel::Logger::Level::Info,receiver, "Ping!");
+    ACTOR_LOG_INFO(receiver, "Ping!");
     //std::cout <<sender.get() << " -> " << receiver.get()<<std::endl;
     Job getack = [](){std::cout << "Pong" << std::endl; };
     //if (itr%20 == 0)
@@ -58,6 +58,215 @@ void testMultipleActors()
     //std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 }
 
+// Many threads spawning and stopping actors on the same system, slots must get recycled and never double booked.
+// A respawn reuses the slot's stopped actor, it has to come back as a fresh one. The rate is measured in actor_model_bench
+void testSpawnStopStress()
+{
+    size_t num_threads = 4;
+    size_t max_actors = 64;
+    size_t cycles_per_thread = 500;
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(max_actors);
+    std::atomic<size_t> spawned{0};
+    std::atomic<size_t> stopped{0};
+    std::vector<std::thread> spawners;
+
+    for (size_t t=0;t<num_threads;t++)
+    {
+        spawners.emplace_back([&,t](){
+            // each thread cycles over a few names, so names (and slots) get reused all the time
+            std::vector<std::string> names;
+            for (size_t k=0;k<8;k++)
+                names.push_back("stress"+to_string(t)+"_"+to_string(k));
+
+            for (size_t i=0;i<cycles_per_thread;i++)
+            {
+                ActorHandle handle = ActorAdmin->spawn(2,names[i%names.size()]);
+                if (handle.name == "")
+                    continue;
+                spawned.fetch_add(1,std::memory_order_relaxed);
+                if (ActorAdmin->stop(handle))
+                    stopped.fetch_add(1,std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for(auto& spawner: spawners)
+        spawner.join();
+
+    // every slot is free again, and the reused actors take msgs with a fresh mailbox policy and counters
+    std::atomic<size_t> executed{0};
+    size_t respawned = 0;
+    for (size_t i=0;i<max_actors;i++)
+    {
+        ActorHandle handle = ActorAdmin->spawn(4,"respawned"+to_string(i));
+        if (handle.name == "")
+            continue;
+        respawned++;
+        while (!ActorAdmin->send(handle.name,[&executed](){ executed.fetch_add(1,std::memory_order_relaxed); }))
+            std::this_thread::yield();
+    }
+    while (executed.load() < respawned)
+        std::this_thread::yield();
+    size_t fresh = 0;
+    for (const ActorMetrics& metrics: ActorAdmin->metricsSnapshot())
+        fresh += (metrics.enqueued_total == 1) && (metrics.failures == 0) && (metrics.mailbox_capacity == 4);
+
+    std::cout << "Spawn/stop threads: " << num_threads << " Spawned: " << spawned.load() << " Stopped: " << stopped.load()
+              << "\nRespawned afterwards: " << respawned << "/" << max_actors << ", fresh: " << fresh
+              << ", executed: " << executed.load() << std::endl;
+}
+
+// Counters shared by all relay tokens of one run
+struct RelayCounters
+{
+    std::atomic<size_t> hops{0};
+    std::atomic<size_t> finished{0};
+    std::atomic<size_t> dropped{0};
+};
+
+// A token hopping from actor to actor (picked by a cheap xorshift) until its hop budget runs out
+void relay(ActorSystem<Job>* system, std::vector<std::string>* names, size_t self, size_t hops_left,
+            uint32_t rng, RelayCounters* counters)
+{
+    counters->hops.fetch_add(1,std::memory_order_relaxed);
+    if (!hops_left)
+    {
+        counters->finished.fetch_add(1,std::memory_order_relaxed);
+        return;
+    }
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    size_t next = rng % names->size();
+    if (!system->send((*names)[self],(*names)[next],
+                    constructTask<Job>(relay,system,names,next,hops_left-1,rng,counters),false))
+    {
+        counters->dropped.fetch_add(1,std::memory_order_relaxed);
+        counters->finished.fetch_add(1,std::memory_order_relaxed);
+    }
+}
+
+// Msgs per second between actors, shared threadpool (num_shards = 0) vs sharded dispatchers
+void testShardedThroughput(size_t num_shards)
+{
+    size_t num_actors = 64;
+    size_t num_tokens = 64;
+    size_t hops_per_token = 5000;
+    RelayCounters counters;
+    std::vector<std::string> names;
+
+    {
+        std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(num_actors,num_shards);
+        for (size_t i=0;i<num_actors;i++)
+        {
+            names.push_back("relay"+to_string(i));
+            ActorAdmin->spawn(256,names.back());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t=0;t<num_tokens;t++)
+        {
+            size_t first = t % num_actors;
+            ActorAdmin->send(names[first],constructTask<Job>(relay,ActorAdmin.get(),&names,first,hops_per_token,
+                            static_cast<uint32_t>(t+1),&counters));
+        }
+
+        auto deadline = start + std::chrono::seconds(30);
+        while ((counters.finished.load(std::memory_order_relaxed) < num_tokens) && (std::chrono::steady_clock::now() < deadline))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        auto end = std::chrono::steady_clock::now();
+        double time_taken = std::chrono::duration<double>(end-start).count();
+
+        std::cout << (num_shards ? ("Shards: " + to_string(num_shards)) : std::string("Shared threadpool"))
+                  << "\nHops: " << counters.hops.load() << " Dropped tokens: " << counters.dropped.load()
+                  << "\nTime taken: " << time_taken*1000 << "ms\nMsgs per second: " << (counters.hops.load()/time_taken) << std::endl;
+    }
+}
+
+// Burst of msgs into a small mailbox of a slow actor, once per overflow policy
+void testOverflowPolicies()
+{
+    std::vector<std::pair<std::string,MailboxPolicy>> policies = {
+        {"FAIL", MailboxPolicy(OverflowPolicy::FAIL)},
+        {"BLOCK", MailboxPolicy(OverflowPolicy::BLOCK,std::chrono::microseconds(2000))},
+        {"DROP_NEWEST", MailboxPolicy(OverflowPolicy::DROP_NEWEST)},
+        {"DROP_OLDEST", MailboxPolicy(OverflowPolicy::DROP_OLDEST)},
+        {"DEAD_LETTER", MailboxPolicy(OverflowPolicy::DEAD_LETTER)}
+    };
+    size_t burst = 64;
+
+    for (auto& [policy_name,policy]: policies)
+    {
+        std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(2);
+        ActorHandle slow = ActorAdmin->spawn(4,"slow");
+        ActorHandle dead_letters = ActorAdmin->spawn(128,"deadLetters");
+        policy.dead_letter_id = dead_letters.idx;
+        ActorAdmin->setMailboxPolicy(slow,policy);
+
+        std::atomic<size_t> executed{0};
+        size_t accepted = 0;
+        size_t slow_down_signals = 0;
+        size_t stop_signals = 0;
+
+        for (size_t i=0;i<burst;i++)
+        {
+            FlowSignal signal = ActorAdmin->flowSignal(slow);
+            slow_down_signals += (signal == FlowSignal::SLOW_DOWN);
+            stop_signals += (signal == FlowSignal::STOP);
+
+            accepted += ActorAdmin->send(slow.name,[&executed](){
+                            std::this_thread::sleep_for(std::chrono::microseconds(200));
+                            executed.fetch_add(1,std::memory_order_relaxed); });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::cout << "Policy " << policy_name << ": sent " << burst << " accepted " << accepted
+                  << " executed " << executed.load() << " (SLOW_DOWN seen " << slow_down_signals
+                  << ", STOP seen " << stop_signals << ")" << std::endl;
+    }
+}
+
+// Same burst, but sent from an actor on another shard, so the msgs arrive through a shard channel.
+// A refusal must end the same way as for a direct send: FAIL and DROP_NEWEST refuse the send itself (accepted == executed),
+// BLOCK drops only after its timeout, and those drops after the sender got true are counted
+void testCrossShardOverflow()
+{
+    std::vector<std::pair<std::string,MailboxPolicy>> policies = {
+        {"FAIL", MailboxPolicy(OverflowPolicy::FAIL)},
+        {"DROP_NEWEST", MailboxPolicy(OverflowPolicy::DROP_NEWEST)},
+        {"BLOCK 0us", MailboxPolicy(OverflowPolicy::BLOCK,std::chrono::microseconds(0))},
+        {"BLOCK 50ms", MailboxPolicy(OverflowPolicy::BLOCK,std::chrono::milliseconds(50))}
+    };
+    size_t burst = 64;
+
+    for (auto& [policy_name,policy]: policies)
+    {
+        std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(2,2);
+        ActorHandle sender = ActorAdmin->spawn(4,"sender");     // shard 0
+        ActorHandle slow = ActorAdmin->spawn(4,"slow");         // shard 1
+        ActorAdmin->setMailboxPolicy(slow,policy);
+
+        std::atomic<size_t> executed{0};
+        std::atomic<size_t> accepted{0};
+        ActorSystem<Job>* system = ActorAdmin.get();
+        ActorAdmin->send(sender.name,[system,&executed,&accepted,burst](){
+            std::string from = "sender";
+            for (size_t i=0;i<burst;i++)
+                accepted += system->send("slow",Message<Job>{[&executed](){
+                                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                                executed.fetch_add(1,std::memory_order_relaxed); },from,false});
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        uint64_t dropped_after_accept = 0;
+        for (const ActorMetrics& metrics: ActorAdmin->metricsSnapshot())
+            if (metrics.name == "slow")
+                dropped_after_accept = metrics.dropped_after_accept;
+        std::cout << "Cross shard " << policy_name << ": sent " << burst << " accepted " << accepted.load()
+                  << " executed " << executed.load() << " dropped after accept " << dropped_after_accept << std::endl;
+    }
+}
+
 /*
 void testActorSystem()
 {
@@ -103,11 +312,229 @@ void testActorSystem()
 */
 
 
+void testRestartStorm()
+{
+    size_t num_actors = 16;
+    size_t failures_per_actor = 2000;
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(num_actors);
+    std::vector<ActorHandle> handles;
+    for (size_t i=0;i<num_actors;i++)
+        handles.push_back(ActorAdmin->spawn(16,"crashy" + to_string(i)));
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round=0;round<failures_per_actor;round++)
+    {
+        for (auto& handle: handles)
+        {
+            // send() fails while the actor is down, which is exactly the window being measured
+            while (!ActorAdmin->send(handle.name,[](){ throw std::runtime_error("crash"); }))
+                std::this_thread::yield();
+        }
+    }
+    size_t expected = num_actors*failures_per_actor;
+    while (ActorAdmin->restartStats().restarts < expected)
+        std::this_thread::yield();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RestartStats stats = ActorAdmin->restartStats();
+    std::cout << "Restart storm: " << stats.restarts << " restarts in " << elapsed << "s, " 
+              << static_cast<size_t>(stats.restarts/elapsed) << " restarts/s, avg latency "
+              << (stats.total_latency_ns/stats.restarts)/1000.0 << "us, max latency " 
+              << stats.max_latency_ns/1000.0 << "us" << std::endl;
+}
+
+// stop() racing with restarts of the same actor: the restart must neither revive it nor touch it once it is freed
+void testStopDuringRestart()
+{
+    size_t rounds = 300;
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(4);
+    size_t stopped = 0;
+    for (size_t round=0;round<rounds;round++)
+    {
+        ActorHandle handle = ActorAdmin->spawn(16,"doomed" + to_string(round));
+        for (size_t i=0;i<8;i++)
+            ActorAdmin->send(handle.name,[](){ throw std::runtime_error("crash"); });
+        if (round % 2)
+            std::this_thread::yield();
+        stopped += ActorAdmin->stop(handle);
+        // slot must be free again, not held by a revived actor
+        if (ActorAdmin->isCurrentHandle(handle))
+            std::cout << "Stop during restart: " << handle.name << " still registered after stop" << std::endl;
+    }
+    std::cout << "Stop during restart: " << stopped << "/" << rounds << " stopped, "
+              << ActorAdmin->restartStats().restarts << " restarts raced with them" << std::endl;
+}
+
+void testSupervisionTree()
+{
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(8);
+    ActorHandle supervisor = ActorAdmin->spawn(16,"supervisor");
+    ActorAdmin->setSupervisorSpec(supervisor,SupervisorSpec(SupervisionStrategy::ONE_FOR_ALL,2,std::chrono::milliseconds(1000)));
+    std::vector<ActorHandle> children;
+    for (size_t i=0;i<3;i++)
+        children.push_back(ActorAdmin->spawnChild(supervisor,16,"child" + to_string(i)));
+
+    auto printGenerations = [&](const std::string& when){
+        std::cout << when << ": supervisor gen " << ActorAdmin->generation(supervisor) << ", children gen";
+        for (auto& child: children)
+            std::cout << " " << ActorAdmin->generation(child);
+        std::cout << std::endl;
+    };
+    auto crash = [&](const ActorHandle& handle, size_t restarts_after){
+        while (!ActorAdmin->send(handle.name,[](){ throw std::runtime_error("crash"); }))
+            std::this_thread::yield();
+        while (ActorAdmin->restartStats().restarts < restarts_after)
+            std::this_thread::yield();
+    };
+
+    printGenerations("Supervision tree start");
+    // ONE_FOR_ALL: all 3 children restart
+    crash(children[1],3);
+    printGenerations("child1 failed (ONE_FOR_ALL)");
+    crash(children[2],6);
+    printGenerations("child2 failed (ONE_FOR_ALL)");
+    // 3rd failure within the window exceeds max_restarts=2, supervisor fails and root restarts it with its children
+    crash(children[0],10);
+    printGenerations("child0 failed, escalated");
+}
+
+// every child of a ONE_FOR_ALL supervisor fails at once: the restarts pile up on the same slots
+// and must collapse, and every child has to come back (none left suspended or failed)
+void testSupervisionStorm()
+{
+    size_t num_children = 32;
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(num_children + 1);
+    ActorHandle supervisor = ActorAdmin->spawn(16,"storm_supervisor");
+    ActorAdmin->setSupervisorSpec(supervisor,SupervisorSpec(SupervisionStrategy::ONE_FOR_ALL,1000000,std::chrono::milliseconds(1000)));
+    std::vector<ActorHandle> children;
+    for (size_t i=0;i<num_children;i++)
+        children.push_back(ActorAdmin->spawnChild(supervisor,16,"storm_child" + to_string(i)));
+
+    for (auto& child: children)
+        ActorAdmin->send(child.name,[](){ throw std::runtime_error("crash"); });
+
+    std::atomic<size_t> alive{0};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (auto& child: children)
+    {
+        while (!ActorAdmin->send(child.name,[&alive](){ alive.fetch_add(1,std::memory_order_relaxed); }) &&
+               std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+    }
+    while (alive.load(std::memory_order_relaxed) < num_children && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+    std::cout << "Supervision storm: " << alive.load() << "/" << num_children << " children back after "
+              << ActorAdmin->restartStats().restarts << " restarts" << std::endl;
+}
+
+void testHybridDispatch()
+{
+    size_t num_actors = 16;
+    size_t msgs = 200000;
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(num_actors);
+    // frame ingest style hot actor on its own thread, the rest share the pool
+    ActorHandle hot = ActorAdmin->spawn(1024,"hot",DispatchPolicy(DispatchMode::DEDICATED,std::chrono::microseconds(20)));
+    std::vector<ActorHandle> cold;
+    for (size_t i=1;i<num_actors;i++)
+        cold.push_back(ActorAdmin->spawn(64,"cold" + to_string(i)));
+
+    std::atomic<size_t> hot_executed{0};
+    std::atomic<size_t> cold_executed{0};
+    size_t hot_sent = 0;
+    size_t cold_sent = 0;
+    size_t migrations = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0;i<msgs;i++)
+    {
+        // keep moving the hot actor between its own thread and the pool while msgs are flowing
+        if (i % 20000 == 10000)
+        {
+            DispatchMode next = (ActorAdmin->dispatchMode(hot) == DispatchMode::DEDICATED) ? DispatchMode::POOL : DispatchMode::DEDICATED;
+            migrations += ActorAdmin->setDispatchPolicy(hot,DispatchPolicy(next));
+        }
+        if (i % 8)
+        {
+            while (!ActorAdmin->send(hot.name,[&hot_executed](){ hot_executed.fetch_add(1,std::memory_order_relaxed); }))
+                std::this_thread::yield();
+            hot_sent++;
+        }
+        else
+        {
+            while (!ActorAdmin->send(cold[i % cold.size()].name,[&cold_executed](){ cold_executed.fetch_add(1,std::memory_order_relaxed); }))
+                std::this_thread::yield();
+            cold_sent++;
+        }
+    }
+    while ((hot_executed.load() < hot_sent) || (cold_executed.load() < cold_sent))
+        std::this_thread::yield();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Hybrid dispatch: hot sent " << hot_sent << " executed " << hot_executed.load() << ", cold sent " << cold_sent
+              << " executed " << cold_executed.load() << ", " << migrations << " migrations, "
+              << static_cast<size_t>(msgs/elapsed) << " msgs/s" << std::endl;
+}
+
+void testMetrics()
+{
+    std::shared_ptr<ActorSystem<Job>> ActorAdmin = std::make_shared<ActorSystem<Job>>(4);
+    ActorHandle fast = ActorAdmin->spawn(256,"fast");
+    ActorHandle slow = ActorAdmin->spawn(256,"slow");
+    ActorHandle crashy = ActorAdmin->spawn(16,"crashy");
+    ActorAdmin->startMetricsDump("log/actor_metrics.prom",std::chrono::milliseconds(20));
+
+    size_t msgs = 200;
+    std::atomic<size_t> executed{0};
+    for (size_t i=0;i<msgs;i++)
+    {
+        while (!ActorAdmin->send(fast.name,[&executed](){ executed.fetch_add(1,std::memory_order_relaxed); }))
+            std::this_thread::yield();
+        while (!ActorAdmin->send(slow.name,[&executed](){
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    executed.fetch_add(1,std::memory_order_relaxed); }))
+            std::this_thread::yield();
+    }
+    for (size_t i=0;i<3;i++)
+    {
+        while (!ActorAdmin->send(crashy.name,[](){ throw std::runtime_error("crash"); }))
+            std::this_thread::yield();
+        while (ActorAdmin->restartStats().restarts <= i)
+            std::this_thread::yield();
+    }
+    while (executed.load() < 2*msgs)
+        std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for (const ActorMetrics& metrics: ActorAdmin->metricsSnapshot())
+        std::cout << "Metrics " << metrics.name << ": depth " << metrics.mailbox_depth << "/" << metrics.mailbox_capacity
+                  << ", in " << metrics.enqueued_total << " out " << metrics.dequeued_total << ", " << metrics.drains
+                  << " drains, service " << metrics.avgServiceNs()/1000.0 << "us, max drain " << metrics.max_drain_ns/1000.0
+                  << "us, " << metrics.failures << " failures" << std::endl;
+
+    std::ifstream dump("log/actor_metrics.prom");
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(dump,line))
+        lines++;
+    std::cout << "Metrics dump: " << lines << " lines in log/actor_metrics.prom" << std::endl;
+}
+
 int main()
 {
     //std::cout << std::thread::hardware_concurrency() << std::endl;
     //testPingpong();
     testMultipleActors();
+    testSpawnStopStress();
+    testOverflowPolicies();
+    testCrossShardOverflow();
+    testRestartStorm();
+    testStopDuringRestart();
+    testSupervisionTree();
+    testSupervisionStorm();
+    testHybridDispatch();
+    testMetrics();
+    for (size_t num_shards: {0,1,4,16})
+        testShardedThroughput(num_shards);
     //testActorSystem();
     return 0;
 }
\ No newline at end of file
@@ -8,9 +8,17 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <shared_mutex>
 #include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <pthread.h>
 #include "../simple_mpmc_queue/mpmc_queue_bounded.h"
+#include "../simple_lock_free_queue/lock_free_queue.h"
 #include "../simple_ThreadPool/simple_thread_pool.h"
 #include "actor_model_logger_tracer.h"
 
@@ -20,6 +28,7 @@ using namespace ActorModel::Logger;
 using pprof = ActorModel::Profile::Profiler ;
 
 #define NUM_WORKER_THREADS 10
+#define SHARD_CHANNEL_SIZE 256  // capacity of each cross-shard spsc channel
 
 template <typename Task> class Actor;
 template <typename Task> class ActorSystem;
@@ -42,6 +51,105 @@ enum class RecoveryMechanism : size_t {
     MAX_MECHANISM
 };
 
+// How a supervisor reacts when one of its children fails (same idea as Erlang/OTP supervisors)
+enum class SupervisionStrategy : size_t {
+    ONE_FOR_ONE,    // restart only the failed child
+    ONE_FOR_ALL,    // restart all children of the supervisor
+    REST_FOR_ONE,   // restart the failed child and the children spawned after it
+    MAX_STRATEGY
+};
+
+// Restart intensity: more than max_restarts within window means the failure is escalated to the supervisor's own supervisor
+// (or the actor is stopped for good, at top level). max_restarts = 0 means unlimited
+struct SupervisorSpec
+{
+    SupervisionStrategy strategy;
+    size_t max_restarts;
+    std::chrono::milliseconds window;
+
+    SupervisorSpec(SupervisionStrategy strategy_ = SupervisionStrategy::ONE_FOR_ONE, size_t max_restarts_ = 0,
+                std::chrono::milliseconds window_ = std::chrono::milliseconds(1000)):
+                strategy(strategy_), max_restarts(max_restarts_), window(window_) {}
+};
+
+struct RestartStats
+{
+    uint64_t restarts;
+    uint64_t total_latency_ns;  // failure -> actor accepting msgs again
+    uint64_t max_latency_ns;
+};
+
+// What an actor does with a new msg when its mailbox is full
+enum class OverflowPolicy : size_t {
+    FAIL,           // sender gets false (old behaviour)
+    BLOCK,          // sender waits for room, up to block_timeout
+    DROP_NEWEST,    // incoming msg is dropped
+    DROP_OLDEST,    // oldest msg in the mailbox is dropped to make room
+    DEAD_LETTER,    // incoming msg is redirected to the dead letter actor
+    MAX_POLICY
+};
+
+// Backpressure hint a sender can poll before sending
+enum class FlowSignal : size_t {
+    GO,
+    SLOW_DOWN,  // msgs coming in faster than the actor gets through them, and backlog is building up
+    STOP        // mailbox (nearly) full
+};
+
+// Who runs an actor's drains
+enum class DispatchMode : size_t {
+    POOL,       // shared worker pool (or the actor's shard, in sharded mode)
+    DEDICATED,  // own thread, for latency critical actors
+    MAX_MODE
+};
+
+struct DispatchPolicy
+{
+    DispatchMode mode;
+    std::chrono::microseconds spin;     // DEDICATED only: busy poll this long before going to sleep, 0 sleeps right away
+    int pin_core;                       // DEDICATED only: core to pin the thread to, -1 leaves it to the OS
+
+    DispatchPolicy(DispatchMode mode_ = DispatchMode::POOL, std::chrono::microseconds spin_ = std::chrono::microseconds(0),
+                int pin_core_ = -1): mode(mode_), spin(spin_), pin_core(pin_core_) {}
+};
+
+// Live view of one actor, see ActorSystem::metricsSnapshot(). Totals survive in place restarts of the actor
+struct ActorMetrics
+{
+    size_t id;
+    std::string name;
+    uint64_t gen_id;
+    uint64_t mailbox_depth;     // enqueued - dequeued, can be off by a msg or two while senders are active
+    size_t mailbox_capacity;
+    uint64_t enqueued_total;
+    uint64_t dequeued_total;
+    uint64_t in_rate;           // msgs/sec, sampled at the end of each drain
+    uint64_t out_rate;
+    uint64_t drains;
+    uint64_t drained_msgs;      // msgs handled inside drains, what the service time is averaged over
+    uint64_t busy_ns;           // total time spent draining
+    uint64_t max_drain_ns;
+    uint64_t failures;
+    uint64_t dropped_after_accept;  // cross shard msgs the sender got true for, dropped on our shard (BLOCK timeout, dead letter full)
+    DispatchMode dispatch_mode;
+
+    double avgServiceNs() const
+    {
+        return drained_msgs ? static_cast<double>(busy_ns)/drained_msgs : 0.0;
+    }
+};
+
+struct MailboxPolicy
+{
+    OverflowPolicy on_full;
+    std::chrono::microseconds block_timeout;    // used only by BLOCK
+    size_t dead_letter_id;                      // used only by DEAD_LETTER, slot idx of the dead letter actor
+
+    MailboxPolicy(OverflowPolicy policy = OverflowPolicy::FAIL,
+                std::chrono::microseconds timeout = std::chrono::microseconds(0), size_t dead_letter = 0):
+                on_full(policy), block_timeout(timeout), dead_letter_id(dead_letter) {}
+};
+
 struct ActorHandle
 {
     size_t idx;
@@ -55,6 +163,7 @@ struct ActorParameters
     size_t mailbox_size;
     size_t idx;
     std::string name;
+    MailboxPolicy mailbox_policy;
 
     ActorParameters(){}
 
@@ -85,6 +194,7 @@ struct Message {
     std::string sender_name;
     bool request_reply;
     std::chrono::time_point<std::chrono::steady_clock> timestamp;
+    uint32_t trace_seq = 0;     // per receiver, only set while tracing. Pairs the Enqueue/Dequeue trace events of this msg
 
     Message(){}
 
@@ -107,17 +217,186 @@ struct Message {
     
 };
 
+/* Thread of a DEDICATED actor
+    - Gets a wakeup only when the actor's drain token was won (same as a pool task), so one flag is enough
+    - Sleeps on wake_seq with the same Dekker style handshake as the shard dispatchers
+    - Kept around after migrating back to POOL, a sender that just looked it up may still be calling wake() on it
+*/
+struct ActorDispatcher
+{
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> drain_requested;
+    alignas(64) std::atomic<uint32_t> wake_seq;
+    std::atomic<bool> sleeping;
+    DispatchPolicy policy;
+
+    ActorDispatcher(): running(false), drain_requested(false), wake_seq(0), sleeping(false) {}
+
+    void wake()
+    {
+        drain_requested.store(true,std::memory_order_seq_cst);
+        wake_seq.fetch_add(1,std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst))
+            wake_seq.notify_one();
+    }
+};
+
+#define NO_SUPERVISOR SIZE_MAX
+
 template <typename Task>
 struct ActorSlot
 {
     std::atomic<bool> is_valid;
     std::atomic<uint64_t> gen_id;
     std::unique_ptr<Actor<Task>> actor;
+    // Last stopped actor of this slot and its registry entry, the next spawn() reuses both (mailbox included)
+    // instead of allocating. Only touched under the registry write lock
+    std::unique_ptr<Actor<Task>> retired;
+    std::unordered_map<std::string,size_t>::node_type registry_node;
+
+    // supervision tree, kept in the slots so the failure path can walk it without any lock
+    std::atomic<size_t> parent_id;          // slot idx of the supervisor, NO_SUPERVISOR for top level actors
+    std::atomic<uint64_t> start_order;      // spawn order, REST_FOR_ONE restarts the siblings started after the failed one
+    std::atomic<SupervisionStrategy> child_strategy;    // spec applied to this actor's children
+    std::atomic<size_t> max_child_restarts;
+    std::atomic<int64_t> restart_window_ms;
+    std::atomic<int64_t> window_start_ns;   // restart intensity bookkeeping of this supervisor
+    std::atomic<size_t> restarts_in_window;
+    std::atomic<int64_t> failed_at_ns;      // when the failure being recovered happened, 0 if none pending
+
+    std::atomic<DispatchMode> dispatch_mode;
+    std::unique_ptr<ActorDispatcher> dedicated;     // created on first switch to DEDICATED, lives as long as the slot
+
+    std::atomic<uint32_t> pins;     // SlotPins currently using actor, unregisterActor() waits for them before destroying it
+
+    // cross shard msgs accepted for this slot and still in a shard channel or backlog, see ActorSystem::sendCrossShard().
+    // Kept in the slot, the delivery may find the actor already gone
+    std::atomic<uint64_t> in_transit;
+
+    // supervision work waiting for this actor, see ActorSystem::requestSupervision()
+    std::atomic<uint32_t> supervision;      // SUPERVISE_* bits
+    std::atomic<uint64_t> supervision_gen;  // gen_id the requests were made for
+
+    ActorSlot(): is_valid{false}, gen_id{0}, actor(nullptr), parent_id{NO_SUPERVISOR}, start_order{0},
+                child_strategy{SupervisionStrategy::ONE_FOR_ONE}, max_child_restarts{0}, restart_window_ms{1000},
+                window_start_ns{0}, restarts_in_window{0}, failed_at_ns{0}, dispatch_mode{DispatchMode::POOL}, pins{0},
+                in_transit{0}, supervision{0}, supervision_gen{0} {}
+
+};
+
+/* Keeps the actor of a slot alive for code that reaches it without the registry lock:
+    drains on the pool/shards/dedicated threads, supervision and restart tasks, shard channel delivery
+    - Empty if the slot holds no registered actor (anymore). Never hold one across unregisterActor(), it waits for the pins
+    - Same Dekker style handshake as the dispatcher sleep: pin bumps pins then reads is_valid, unregisterActor() clears
+      is_valid then reads pins, all seq_cst. Either the pin sees the actor going and backs off, or the teardown sees the pin
+*/
+template <typename Task>
+class SlotPin
+{
+private:
+    ActorSlot<Task>* slot_;
+    Actor<Task>* actor_;
+
+public:
+    explicit SlotPin(ActorSlot<Task>& slot): slot_(&slot), actor_(nullptr)
+    {
+        slot_->pins.fetch_add(1,std::memory_order_seq_cst);
+        if (slot_->is_valid.load(std::memory_order_seq_cst))
+            actor_ = slot_->actor.get();
+    }
+
+    ~SlotPin()
+    {
+        release();
+    }
+
+    SlotPin(const SlotPin&) = delete;
+    SlotPin& operator=(const SlotPin&) = delete;
+
+    // Unpin early, before doing something that may wait for this slot's teardown
+    void release()
+    {
+        if (!slot_)
+            return;
+        actor_ = nullptr;
+        slot_->pins.fetch_sub(1,std::memory_order_release);
+        slot_ = nullptr;
+    }
+
+    Actor<Task>* get() const { return actor_; }
+    Actor<Task>* operator->() const { return actor_; }
+    explicit operator bool() const { return actor_ != nullptr; }
+};
+
+/* Lock-free stack of slot indices (a Treiber stack, but over slot indices instead of heap nodes).
+    Holds the free slots, and the slots waiting for supervision. An idx must not be pushed while it is still on the stack
+    - head_ packs {tag (upper 32 bits) | top idx (lower 32 bits)}, next_[i] holds the idx below slot i
+    - Every successful CAS bumps the tag. Without it, a pop that read head=A and next=B could get preempted,
+      while other threads pop A, pop B, push A back. head is again A, so the stale CAS would succeed and
+      install B as top even though B is in use (ABA). With the tag, head is now {tag+3, A} and the CAS fails.
+    - Nodes are never freed (next_ is a fixed array), so reading next_[top] of an already popped slot is safe,
+      we only might read a stale value, which the tag check then rejects.
+*/
+class SlotStack
+{
+private:
+    static constexpr uint32_t EMPTY_IDX = UINT32_MAX;
+    alignas(64) std::atomic<uint64_t> head_;
+    std::vector<std::atomic<uint32_t>> next_;
+
+    static uint64_t pack(uint32_t tag, uint32_t idx) { return (static_cast<uint64_t>(tag) << 32) | idx; }
+    static uint32_t tagOf(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+    static uint32_t idxOf(uint64_t head) { return static_cast<uint32_t>(head); }
 
+public:
+    // all_free: start with every idx on the stack, else empty
+    explicit SlotStack(size_t capacity, bool all_free = true): head_(pack(0,EMPTY_IDX)), next_(capacity)
+    {
+        // push in reverse, so that first spawns get slot 0,1,2... like the old bump pointer did
+        for (size_t i=capacity; all_free && (i>0); i--)
+            push(i-1);
+    }
+
+    SlotStack(const SlotStack&) = delete;
+    SlotStack& operator=(const SlotStack&) = delete;
+
+    bool empty() const
+    {
+        return idxOf(head_.load(std::memory_order_acquire)) == EMPTY_IDX;
+    }
+
+    // Reserve a free slot, returns false if all slots are taken
+    bool pop(size_t& idx)
+    {
+        // acquire pairs with release in push(), so whoever released the slot has finished tearing it down
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while(1)
+        {
+            uint32_t top = idxOf(head);
+            if (top == EMPTY_IDX)
+                return false;
 
-    ActorSlot(): is_valid{false}, actor(nullptr){}
-    ActorSlot(std::unique_ptr<Actor<Task>> &&actor_): is_valid{true}, gen_id{0},actor(std::move(actor_)) {}
+            uint32_t below = next_[top].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, pack(tagOf(head)+1, below),
+                                            std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                idx = top;
+                return true;
+            }
+            // CAS failure reloaded head for us, just retry
+        }
+    }
 
+    // Hand a slot back for reuse
+    void push(size_t idx)
+    {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        do{
+            next_[idx].store(idxOf(head), std::memory_order_relaxed);
+        } while(!head_.compare_exchange_weak(head, pack(tagOf(head)+1, static_cast<uint32_t>(idx)),
+                                            std::memory_order_release, std::memory_order_relaxed));
+    }
 };
 
 template <typename Task>
@@ -126,11 +405,155 @@ class Actor
 private:
     std::unique_ptr<mpmcQueueBounded<Message<Task>>> mailbox_q;  //Actor mailbox, using lock-free mpmc queue (only one consumer being self)
     size_t mailbox_size_;
-    std::atomic<size_t> mailbox_count_;
     std::atomic<bool> actor_alive_; // flag to track if actor is alive to receive msgs
+    std::atomic<bool> stop_requested_;  // set once by stopActor(), a restart racing with the stop must not revive us
     std::weak_ptr<ActorSystem<Task>> owning_system_;
+    // Used for all calls into the system from our drains. The system owns us and stops all its threads before
+    // destroying us, so it always outlives these calls. Locking owning_system_ there instead could make a worker
+    // the last owner, and then ~ActorSystem would run on (and try to join) that very worker
+    ActorSystem<Task>* system_ = nullptr;
     std::atomic<ActorState> actor_state_;  // Records current state of the actor
 
+    // Overflow policy, kept as separate atomics so it can be changed while senders are active
+    std::atomic<OverflowPolicy> overflow_policy_;
+    std::atomic<int64_t> block_timeout_us_;
+    std::atomic<size_t> dead_letter_id_;
+
+    // Flow control: running totals of msgs in/out, and rates sampled by the draining thread at the end of each drain
+    std::atomic<uint64_t> enqueued_total_;
+    std::atomic<uint64_t> dequeued_total_;
+    std::atomic<uint64_t> in_rate_;     // msgs/sec
+    std::atomic<uint64_t> out_rate_;    // msgs/sec
+    std::atomic<uint32_t> trace_seq_;   // next Message::trace_seq
+    uint64_t last_sample_enqueued_;
+    uint64_t last_sample_dequeued_;
+    std::chrono::steady_clock::time_point last_sample_time_;
+
+    // Drain metrics. Only the drain token holder writes these (plain load+store, no RMW on the hot path)
+    std::atomic<uint64_t> drains_;
+    std::atomic<uint64_t> drained_msgs_;
+    std::atomic<uint64_t> busy_ns_;
+    std::atomic<uint64_t> max_drain_ns_;
+    std::atomic<uint64_t> failures_;
+    std::atomic<uint64_t> dropped_after_accept_;    // written by our shard thread only
+
+    enum class OverflowOutcome { QUEUED, REDIRECTED, REJECTED };
+
+    // Schedule a drain of our mailbox, unless one is already pending
+    void requestDrain()
+    {
+        uint8_t token = DRAIN_FREE;
+        if (drain_token_.compare_exchange_strong(token,DRAIN_HELD,std::memory_order_acq_rel))
+            if (ActorSystem<Task>* actor_system = system_)
+                // no drain got queued (pool full or shutting down), do not sit on the token: stopActor() waits for it
+                if (!actor_system->notifyMailboxActive(id_))
+                    handBackDrain();
+    }
+
+    // Every holder of the drain token hands it back through here. A restart parked on the token meanwhile
+    // goes back to the supervisor now, once, however many times it was asked for
+    void handBackDrain()
+    {
+        uint8_t token = drain_token_.exchange(DRAIN_FREE,std::memory_order_acq_rel);
+        if (token >= DRAIN_RESUME_PARKED)
+            if (ActorSystem<Task>* actor_system = system_)
+                actor_system->requeueParkedRestart(id_,token == DRAIN_RESTART_PARKED);
+    }
+
+    // Mailbox was full for msg, apply our overflow policy. msg is only moved from if it got queued or redirected
+    OverflowOutcome handleOverflow(Message<Task>& msg, bool allow_redirect)
+    {
+        // whatever the policy, a full mailbox needs draining
+        requestDrain();
+
+        switch (overflow_policy_.load(std::memory_order_relaxed))
+        {
+            case OverflowPolicy::BLOCK:
+            {
+                // Never block the only thread that can drain us (our own shard dispatcher), it would just deadlock till timeout
+                ActorSystem<Task>* actor_system = system_;
+                if (actor_system && actor_system->maySenderBlock(id_))
+                {
+                    auto deadline = std::chrono::steady_clock::now() 
+                                    + std::chrono::microseconds(block_timeout_us_.load(std::memory_order_relaxed));
+                    size_t spins = 0;
+                    while (actor_alive_.load(std::memory_order_acquire) && (std::chrono::steady_clock::now() < deadline))
+                    {
+                        if (mailbox_q->try_push(std::move(msg)))
+                            return OverflowOutcome::QUEUED;
+                        // yield first, then back off to short sleeps, so blocked senders don't eat the drainer's cpu
+                        if (++spins < 64)
+                            std::this_thread::yield();
+                        else
+                            std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    }
+                }
+                pprof::instance().record(ActorModel::Profile::EventType::BlockTimeout,id_,gen_id_, 1234);
+                return OverflowOutcome::REJECTED;
+            }
+            case OverflowPolicy::DROP_NEWEST:
+                pprof::instance().record(ActorModel::Profile::EventType::DropNewest,id_,gen_id_, 1234);
+                return OverflowOutcome::REJECTED;
+
+            case OverflowPolicy::DROP_OLDEST:
+            {
+                // mailbox is mpmc, so a sender can pop from the front too, the drainer just never sees the dropped msg
+                Message<Task> oldest;
+                for (int attempt=0; attempt<4; attempt++)
+                {
+                    if (mailbox_q->try_pop(oldest))
+                    {
+                        dequeued_total_.fetch_add(1,std::memory_order_relaxed);
+                        pprof::instance().record(ActorModel::Profile::EventType::DropOldest,id_,gen_id_, oldest.trace_seq);
+                    }
+                    if (mailbox_q->try_push(std::move(msg)))
+                        return OverflowOutcome::QUEUED;
+                }
+                break;
+            }
+            case OverflowPolicy::DEAD_LETTER:
+            {
+                if (!allow_redirect)
+                    break;
+                if (ActorSystem<Task>* actor_system = system_)
+                    if (actor_system->sendDeadLetter(dead_letter_id_.load(std::memory_order_relaxed),std::move(msg)))
+                    {
+                        pprof::instance().record(ActorModel::Profile::EventType::DeadLetter,id_,gen_id_, 1234);
+                        return OverflowOutcome::REDIRECTED;
+                    }
+                break;
+            }
+            default:
+                break;
+        }
+        pprof::instance().record(ActorModel::Profile::EventType::Fail,id_,gen_id_, 1234);
+        return OverflowOutcome::REJECTED;
+    }
+
+    // Bookkeeping after msg made it into the mailbox
+    void onEnqueued(uint32_t trace_seq)
+    {
+        enqueued_total_.fetch_add(1,std::memory_order_relaxed);
+        pprof::instance().record(ActorModel::Profile::EventType::Enqueue,id_,gen_id_, trace_seq);
+        requestDrain();
+    }
+
+    // Called by the draining thread only, so the last_sample_* fields need no atomics
+    void sampleRates(std::chrono::steady_clock::time_point now)
+    {
+        double elapsed_sec = std::chrono::duration<double>(now - last_sample_time_).count();
+        if (elapsed_sec < 0.001)
+            return;
+
+        uint64_t enqueued = enqueued_total_.load(std::memory_order_relaxed);
+        uint64_t dequeued = dequeued_total_.load(std::memory_order_relaxed);
+        in_rate_.store(static_cast<uint64_t>((enqueued - last_sample_enqueued_)/elapsed_sec),std::memory_order_relaxed);
+        out_rate_.store(static_cast<uint64_t>((dequeued - last_sample_dequeued_)/elapsed_sec),std::memory_order_relaxed);
+        last_sample_enqueued_ = enqueued;
+        last_sample_dequeued_ = dequeued;
+        last_sample_time_ = now;
+    }
+
     // Invoke if sender requests a reply, so send a successful acknowledgement to sender mailbox
     /*
     void handleReply(const Message<Task>& msg, bool is_success=true)
@@ -148,23 +571,80 @@ public:
     size_t id_; // Keeping a actor id to identify an actor, will decide in future how to use this
     std::string name_; //Have an actor name, to get pretty logs!
     RecoveryMechanism recovery_strategy_;   // Add recovery strategy if actor stops
-    std::atomic<bool> is_draining_;
+    // Drain token: "somebody owns this mailbox right now" (a drain, a restart, stop, a dispatch mode switch).
+    // A restart that finds it taken is parked on it, the PARKED states are still HELD for everybody else
+    static constexpr uint8_t DRAIN_FREE = 0;
+    static constexpr uint8_t DRAIN_HELD = 1;
+    static constexpr uint8_t DRAIN_RESUME_PARKED = 2;     // restart keeping the generation waits for the token
+    static constexpr uint8_t DRAIN_RESTART_PARKED = 3;    // restart with a new generation waits, wins over a resume
+    std::atomic<uint8_t> drain_token_;
     std::atomic<uint64_t> gen_id_;
 
     explicit Actor(size_t mailbox_size, size_t id,std::string name="",uint64_t gen_id=0)
-        :mailbox_size_(mailbox_size),mailbox_count_(0),actor_alive_(true),actor_state_(ActorState::CREATED),
-        id_(id),name_(name),is_draining_(false), gen_id_(gen_id)
+        :mailbox_size_(mailbox_size),actor_alive_(true),stop_requested_(false),actor_state_(ActorState::CREATED),
+        overflow_policy_(OverflowPolicy::FAIL), block_timeout_us_(0), dead_letter_id_(0),
+        enqueued_total_(0), dequeued_total_(0), in_rate_(0), out_rate_(0), trace_seq_(0),
+        last_sample_enqueued_(0), last_sample_dequeued_(0), last_sample_time_(std::chrono::steady_clock::now()),
+        drains_(0), drained_msgs_(0), busy_ns_(0), max_drain_ns_(0), failures_(0), dropped_after_accept_(0),
+        id_(id),name_(name),drain_token_(DRAIN_FREE), gen_id_(gen_id)
     {
         recovery_strategy_ = RecoveryMechanism::RESTART;
         mailbox_q = std::make_unique<mpmcQueueBounded<Message<Task>>>(mailbox_size);
         actor_state_.store(ActorState::RUNNING,std::memory_order_release); 
     }
 
+    // Bring a retired (stopped and unregistered) actor back as a brand new one, see ActorSlot::retired.
+    // Same object and mailbox, unless the capacity changed, everything else as the constructor leaves it
+    void respawn(size_t mailbox_size, const std::string& name, uint64_t gen_id)
+    {
+        if (mailbox_size != mailbox_size_)
+        {
+            mailbox_q = std::make_unique<mpmcQueueBounded<Message<Task>>>(mailbox_size);
+            mailbox_size_ = mailbox_size;
+        }
+        // a sender that looked us up before the stop may still have pushed something
+        dropMailbox();
+
+        overflow_policy_.store(OverflowPolicy::FAIL,std::memory_order_relaxed);
+        block_timeout_us_.store(0,std::memory_order_relaxed);
+        dead_letter_id_.store(0,std::memory_order_relaxed);
+        enqueued_total_.store(0,std::memory_order_relaxed);
+        dequeued_total_.store(0,std::memory_order_relaxed);
+        in_rate_.store(0,std::memory_order_relaxed);
+        out_rate_.store(0,std::memory_order_relaxed);
+        trace_seq_.store(0,std::memory_order_relaxed);
+        last_sample_enqueued_ = 0;
+        last_sample_dequeued_ = 0;
+        last_sample_time_ = std::chrono::steady_clock::now();
+        drains_.store(0,std::memory_order_relaxed);
+        drained_msgs_.store(0,std::memory_order_relaxed);
+        busy_ns_.store(0,std::memory_order_relaxed);
+        max_drain_ns_.store(0,std::memory_order_relaxed);
+        failures_.store(0,std::memory_order_relaxed);
+        dropped_after_accept_.store(0,std::memory_order_relaxed);
+        name_ = name;
+        recovery_strategy_ = RecoveryMechanism::RESTART;
+        gen_id_.store(gen_id,std::memory_order_relaxed);
+
+        stop_requested_.store(false,std::memory_order_relaxed);
+        drain_token_.store(DRAIN_FREE,std::memory_order_relaxed);
+        actor_state_.store(ActorState::RUNNING,std::memory_order_release);
+        actor_alive_.store(true,std::memory_order_release);
+    }
+
+    // Destroy the msgs a stopped actor never got to
+    void dropMailbox()
+    {
+        Message<Task> msg;
+        while (mailbox_q->try_pop(msg)) {}
+    }
+
     // We want our actor to keep a reference to the owning actor system that spawned it, 
     //so that we can use it to communicate important info to the owning system later
     void setActorSystem(std::shared_ptr<ActorSystem<Task>> actor_system)
     {
         owning_system_ = std::weak_ptr<ActorSystem<Task>>(actor_system);
+        system_ = actor_system.get();
     }
 
     std::shared_ptr<ActorSystem<Task>> getActorSystem()
@@ -188,37 +668,106 @@ public:
         actor_parameters.mailbox_size = mailbox_size_;
         actor_parameters.idx = id_;
         actor_parameters.name = name_;
+        actor_parameters.mailbox_policy = getMailboxPolicy();
+    }
+
+    void setMailboxPolicy(const MailboxPolicy& policy)
+    {
+        block_timeout_us_.store(policy.block_timeout.count(),std::memory_order_relaxed);
+        dead_letter_id_.store(policy.dead_letter_id,std::memory_order_relaxed);
+        overflow_policy_.store(policy.on_full,std::memory_order_release);
+    }
+
+    MailboxPolicy getMailboxPolicy() const
+    {
+        return MailboxPolicy(overflow_policy_.load(std::memory_order_acquire),
+                            std::chrono::microseconds(block_timeout_us_.load(std::memory_order_relaxed)),
+                            dead_letter_id_.load(std::memory_order_relaxed));
+    }
+
+    // Both totals are bumped after the queue op, so the difference is only approximate while msgs are flowing
+    uint64_t mailboxDepth() const
+    {
+        uint64_t dequeued = dequeued_total_.load(std::memory_order_relaxed);
+        uint64_t enqueued = enqueued_total_.load(std::memory_order_relaxed);
+        return (enqueued > dequeued) ? (enqueued - dequeued) : 0;
+    }
+
+    FlowSignal flowSignal() const
+    {
+        uint64_t depth = mailboxDepth();
+        size_t capacity = mailbox_q->capacity();
+
+        if (depth*10 >= capacity*9)
+            return FlowSignal::STOP;
+        if ((in_rate_.load(std::memory_order_relaxed) > out_rate_.load(std::memory_order_relaxed)) && (depth*2 >= capacity))
+            return FlowSignal::SLOW_DOWN;
+        return FlowSignal::GO;
+    }
+
+    // Cross shard senders, our overflow policy only runs on our shard once the sender got its answer.
+    // FAIL and DROP_NEWEST must answer false though, so they are applied here: the msgs still on their way
+    // to us (in_transit, this one included) count against the mailbox as if they were in it already
+    bool admitsInTransit(uint64_t in_transit)
+    {
+        OverflowPolicy policy = overflow_policy_.load(std::memory_order_relaxed);
+        if (((policy != OverflowPolicy::FAIL) && (policy != OverflowPolicy::DROP_NEWEST))
+            || (mailboxDepth() + in_transit <= mailbox_q->capacity()))
+            return true;
+        pprof::instance().record((policy == OverflowPolicy::FAIL) ? ActorModel::Profile::EventType::Fail
+                                : ActorModel::Profile::EventType::DropNewest,id_,gen_id_, 1234);
+        return false;
+    }
+
+    // A msg the sender already got true for was dropped on delivery
+    void countDroppedAfterAccept()
+    {
+        dropped_after_accept_.store(dropped_after_accept_.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
     }
 
     // Push a task to this actor's mailbox
-    bool addToMailbox(Message<Task>&& msg)
+    // allow_redirect = false is used for msgs already redirected to a dead letter actor, so they can't bounce around forever
+    bool addToMailbox(Message<Task>&& msg, bool allow_redirect = true)
     {
         //size_t retry_loop=0;
         //once actor is stopped, but some thread keeps pushing successfully back to back, we won't enter while loop
         if (!actor_alive_.load(std::memory_order_acquire))
             return false;
 
+        if (pprof::instance().isTraceEnabled())
+            msg.trace_seq = trace_seq_.fetch_add(1,std::memory_order_relaxed);
+        uint32_t trace_seq = msg.trace_seq;
+
         if (!mailbox_q->try_push(std::move(msg)) )
         {
             //if ((++retry_loop > 10) )
             //std::this_thread::yield();
-            pprof::instance().record(ActorModel::Profile::EventType::Fail,id_,gen_id_, 1234);
-            
-            //try_push may fail due to mailbox full, trigger a drain in that case
-            bool expected_draining = false;
-            if (is_draining_.compare_exchange_strong(expected_draining,true,std::memory_order_acq_rel))
-                if (auto actor_system = owning_system_.lock())
-                    actor_system->notifyMailboxActive(id_);
-            return false;
-
+            //try_push may fail due to mailbox full, overflow policy decides what happens to msg
+            OverflowOutcome outcome = handleOverflow(msg,allow_redirect);
+            if (outcome != OverflowOutcome::QUEUED)
+                return (outcome == OverflowOutcome::REDIRECTED);
         }
-        pprof::instance().record(ActorModel::Profile::EventType::Enqueue,id_,gen_id_, 1234);
+        onEnqueued(trace_seq);
+        return true;
+    }
+
+    // addToMailbox() without the overflow policy: a full mailbox just gets a drain requested and msg is left untouched.
+    // For callers that wait for room themselves, e.g. a shard backlog holding msgs for a BLOCK receiver
+    bool tryAddToMailbox(Message<Task>& msg)
+    {
+        if (!actor_alive_.load(std::memory_order_acquire))
+            return false;
 
-        bool expected_draining = false;
-        if (is_draining_.compare_exchange_strong(expected_draining,true,std::memory_order_acq_rel))
-            if (auto actor_system = owning_system_.lock())
-                actor_system->notifyMailboxActive(id_);
+        if (pprof::instance().isTraceEnabled())
+            msg.trace_seq = trace_seq_.fetch_add(1,std::memory_order_relaxed);
+        uint32_t trace_seq = msg.trace_seq;
 
+        if (!mailbox_q->try_push(std::move(msg)))
+        {
+            requestDrain();
+            return false;
+        }
+        onEnqueued(trace_seq);
         return true;
     }
 
@@ -227,79 +776,204 @@ public:
     {
         if(actor_alive_.load(std::memory_order_acquire) )
         {
-            if (auto actor_system = owning_system_.lock())
+            if (ActorSystem<Task>* actor_system = system_)
                 return actor_system->send(receiver,Message<Task>{std::move(task),name_,needs_ack});
         }
         return false;
     }
 
-    void handleMsg(Message<Task>&& msg)
+    // Returns false if this msg made the actor fail
+    bool handleMsg(Message<Task>&& msg)
     {
         //std::cout << name_ << ": "; 
+        dequeued_total_.fetch_add(1,std::memory_order_relaxed);
         try
         {
-            pprof::instance().record(ActorModel::Profile::EventType::Dequeue,id_,gen_id_, 1234);
+            pprof::instance().record(ActorModel::Profile::EventType::Dequeue,id_,gen_id_, msg.trace_seq);
             msg.task();   // Execute task            
         }
         catch(const std::exception& e)
         {
+            //std::cout <<name_ << ": Exception caught while draining: " << e.what()<<  std::endl;
+            ACTOR_LOG_ERROR(name_, e.what());
+            failures_.store(failures_.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
             if (actor_alive_.exchange(false,std::memory_order_acq_rel) && 
                 (actor_state_.load(std::memory_order_acquire) != ActorState::FAILED))
             {
                 actor_state_.store(ActorState::FAILED,std::memory_order_release);
                 //if (actor_state_.compare_exchange_strong())
 
-                if(auto actor_system = owning_system_.lock())
-                {
-                    actor_system->notifyActorFailure(id_);
+                if(ActorSystem<Task>* actor_system = system_)
                     actor_system->logFailure(name_,std::move(msg));
-                }
+                return false;
             }
-            //std::cout <<name_ << ": Exception caught while draining: " << e.what()<<  std::endl;
-            Logger::log(Level::Error, name_, e.what());
-            return;
         }
+        return true;
         //if (msg.request_reply)
          //       handleReply(msg,true);
     }
 
+    // Supervisor restarts us only after claiming the drain token, so report the failure after the token is released,
+    // otherwise the restart mostly finds the token still taken and has to park on it
+    void reportFailure()
+    {
+        if(ActorSystem<Task>* actor_system = system_)
+            actor_system->notifyActorFailure(id_);
+    }
+
     // Once actor is stopped, flushes out mailbox
     void drainMailbox()
     {
         // Flush out all tasks remaining in the queue by executing them
         pprof::instance().record(ActorModel::Profile::EventType::DrainStart,id_,gen_id_, 1234);
+        auto drain_start = std::chrono::steady_clock::now();
         Message<Task> remaining_msg;
+        bool failed = false;
+        uint64_t handled = 0;
         while(actor_alive_.load(std::memory_order_acquire) && mailbox_q->try_pop(remaining_msg))
-            handleMsg(std::move(remaining_msg));
-
-        is_draining_.store(false,std::memory_order_release);
-
-        if ((actor_alive_.load(std::memory_order_acquire)) && mailbox_q->try_pop(remaining_msg))
         {
-            bool expected_draining = false;
-            if (is_draining_.compare_exchange_strong(expected_draining,true))
-                if (auto actor_system = owning_system_.lock())
-                    actor_system->notifyMailboxActive(id_);
-            handleMsg(std::move(remaining_msg));
+            failed |= !handleMsg(std::move(remaining_msg));
+            handled++;
         }
+
+        // sample while still holding the drain token, restartInPlace() resets the same fields under it
+        auto drain_end = std::chrono::steady_clock::now();
+        sampleRates(drain_end);
+        recordDrain(handled,static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(drain_end - drain_start).count()));
+        handBackDrain();
+
+        // A msg queued while we still held the token had its drain request refused, ask for it ourselves.
+        // Not by handling it right here: the drain we hand over to may already be running, and one actor
+        // must never run two msgs at once (two failures in one generation would get a single restart)
+        if (failed)
+            reportFailure();
+        else if ((actor_alive_.load(std::memory_order_acquire)) && !mailbox_q->empty())
+            requestDrain();
         pprof::instance().record(ActorModel::Profile::EventType::DrainEnd,id_,gen_id_, 1234);
 
         // Some msgs might get queued just before the exit, but for fairness I don't want to keep draining
         // So the new msgs will stay idle in the actor mailbox till they are picked up my a worker thread again
     }
 
+    // Drain token holder only
+    void recordDrain(uint64_t handled, uint64_t elapsed_ns)
+    {
+        drains_.store(drains_.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+        drained_msgs_.store(drained_msgs_.load(std::memory_order_relaxed) + handled,std::memory_order_relaxed);
+        busy_ns_.store(busy_ns_.load(std::memory_order_relaxed) + elapsed_ns,std::memory_order_relaxed);
+        if (elapsed_ns > max_drain_ns_.load(std::memory_order_relaxed))
+            max_drain_ns_.store(elapsed_ns,std::memory_order_relaxed);
+    }
+
+    // Relaxed reads of the live counters, each one is exact but they are not a consistent snapshot together
+    void fillMetrics(ActorMetrics& metrics) const
+    {
+        metrics.id = id_;
+        metrics.name = name_;
+        metrics.gen_id = gen_id_.load(std::memory_order_relaxed);
+        metrics.mailbox_depth = mailboxDepth();
+        metrics.mailbox_capacity = mailbox_q->capacity();
+        metrics.enqueued_total = enqueued_total_.load(std::memory_order_relaxed);
+        metrics.dequeued_total = dequeued_total_.load(std::memory_order_relaxed);
+        metrics.in_rate = in_rate_.load(std::memory_order_relaxed);
+        metrics.out_rate = out_rate_.load(std::memory_order_relaxed);
+        metrics.drains = drains_.load(std::memory_order_relaxed);
+        metrics.drained_msgs = drained_msgs_.load(std::memory_order_relaxed);
+        metrics.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+        metrics.max_drain_ns = max_drain_ns_.load(std::memory_order_relaxed);
+        metrics.failures = failures_.load(std::memory_order_relaxed);
+        metrics.dropped_after_accept = dropped_after_accept_.load(std::memory_order_relaxed);
+    }
+
+    bool tryClaimDrain()
+    {
+        uint8_t token = DRAIN_FREE;
+        return drain_token_.compare_exchange_strong(token,DRAIN_HELD,std::memory_order_acq_rel);
+    }
+
+    // Supervisor takes the token before restarting us in place, so a restart never overlaps with a drain.
+    // If it is taken, the restart is parked on it instead of retried, handBackDrain() queues it again.
+    // True if the caller holds the token now, false if the restart got parked (or one is parked already)
+    bool claimDrainForRestart(bool bump_gen)
+    {
+        uint8_t parked = bump_gen ? DRAIN_RESTART_PARKED : DRAIN_RESUME_PARKED;
+        uint8_t token = DRAIN_FREE;
+        while (true)
+        {
+            uint8_t wanted = (token == DRAIN_FREE) ? DRAIN_HELD : std::max(token,parked);
+            if (wanted == token)
+                return false;
+            if (drain_token_.compare_exchange_weak(token,wanted,std::memory_order_acq_rel))
+                return token == DRAIN_FREE;
+        }
+    }
+
+    // Hand back a token taken with tryClaimDrain(), and drain whatever came in meanwhile
+    void releaseDrain()
+    {
+        handBackDrain();
+        requestDrain();
+    }
+
+    // Stop taking and processing msgs, because the supervisor restarts us along with a failed sibling/parent
+    void suspend()
+    {
+        if (actor_alive_.exchange(false,std::memory_order_acq_rel))
+            actor_state_.store(ActorState::STOPPING,std::memory_order_release);
+    }
+
+    // Fail on behalf of a child whose restarts got escalated to us, returns false if we already failed
+    bool escalateFailure()
+    {
+        if (!actor_alive_.exchange(false,std::memory_order_acq_rel))
+            return false;
+        actor_state_.store(ActorState::FAILED,std::memory_order_release);
+        return true;
+    }
+
+    // Bring this actor back in place: same object, same mailbox (pending msgs are kept), new generation.
+    // Caller must hold the drain token (claimDrainForRestart), which is handed back here.
+    // Returns false without reviving anything if we are being stopped, stopActor() is waiting for that token
+    bool restartInPlace(uint64_t new_gen)
+    {
+        if (stop_requested_.load(std::memory_order_acquire))
+        {
+            handBackDrain();
+            return false;
+        }
+
+        gen_id_.store(new_gen,std::memory_order_relaxed);
+        in_rate_.store(0,std::memory_order_relaxed);
+        out_rate_.store(0,std::memory_order_relaxed);
+        last_sample_enqueued_ = enqueued_total_.load(std::memory_order_relaxed);
+        last_sample_dequeued_ = dequeued_total_.load(std::memory_order_relaxed);
+        last_sample_time_ = std::chrono::steady_clock::now();
+
+        actor_state_.store(ActorState::RUNNING,std::memory_order_release);
+        actor_alive_.store(true,std::memory_order_release);
+        handBackDrain();
+        // msgs that waited in the mailbox during restart need a drain
+        requestDrain();
+        return true;
+    }
+
     // Stop the mailbox checker thread
     void stopActor()
     {
         //if (actor_alive_.exchange(false,std::memory_order_acq_rel) || isFailedState())
         {
+            stop_requested_.store(true,std::memory_order_release);
             actor_alive_.store(false,std::memory_order_release);
             //std::cout << "Stopping Actor: " << name_ << std::endl;
-            Logger::log(Level::Info, name_, "Stopping Actor");
-            while(is_draining_.load(std::memory_order_acquire))
+            ACTOR_LOG_INFO(name_, "Stopping Actor");
+            // Take the drain token and keep it: the running drain (or restart) is over then, and no new drain
+            // can get scheduled after this. Just waiting for the token to be free would let a restart grab it first
+            while(!tryClaimDrain())
             { 
                 std::this_thread::yield();
             }
+            // a restart that checked stop_requested_ just before we set it may have revived us meanwhile
+            actor_alive_.store(false,std::memory_order_release);
             actor_state_.store(ActorState::STOPPED,std::memory_order_release);
         }
     }
@@ -324,6 +998,61 @@ public:
 
 };
 
+// A msg travelling from one shard to another, receiver id is needed as the channel is per shard pair, not per actor
+template <typename Task>
+struct ShardEnvelope
+{
+    size_t receiver_id;
+    Message<Task> msg;
+    // BLOCK receivers: when this msg stops waiting in the shard backlog for room, set on its first refusal
+    std::chrono::steady_clock::time_point block_deadline;
+
+    ShardEnvelope(): receiver_id(0) {}
+    ShardEnvelope(size_t receiver, Message<Task>&& msg_): receiver_id(receiver), msg(std::move(msg_)) {}
+};
+
+/* One shard of a sharded ActorSystem
+    - Owns actors with (idx % num_shards == shard_id), and only its dispatcher thread ever drains them,
+      so same-shard sends just append to run_queue, no pool, no locks
+    - inbound[src] is the spsc channel from shard src into this shard. Producer is src dispatcher thread only,
+      consumer is this dispatcher only, which is exactly the lockFree_spsc_Queue contract
+    - Threads outside the shards (main, worker pool...) push their msgs straight into the mpmc mailbox,
+      and wake the actor through inject_q instead
+*/
+template <typename Task>
+struct ActorShard
+{
+    size_t shard_id;
+    ActorSystem<Task>* owner;
+    std::thread dispatcher;
+    std::deque<size_t> run_queue;   // actor ids waiting for a drain, touched only by dispatcher thread
+    mpmcQueueBounded<size_t> inject_q; // actor ids woken up from non-shard threads
+    std::vector<std::unique_ptr<lockFree_spsc_Queue<ShardEnvelope<Task>>>> inbound;
+    std::deque<ShardEnvelope<Task>> backlog;    // channel msgs whose receiver could not take them yet (full / restarting)
+    std::vector<uint32_t> backlogged;   // per actor count of msgs in backlog, newer msgs queue up behind them
+    std::atomic<bool> running;
+    alignas(64) std::atomic<uint32_t> wake_seq;   // bumped on every new work item, dispatcher waits on it when idle
+    std::atomic<bool> sleeping;
+
+    ActorShard(size_t id, size_t num_shards, size_t num_actors, ActorSystem<Task>* system)
+        :shard_id(id), owner(system), inject_q(num_actors), inbound(num_shards), backlogged(num_actors,0),
+        running(true), wake_seq(0), sleeping(false)
+    {
+        for (size_t src=0; src<num_shards; src++)
+            if (src != shard_id)
+                inbound[src] = std::make_unique<lockFree_spsc_Queue<ShardEnvelope<Task>>>(SHARD_CHANNEL_SIZE);
+    }
+
+    void wake()
+    {
+        // seq_cst on both sides (Dekker style): either we see the dispatcher going to sleep and notify,
+        // or the dispatcher sees our bumped wake_seq and does not block
+        wake_seq.fetch_add(1,std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst))
+            wake_seq.notify_one();
+    }
+};
+
 // Packages a function and its arguments into a "Task" type, which is compatible to push in actor mailboxes
 template <typename Task, typename Func, typename... Args>
 Task constructTask(Func&& func, Args&&... args)
@@ -341,24 +1070,80 @@ private:
     std::atomic<size_t> active_actors_; // Tracks current active actors in the system
     size_t total_actors_;   // The max no. of actors this ActorSystem can manage
     std::vector<ActorSlot<Task>> actor_slots_;
+    SlotStack free_slots_;   // indices of slots not holding any actor, recycled on stop()
+    size_t num_shards_;     // 0 means classic mode, every drain goes through worker_pool_
+    std::vector<std::unique_ptr<ActorShard<Task>>> shards_;
+    static inline thread_local ActorShard<Task>* current_shard_ = nullptr; // shard owning the calling thread, if any
     std::shared_mutex registry_lock_;  // lock to handle concurrent registers and unregisters for actors
     std::unordered_map<std::string,size_t> actor_registry_; //maintain a actor registry to easily refer an actor by name
-    std::condition_variable actors_pending_cleanup_;  // condition variable to control access to cleanup queue
-    std::queue<size_t> binned_actor_idx;  // cleanup queue storing idx of actors to destroy
-    std::thread cleanup_thread_; // Thread that keeps polling to pop from cleanup queue to destroy failed actors
-    std::mutex cleanup_mtx_;    // Mutex to control access to cleanup queue
+    std::atomic<uint64_t> spawn_counter_;  // source of ActorSlot::start_order
+
+    // supervisor of the top level actors
+    SupervisorSpec root_spec_;
+    std::atomic<int64_t> root_window_start_ns_;
+    std::atomic<size_t> root_restarts_in_window_;
+
+    // restart latency/throughput
+    std::atomic<uint64_t> restart_count_;
+    std::atomic<uint64_t> restart_latency_sum_ns_;
+    std::atomic<uint64_t> restart_latency_max_ns_;
+
+    // supervision work, see requestSupervision()
+    static constexpr uint32_t SUPERVISE_FAILURE = 1;    // superviseFailure()
+    static constexpr uint32_t SUPERVISE_RESTART = 2;    // restartActor() with a new generation
+    static constexpr uint32_t SUPERVISE_RESUME = 4;     // restartActor() keeping the generation (IGNORE)
+    static constexpr uint32_t SUPERVISE_QUEUED = 8;     // slot is on supervision_q_
+    SlotStack supervision_q_;
+    std::atomic<bool> supervising_;             // a supervision pass is queued or running, only one at a time
+    std::atomic<bool> supervision_deferred_;    // pool was full when a pass had to be queued, next pool drain runs it
+
+    // periodic metrics dump, see startMetricsDump()
+    std::thread metrics_thread_;
+    std::mutex metrics_mtx_;
+    std::condition_variable metrics_cv_;
+    bool metrics_stop_ = false;
+
+    static int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
 
 public:
     ThreadPool_Q worker_pool_;
 
-    ActorSystem(size_t numActors):
-                active_actors_(0), total_actors_(numActors),
+    // numShards = 0 keeps the shared threadpool design,
+    // numShards > 0 gives every shard its own dispatcher thread pinned to a core, and actors are spread over shards by idx
+    ActorSystem(size_t numActors, size_t numShards = 0):
+                active_actors_(0), total_actors_(numActors), free_slots_(numActors), num_shards_(numShards),
+                spawn_counter_(0), root_window_start_ns_(0), root_restarts_in_window_(0),
+                restart_count_(0), restart_latency_sum_ns_(0), restart_latency_max_ns_(0),
+                supervision_q_(numActors,false), supervising_(false), supervision_deferred_(false),
                 worker_pool_(numActors*4, NUM_WORKER_THREADS)
     {
         pprof::instance();
         pprof::instance().enableTrace();
         actor_slots_ = std::vector<ActorSlot<Task>>(numActors);
-        cleanup_thread_ = std::thread([this](){cleanup_actors();});
+
+        for (size_t shard_id=0; shard_id<num_shards_; shard_id++)
+            shards_.emplace_back(std::make_unique<ActorShard<Task>>(shard_id,num_shards_,numActors,this));
+
+        // start dispatchers only after all shards exist, as they poll each other's channels
+        for (auto& shard: shards_)
+        {
+            ActorShard<Task>* shard_ptr = shard.get();
+            shard->dispatcher = std::thread([this,shard_ptr](){ shardDispatcher(*shard_ptr); });
+            pinToCore(shard->dispatcher,shard->shard_id);
+        }
+    }
+
+    bool isSharded() const
+    {
+        return num_shards_ > 0;
+    }
+
+    size_t shardOf(size_t actor_id) const
+    {
+        return actor_id % num_shards_;
     }
 
     // Add a newly spawned actor into our registry
@@ -371,17 +1156,35 @@ public:
             || (actor_registry_.find(requested_name) != actor_registry_.end()))
         {
             //std::cout << "Actor id: " << requested_name << "already holds active actor" << std::endl;
-            Logger::log(Level::Warn, "ActorSystem", requested_name + " is taken"  );
+            ACTOR_LOGF_WARN("ActorSystem", "{} is taken", requested_name);
             return false;
         }
-        actor_slots_[requested_id].actor = std::make_unique<Actor<Task>>(mailbox_capacity,requested_id,requested_name,actor_slots_[requested_id].gen_id);
-        actor_slots_[requested_id].is_valid.store(true,std::memory_order_release);
-        actor_slots_[requested_id].actor->setActorSystem(this->shared_from_this());
+        ActorSlot<Task>& slot = actor_slots_[requested_id];
+        if (slot.retired)
+        {
+            // already knows us, no setActorSystem() (and its shared_ptr refcount traffic) needed
+            slot.actor = std::move(slot.retired);
+            slot.actor->respawn(mailbox_capacity,requested_name,slot.gen_id);
+        }
+        else
+        {
+            slot.actor = std::make_unique<Actor<Task>>(mailbox_capacity,requested_id,requested_name,slot.gen_id);
+            slot.actor->setActorSystem(this->shared_from_this());
+        }
+        slot.start_order.store(spawn_counter_.fetch_add(1,std::memory_order_relaxed),std::memory_order_relaxed);
+        slot.is_valid.store(true,std::memory_order_release);
 
-        actor_registry_.emplace(requested_name,requested_id);
+        if (slot.registry_node)
+        {
+            slot.registry_node.key() = requested_name;
+            slot.registry_node.mapped() = requested_id;
+            actor_registry_.insert(std::move(slot.registry_node));
+        }
+        else
+            actor_registry_.emplace(requested_name,requested_id);
 
-        Logger::log(Level::Info, requested_name, "Successfully registered ");
-        pprof::instance().record(ActorModel::Profile::EventType::Register, requested_id,actor_slots_[requested_id].gen_id, 1234);
+        ACTOR_LOG_INFO(requested_name, "Successfully registered ");
+        pprof::instance().record(ActorModel::Profile::EventType::Register, requested_id,actor_slots_[requested_id].gen_id, 1234, requested_name);
 
         return true;
     }
@@ -394,78 +1197,323 @@ public:
         if (name == "")
         {
             //std::cout << "Cannot create nameless Actor" << std::endl;
-            Logger::log(Level::Warn, "ActorSystem", "Cannot create nameless Actor");
+            ACTOR_LOG_WARN("ActorSystem", "Cannot create nameless Actor");
             return {};
         }
-        while(1)
+        // when we want to spawn an actor at a specific index, 
+        //specially when an already existing actor fails and stops, and as part of recovery mechanism, we respawn same actor
+        // I will use this spawn with idx later, for adding recovery mechanisms
+        if ((idx != -1) && 
+            (idx >= 0 && (size_t)idx< total_actors_ ) ) // if idx is in valid range
         {
-            // when we want to spawn an actor at a specific index, 
-            //specially when an already existing actor fails and stops, and as part of recovery mechanism, we respawn same actor
-            // I will use this spawn with idx later, for adding recovery mechanisms
-            if ((idx != -1) && 
-                (idx >= 0 && (size_t)idx< total_actors_ ) ) // if idx is in valid range
-            {
-                size_t idx_ = (size_t)idx;
-                if ( registerActor(idx_,name,mailbox_capacity) )
-                {
-
-                    return ActorHandle(idx_,actor_slots_[idx_].actor->name_);
-                }
-                
-                //std::cout << "Actor creation failed for id: " << idx << std::endl;
-                Logger::log(Level::Warn, "ActorSystem", "Actor creation failed for id: " + to_string(idx));
-                return {};
-            }
+            size_t idx_ = (size_t)idx;
+            if ( registerActor(idx_,name,mailbox_capacity) )
+                return ActorHandle(idx_,name);
+            
+            //std::cout << "Actor creation failed for id: " << idx << std::endl;
+            ACTOR_LOGF_WARN("ActorSystem", "Actor creation failed for id: {}", idx);
+            return {};
+        }
 
-            // Actor System has reached max capacity, cannot add and spawn new actors 
-            size_t available_slot_idx = active_actors_.load(std::memory_order_acquire);
-            if (available_slot_idx >= total_actors_)
-                return {};
+        // Actor System has reached max capacity, cannot add and spawn new actors 
+        // (Used to be a bump pointer on active_actors_ with a rollback, which broke with concurrent spawns
+        // and never reused slots of stopped actors, so now slots come from a lock-free free list)
+        size_t available_slot_idx;
+        if (!free_slots_.pop(available_slot_idx))
+            return {};
 
-            // method to spawn completely new actor for the first time, and not used for respawning failed actor
-            if (active_actors_.compare_exchange_strong(available_slot_idx,available_slot_idx+1, std::memory_order_acq_rel))
-            {
-                //std::shared_ptr<Actor<Task>> new_actor= std::make_shared<Actor<Task>>(mailbox_capacity,curr_size,name);
-
-                if ( registerActor(available_slot_idx,name,mailbox_capacity) )
-                    return ActorHandle(available_slot_idx,actor_slots_[available_slot_idx].actor->name_);
-
-                // register actor failed, rollback active actors
-                active_actors_.fetch_sub(1,std::memory_order_release);
-                /* in case where multiple threads are calling spawn on same actor system, I see this rollback mechanism might fail.
-                    Because by the time this rollback hits, another thread might have spawned a new actor and incremented the index.
-                    this rollback will render that slot invalid, and waste the current slot also 
-                    So for now, I am assuming that only a single thread can call spawn on an actor system, and actors are spawned sequentially
-                    -(can this be enforced by using unique ptr for ActorSystem ?)
-                    TODO: How will this work in multithreaded spawn calls ?
-                    */
-                return {};
-            }
-            std::this_thread::yield();
+        // method to spawn completely new actor for the first time, and not used for respawning failed actor
+        // We own the popped slot exclusively, so concurrent spawns can never race for the same idx
+        if ( registerActor(available_slot_idx,name,mailbox_capacity) )
+        {
+            active_actors_.fetch_add(1,std::memory_order_relaxed);
+            return ActorHandle(available_slot_idx,name);
         }
+
+        // register actor failed (name taken), give the slot back so it is not wasted
+        free_slots_.push(available_slot_idx);
         return {};
     }
 
-    //void notifyMailboxActive(std::weak_ptr<Actor<Task>> weak_actor)
-    void notifyMailboxActive(size_t actor_id)
+    bool isCurrentHandle(const ActorHandle& handle)
     {
-        //std::cout << "notifyMailboxActive invoked" << std::endl;
-
-        bool push_done = worker_pool_.tryPush([this,actor_id]() { if (this->actor_slots_[actor_id].actor 
-                                                    && this->actor_slots_[actor_id].is_valid.load(std::memory_order_acquire)
-                                                    )
-                                                        this->actor_slots_[actor_id].actor->drainMailbox();
-                                            });
-
-        // Log failure for threadpool push fail                                
-        if (!push_done)
-            pprof::instance().record(ActorModel::Profile::EventType::Fail, actor_id,actor_slots_[actor_id].gen_id,1234);
-                                            
+        std::shared_lock<std::shared_mutex> rlock(registry_lock_);
+        auto it = actor_registry_.find(handle.name);
+        return (it != actor_registry_.end()) && (it->second == handle.idx);
+    }
+
+    // Change what happens when this actor's mailbox is full, survives restarts of the actor
+    bool setMailboxPolicy(const ActorHandle& handle, const MailboxPolicy& policy)
+    {
+        std::shared_lock<std::shared_mutex> rlock(registry_lock_);
+        auto it = actor_registry_.find(handle.name);
+        if ((it == actor_registry_.end()) || (it->second != handle.idx) || !actor_slots_[handle.idx].actor)
+            return false;
+        if ((policy.on_full == OverflowPolicy::DEAD_LETTER) && (policy.dead_letter_id >= total_actors_))
+            return false;
+        actor_slots_[handle.idx].actor->setMailboxPolicy(policy);
+        return true;
+    }
+
+    // Senders can poll this before sending, instead of spinning on failed sends
+    FlowSignal flowSignal(const ActorHandle& handle)
+    {
+        std::shared_lock<std::shared_mutex> rlock(registry_lock_);
+        auto it = actor_registry_.find(handle.name);
+        if ((it == actor_registry_.end()) || (it->second != handle.idx) || !actor_slots_[handle.idx].actor)
+            return FlowSignal::STOP;
+        return actor_slots_[handle.idx].actor->flowSignal();
+    }
+
+    // Blocking a sender only makes sense if somebody else can drain the receiver meanwhile
+    bool maySenderBlock(size_t receiver_id) const
+    {
+        return !(isSharded() && (currentShard() == shards_[shardOf(receiver_id)].get()));
+    }
+
+    // Overflow target of DEAD_LETTER actors. No further redirect from here, a full dead letter box just fails
+    bool sendDeadLetter(size_t dead_letter_id, Message<Task>&& msg)
+    {
+        if (dead_letter_id >= total_actors_)
+            return false;
+        Actor<Task>* dead_letter_actor = actor_slots_[dead_letter_id].actor.get();
+        if (!dead_letter_actor || !actor_slots_[dead_letter_id].is_valid.load(std::memory_order_acquire))
+            return false;
+        return dead_letter_actor->addToMailbox(std::move(msg),false);
+    }
+
+    // Stop an actor for good (no restart), and recycle its slot for future spawns
+    bool stop(const ActorHandle& handle)
+    {
+        std::unique_lock<std::shared_mutex> wrlock(registry_lock_);
+        auto it = actor_registry_.find(handle.name);
+        if ((it == actor_registry_.end()) || (it->second != handle.idx))
+            return false;   // stale handle, actor already stopped and maybe slot reused by someone else
+
+        if (!unregisterActor(handle.idx,wrlock))
+            return false;
+        stopChildren(handle.idx);
+        releaseSlot(handle.idx);
+        return true;
+    }
+
+    // Spawn an actor supervised by another actor instead of the root, see SupervisorSpec
+    ActorHandle spawnChild(const ActorHandle& supervisor, size_t mailbox_capacity, std::string name)
+    {
+        if (!isCurrentHandle(supervisor))
+            return {};
+        ActorHandle child = spawn(mailbox_capacity,name);
+        if (child.name != "")
+            actor_slots_[child.idx].parent_id.store(supervisor.idx,std::memory_order_release);
+        return child;
+    }
+
+    // Spawn with a dispatch policy, e.g. a dedicated (spinning/pinned) thread for a latency critical actor
+    ActorHandle spawn(size_t mailbox_capacity, std::string name, const DispatchPolicy& policy)
+    {
+        ActorHandle handle = spawn(mailbox_capacity,name);
+        if ((handle.name != "") && (policy.mode != DispatchMode::POOL))
+            setDispatchPolicy(handle,policy);
+        return handle;
+    }
+
+    // Move an actor between pool and dedicated dispatch at runtime, msgs in its mailbox just stay there.
+    // Not to be called from the actor's own task, it waits for the actor's current drain to end
+    bool setDispatchPolicy(const ActorHandle& handle, const DispatchPolicy& policy)
+    {
+        if (policy.mode >= DispatchMode::MAX_MODE)
+            return false;
+        std::shared_lock<std::shared_mutex> rlock(registry_lock_);
+        auto it = actor_registry_.find(handle.name);
+        if ((it == actor_registry_.end()) || (it->second != handle.idx) || !actor_slots_[handle.idx].actor)
+            return false;
+
+        // Own the drain token for the switch: then no drain is running or pending in the old mode, nothing to hand over
+        ActorSlot<Task>& slot = actor_slots_[handle.idx];
+        Actor<Task>* actor = slot.actor.get();
+        while (!actor->tryClaimDrain())
+            std::this_thread::yield();
+
+        stopDedicated(handle.idx);
+        if (policy.mode == DispatchMode::DEDICATED)
+            startDedicated(handle.idx,policy);
+        slot.dispatch_mode.store(policy.mode,std::memory_order_release);
+
+        // senders could not request a drain while we held the token, request one in the new mode
+        actor->releaseDrain();
+        return true;
+    }
+
+    DispatchMode dispatchMode(const ActorHandle& handle)
+    {
+        return actor_slots_[handle.idx].dispatch_mode.load(std::memory_order_acquire);
+    }
+
+    // How this supervisor handles failures of its children
+    bool setSupervisorSpec(const ActorHandle& supervisor, const SupervisorSpec& spec)
+    {
+        if (!isCurrentHandle(supervisor))
+            return false;
+        ActorSlot<Task>& slot = actor_slots_[supervisor.idx];
+        slot.max_child_restarts.store(spec.max_restarts,std::memory_order_relaxed);
+        slot.restart_window_ms.store(spec.window.count(),std::memory_order_relaxed);
+        slot.child_strategy.store(spec.strategy,std::memory_order_release);
+        return true;
+    }
+
+    // Spec for top level actors, set it before actors start failing
+    void setRootSupervisorSpec(const SupervisorSpec& spec)
+    {
+        root_spec_ = spec;
+    }
+
+    uint64_t generation(const ActorHandle& handle)
+    {
+        return actor_slots_[handle.idx].gen_id.load(std::memory_order_acquire);
+    }
+
+    RestartStats restartStats() const
+    {
+        return RestartStats{restart_count_.load(std::memory_order_relaxed),
+                            restart_latency_sum_ns_.load(std::memory_order_relaxed),
+                            restart_latency_max_ns_.load(std::memory_order_relaxed)};
+    }
+
+    // Live metrics of every registered actor. Holding the registry read lock keeps the actors from being
+    // destroyed under us, the counters themselves are read relaxed, so this never stalls senders or drains
+    std::vector<ActorMetrics> metricsSnapshot()
+    {
+        std::vector<ActorMetrics> snapshot;
+        std::shared_lock<std::shared_mutex> rlock(registry_lock_);
+        snapshot.reserve(actor_registry_.size());
+        for (const auto& [name,idx]: actor_registry_)
+        {
+            if (!actor_slots_[idx].actor)
+                continue;
+            ActorMetrics metrics;
+            actor_slots_[idx].actor->fillMetrics(metrics);
+            metrics.dispatch_mode = actor_slots_[idx].dispatch_mode.load(std::memory_order_relaxed);
+            snapshot.push_back(std::move(metrics));
+        }
+        rlock.unlock();
+        std::sort(snapshot.begin(),snapshot.end(),[](const ActorMetrics& a, const ActorMetrics& b){ return a.id < b.id; });
+        return snapshot;
+    }
+
+    // metricsSnapshot() in Prometheus text exposition format, so a node_exporter textfile collector
+    // (or just cat) can pick it up
+    std::string metricsText()
+    {
+        std::vector<ActorMetrics> snapshot = metricsSnapshot();
+        RestartStats restarts = restartStats();
+        std::ostringstream out;
+
+        auto labels = [](const ActorMetrics& metrics)
+        {
+            std::string escaped;
+            for (char c: metrics.name)
+            {
+                if ((c == '"') || (c == '\\') || (c == '\n'))
+                    escaped += '\\';
+                escaped += (c == '\n') ? 'n' : c;
+            }
+            return "{actor=\"" + escaped + "\",id=\"" + std::to_string(metrics.id) + "\"}";
+        };
+        auto family = [&](const char* metric, const char* type, const char* help, auto value)
+        {
+            out << "# HELP " << metric << ' ' << help << '\n' << "# TYPE " << metric << ' ' << type << '\n';
+            for (const ActorMetrics& metrics: snapshot)
+                out << metric << labels(metrics) << ' ' << value(metrics) << '\n';
+        };
+
+        family("actor_mailbox_depth","gauge","Msgs waiting in the mailbox",[](const ActorMetrics& m){ return m.mailbox_depth; });
+        family("actor_mailbox_capacity","gauge","Mailbox capacity",[](const ActorMetrics& m){ return m.mailbox_capacity; });
+        family("actor_enqueued_total","counter","Msgs accepted into the mailbox",[](const ActorMetrics& m){ return m.enqueued_total; });
+        family("actor_dequeued_total","counter","Msgs taken out of the mailbox (handled or dropped)",[](const ActorMetrics& m){ return m.dequeued_total; });
+        family("actor_enqueue_rate","gauge","Msgs/s into the mailbox, sampled at the end of each drain",[](const ActorMetrics& m){ return m.in_rate; });
+        family("actor_dequeue_rate","gauge","Msgs/s out of the mailbox, sampled at the end of each drain",[](const ActorMetrics& m){ return m.out_rate; });
+        family("actor_drains_total","counter","Mailbox drains",[](const ActorMetrics& m){ return m.drains; });
+        family("actor_busy_seconds_total","counter","Time spent draining the mailbox",[](const ActorMetrics& m){ return m.busy_ns/1e9; });
+        family("actor_service_time_seconds","gauge","Average time per handled msg",[](const ActorMetrics& m){ return m.avgServiceNs()/1e9; });
+        family("actor_drain_max_seconds","gauge","Longest single drain",[](const ActorMetrics& m){ return m.max_drain_ns/1e9; });
+        family("actor_failures_total","counter","Msgs that threw",[](const ActorMetrics& m){ return m.failures; });
+        family("actor_dropped_after_accept_total","counter","Cross shard msgs dropped on delivery after the send returned true",
+                [](const ActorMetrics& m){ return m.dropped_after_accept; });
+        family("actor_dedicated","gauge","1 if the actor runs on its own thread",[](const ActorMetrics& m){ return (m.dispatch_mode == DispatchMode::DEDICATED) ? 1 : 0; });
+
+        out << "# HELP actor_system_active_actors Registered actors\n# TYPE actor_system_active_actors gauge\n"
+            << "actor_system_active_actors " << snapshot.size() << '\n';
+        out << "# HELP actor_system_restarts_total Supervised restarts\n# TYPE actor_system_restarts_total counter\n"
+            << "actor_system_restarts_total " << restarts.restarts << '\n';
+        return out.str();
+    }
+
+    // Rewrite path with metricsText() every period. Written to a tmp file and renamed over path,
+    // so a reader never sees a half written dump. Calling it again restarts the dump with the new settings
+    void startMetricsDump(const std::string& path, std::chrono::milliseconds period)
+    {
+        stopMetricsDump();
+        metrics_stop_ = false;
+        metrics_thread_ = std::thread([this,path,period]()
+        {
+            std::string tmp_path = path + ".tmp";
+            std::unique_lock<std::mutex> lock(metrics_mtx_);
+            while (!metrics_cv_.wait_for(lock,period,[this](){ return metrics_stop_; }))
+            {
+                lock.unlock();
+                std::string text = metricsText();
+                {
+                    std::ofstream out(tmp_path,std::ios::out | std::ios::trunc);
+                    out << text;
+                }
+                if (std::rename(tmp_path.c_str(),path.c_str()) != 0)
+                    ACTOR_LOGF_WARN("ActorSystem", "Cannot write metrics to {}", path);
+                lock.lock();
+            }
+        });
+    }
+
+    void stopMetricsDump()
+    {
+        if (!metrics_thread_.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(metrics_mtx_);
+            metrics_stop_ = true;
+        }
+        metrics_cv_.notify_one();
+        metrics_thread_.join();
+    }
+
+    //void notifyMailboxActive(std::weak_ptr<Actor<Task>> weak_actor)
+    // false if no drain got scheduled
+    bool notifyMailboxActive(size_t actor_id)
+    {
+        //std::cout << "notifyMailboxActive invoked" << std::endl;
+        if (actor_slots_[actor_id].dispatch_mode.load(std::memory_order_acquire) == DispatchMode::DEDICATED)
+        {
+            actor_slots_[actor_id].dedicated->wake();
+            return true;
+        }
+        if (isSharded())
+        {
+            scheduleOnShard(actor_id);
+            return true;
+        }
+
+        bool push_done = worker_pool_.tryPush([this,actor_id]() { this->drainActor(actor_id); this->runDeferredSupervision(); });
+
+        // Log failure for threadpool push fail                                
+        if (!push_done)
+            pprof::instance().record(ActorModel::Profile::EventType::Fail, actor_id,actor_slots_[actor_id].gen_id,1234);
+        return push_done;
     }
 
     // Helper function to send msg based on actor name instead of pointers, from sender -> receiver actor
 
-    // send() by receiver id
+    // send() by receiver id. true means the receiver took msg. From an actor on another shard msg first goes through
+    // a shard channel: FAIL and DROP_NEWEST still refuse here, but a BLOCK timeout or a full dead letter actor can only
+    // drop it on the receiver's shard after true was returned, those show up in ActorMetrics::dropped_after_accept
     bool send(size_t receiver_id, Message<Task>&& msg)
     {
 
@@ -477,6 +1525,14 @@ public:
         if(!receiver)
             return false;
 
+        // Sender is an actor running on another shard, hand the msg over through that shard pair's channel
+        if (isSharded())
+        {
+            ActorShard<Task>* src_shard = currentShard();
+            if (src_shard && (src_shard->shard_id != shardOf(receiver_id)))
+                return sendCrossShard(*src_shard,*receiver,receiver_id,std::move(msg));
+        }
+
         if (actor_slots_[receiver_id].is_valid.load(std::memory_order_acquire))
             return receiver->addToMailbox(std::move(msg));
         return false;
@@ -520,60 +1576,563 @@ public:
         return false;
     }
 
-    void cleanup_actors()
+    // Shard of the calling thread, only if it is one of our own dispatchers
+    ActorShard<Task>* currentShard() const
     {
-        size_t cleanup_idx;
+        if (current_shard_ && (current_shard_->owner == this))
+            return current_shard_;
+        return nullptr;
+    }
 
-        while(1)
+    static void pinToCore(std::thread& thread, size_t core)
+    {
+        size_t num_cores = std::max(1u,std::thread::hardware_concurrency());
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(core % num_cores, &cpu_set);
+        if (pthread_setaffinity_np(thread.native_handle(),sizeof(cpu_set_t),&cpu_set) != 0)
+            ACTOR_LOGF_WARN("ActorSystem", "Failed to pin thread to core {}", core);
+    }
+
+    void drainActor(size_t actor_id)
+    {
+        SlotPin<Task> actor(actor_slots_[actor_id]);
+        if (actor)
+            actor->drainMailbox();
+    }
+
+    void dedicatedDispatcher(size_t actor_id, ActorDispatcher& dispatcher)
+    {
+        pthread_setname_np(pthread_self(), ("actor" + to_string(actor_id)).substr(0,15).c_str());
+        auto drainRequested = [&dispatcher](){ return dispatcher.drain_requested.load(std::memory_order_seq_cst); };
+
+        while (dispatcher.running.load(std::memory_order_acquire))
         {
-            std::unique_lock<std::mutex> cleanup_lock(cleanup_mtx_);
-            actors_pending_cleanup_.wait(cleanup_lock,[this](){return !binned_actor_idx.empty(); });
-            
-            cleanup_idx = binned_actor_idx.front();
-            binned_actor_idx.pop();
-            cleanup_lock.unlock();
-            
-            if ((size_t)cleanup_idx == total_actors_) // Sentinel to stop cleanup thread
-                    return;
+            if (dispatcher.drain_requested.exchange(false,std::memory_order_acq_rel))
+            {
+                drainActor(actor_id);
+                continue;
+            }
 
-            if (actor_slots_[cleanup_idx].actor 
-                && !actor_slots_[cleanup_idx].is_valid.load(std::memory_order_acquire))
+            // Spinning actors trade a core for not paying the futex wakeup on the next msg
+            if (dispatcher.policy.spin.count())
             {
-                if (actor_slots_[cleanup_idx].actor->recovery_strategy_ == RecoveryMechanism::RESTART )
-                {
-                    ActorParameters failed_actor_params;
-                    actor_slots_[cleanup_idx].actor->getActorProperties(failed_actor_params);
-                    // Since only failed actors come to this path, we have already set actor_alive_ as false
-                    actor_slots_[cleanup_idx].gen_id.fetch_add(1,std::memory_order_relaxed);
-                    unregisterActor(cleanup_idx);
-                    
-                    auto renewed_actor = spawn(failed_actor_params.mailbox_size,failed_actor_params.name,cleanup_idx);
-                    pprof::instance().record(ActorModel::Profile::EventType::Restart, cleanup_idx,actor_slots_[cleanup_idx].gen_id,1234);
+                auto spin_until = std::chrono::steady_clock::now() + dispatcher.policy.spin;
+                while (!drainRequested() && dispatcher.running.load(std::memory_order_relaxed)
+                        && (std::chrono::steady_clock::now() < spin_until)) {}
+                if (drainRequested())
                     continue;
-                }
             }
-            unregisterActor(cleanup_idx);
+
+            dispatcher.sleeping.store(true,std::memory_order_seq_cst);
+            uint32_t seq = dispatcher.wake_seq.load(std::memory_order_seq_cst);
+            if (!drainRequested() && dispatcher.running.load(std::memory_order_acquire))
+                dispatcher.wake_seq.wait(seq,std::memory_order_seq_cst);
+            dispatcher.sleeping.store(false,std::memory_order_relaxed);
         }
+
+        // a drain requested right before the stop owns the drain token, run it so that the token is released
+        if (dispatcher.drain_requested.exchange(false,std::memory_order_acq_rel))
+            drainActor(actor_id);
     }
 
-    // If actor throws exception while handling a task, 
-    //first we need to stop the actor from accepting new msgs, and then log this failure
-    //void notifyActorFailure(std::shared_ptr<Actor<Task>> actor)
+    void startDedicated(size_t actor_id, const DispatchPolicy& policy)
+    {
+        ActorSlot<Task>& slot = actor_slots_[actor_id];
+        if (!slot.dedicated)
+            slot.dedicated = std::make_unique<ActorDispatcher>();
+        ActorDispatcher& dispatcher = *slot.dedicated;
+        dispatcher.policy = policy;
+        dispatcher.drain_requested.store(false,std::memory_order_relaxed);
+        dispatcher.running.store(true,std::memory_order_release);
+        dispatcher.thread = std::thread([this,actor_id,&dispatcher](){ dedicatedDispatcher(actor_id,dispatcher); });
+        if (policy.pin_core >= 0)
+            pinToCore(dispatcher.thread,static_cast<size_t>(policy.pin_core));
+    }
+
+    void stopDedicated(size_t actor_id)
+    {
+        ActorDispatcher* dispatcher = actor_slots_[actor_id].dedicated.get();
+        if (!dispatcher || !dispatcher->thread.joinable())
+            return;
+        dispatcher->running.store(false,std::memory_order_release);
+        dispatcher->wake_seq.fetch_add(1,std::memory_order_seq_cst);
+        dispatcher->wake_seq.notify_all();
+        dispatcher->thread.join();
+    }
+
+    // Queue a drain for this actor on its shard
+    void scheduleOnShard(size_t actor_id)
+    {
+        ActorShard<Task>& dst_shard = *shards_[shardOf(actor_id)];
+        if (currentShard() == &dst_shard)
+        {
+            dst_shard.run_queue.push_back(actor_id);
+            return;
+        }
+        // the drain token lets only one wakeup per actor be in flight, so inject_q (sized to all actors) cannot overflow,
+        // but record it anyway in case that invariant ever breaks
+        if (!dst_shard.inject_q.try_push(actor_id))
+        {
+            pprof::instance().record(ActorModel::Profile::EventType::Fail, actor_id,actor_slots_[actor_id].gen_id,1234);
+            return;
+        }
+        dst_shard.wake();
+    }
+
+    bool sendCrossShard(ActorShard<Task>& src_shard, Actor<Task>& receiver, size_t receiver_id, Message<Task>&& msg)
+    {
+        ActorSlot<Task>& slot = actor_slots_[receiver_id];
+        // reserve room in the receiver's mailbox, deliverOnShard() gives it back
+        uint64_t in_transit = slot.in_transit.fetch_add(1,std::memory_order_relaxed) + 1;
+        if (!receiver.admitsInTransit(in_transit))
+        {
+            slot.in_transit.fetch_sub(1,std::memory_order_relaxed);
+            return false;
+        }
+
+        ActorShard<Task>& dst_shard = *shards_[shardOf(receiver_id)];
+        // channel full behaves like a full mailbox, sender gets false. Falling back to the direct mailbox push here
+        // would let this msg overtake the ones still sitting in the channel
+        if (!dst_shard.inbound[src_shard.shard_id]->push(ShardEnvelope<Task>{receiver_id,std::move(msg)}))
+        {
+            slot.in_transit.fetch_sub(1,std::memory_order_relaxed);
+            pprof::instance().record(ActorModel::Profile::EventType::Fail, receiver_id,slot.gen_id,1234);
+            return false;
+        }
+        dst_shard.wake();
+        return true;
+    }
+
+    // Runs on the receiver's shard thread: move a msg that came through a channel into the actor mailbox.
+    // Returns false if the receiver cannot take it yet, msg is left untouched then.
+    // No draining the receiver inline here to make room: it might be failed and getting restarted on the pool meanwhile
+    // Every true return ends the msg's transit (sendCrossShard() reserved it)
+    bool deliverOnShard(ShardEnvelope<Task>& envelope)
+    {
+        size_t receiver_id = envelope.receiver_id;
+        ActorSlot<Task>& slot = actor_slots_[receiver_id];
+        SlotPin<Task> receiver(slot);
+        if (!receiver)
+        {
+            // actor stopped for good, nobody will ever take this msg
+            pprof::instance().record(ActorModel::Profile::EventType::Fail, receiver_id,slot.gen_id,1234);
+            slot.in_transit.fetch_sub(1,std::memory_order_relaxed);
+            return true;
+        }
+
+        MailboxPolicy policy = receiver->getMailboxPolicy();
+        if (policy.on_full != OverflowPolicy::BLOCK)
+        {
+            if (!receiver->addToMailbox(std::move(envelope.msg)))
+            {
+                // Only a receiver down for a restart gets the msg retried. A live one applied its policy and recorded
+                // the outcome, final just like for a direct send, only this sender already got true
+                if (!receiver->isAlive())
+                    return false;
+                receiver->countDroppedAfterAccept();
+            }
+            slot.in_transit.fetch_sub(1,std::memory_order_relaxed);
+            return true;
+        }
+
+        // BLOCK: the shard thread must not block, so the msg waits in the backlog instead, up to the block timeout
+        if (!receiver->tryAddToMailbox(envelope.msg))
+        {
+            if (!receiver->isAlive())
+                return false;
+            auto now = std::chrono::steady_clock::now();
+            if (envelope.block_deadline == std::chrono::steady_clock::time_point{})
+                envelope.block_deadline = now + policy.block_timeout;
+            if (now < envelope.block_deadline)
+                return false;
+            pprof::instance().record(ActorModel::Profile::EventType::BlockTimeout, receiver_id,slot.gen_id,1234);
+            receiver->countDroppedAfterAccept();
+        }
+        slot.in_transit.fetch_sub(1,std::memory_order_relaxed);
+        return true;
+    }
+
+    // Envelope goes to the backlog if receiver cannot take it, or if older msgs for the same receiver are still waiting there
+    void deliverOrBacklog(ActorShard<Task>& shard, ShardEnvelope<Task>&& envelope)
+    {
+        if (!shard.backlogged[envelope.receiver_id] && deliverOnShard(envelope))
+            return;
+        shard.backlogged[envelope.receiver_id]++;
+        shard.backlog.push_back(std::move(envelope));
+    }
+
+    // Retry the backlog in order, stop at the first refusal of each receiver to keep its msgs in order.
+    // Returns true if anything got delivered
+    bool retryBacklog(ActorShard<Task>& shard)
+    {
+        size_t pending = shard.backlog.size();
+        if (!pending)
+            return false;
+
+        bool delivered = false;
+        std::vector<size_t> refused;
+        while (pending--)
+        {
+            ShardEnvelope<Task> envelope = std::move(shard.backlog.front());
+            shard.backlog.pop_front();
+            size_t receiver_id = envelope.receiver_id;
+            if ((std::find(refused.begin(),refused.end(),receiver_id) == refused.end()) && deliverOnShard(envelope))
+            {
+                shard.backlogged[receiver_id]--;
+                delivered = true;
+                continue;
+            }
+            refused.push_back(receiver_id);
+            shard.backlog.push_back(std::move(envelope));
+        }
+        return delivered;
+    }
+
+    // One pass over everything a shard has to do, returns false if there was nothing
+    bool pollShard(ActorShard<Task>& shard)
+    {
+        // 1. Mail that could not be delivered on earlier passes
+        bool did_work = retryBacklog(shard);
+
+        // 2. Mail from other shards. Backlog full means some receivers are not keeping up,
+        // leave msgs in the channels then, so that senders see full channels and back off
+        ShardEnvelope<Task> envelope;
+        for (auto& channel: shard.inbound)
+        {
+            if (!channel)
+                continue;
+            while ((shard.backlog.size() < SHARD_CHANNEL_SIZE) && channel->pop(envelope))
+            {
+                deliverOrBacklog(shard,std::move(envelope));
+                did_work = true;
+            }
+        }
+
+        // 3. Wakeups from non-shard threads
+        size_t actor_id;
+        while (shard.inject_q.try_pop(actor_id))
+        {
+            shard.run_queue.push_back(actor_id);
+            did_work = true;
+        }
+
+        // 4. Drain only the actors runnable right now, the ones woken up during these drains wait for next pass,
+        // so that a chatty pair of actors cannot starve the channels
+        size_t runnable = shard.run_queue.size();
+        while (runnable--)
+        {
+            actor_id = shard.run_queue.front();
+            shard.run_queue.pop_front();
+            drainActor(actor_id);
+            did_work = true;
+        }
+        return did_work;
+    }
+
+    void shardDispatcher(ActorShard<Task>& shard)
+    {
+        current_shard_ = &shard;
+        pthread_setname_np(pthread_self(), ("shard" + to_string(shard.shard_id)).c_str());
+
+        while (shard.running.load(std::memory_order_acquire))
+        {
+            if (pollShard(shard))
+                continue;
+
+            // Nothing to do, go to sleep on wake_seq. Announce it first, then check once more,
+            // anything pushed before our seq read is seen by this last poll, anything after changes wake_seq
+            shard.sleeping.store(true,std::memory_order_seq_cst);
+            uint32_t seq = shard.wake_seq.load(std::memory_order_seq_cst);
+            if (!pollShard(shard) && shard.running.load(std::memory_order_acquire))
+                shard.wake_seq.wait(seq,std::memory_order_seq_cst);
+            shard.sleeping.store(false,std::memory_order_relaxed);
+        }
+
+        // flush whatever was still queued up when we were asked to stop
+        while (pollShard(shard)) {}
+        current_shard_ = nullptr;
+    }
+
+    void stopShards()
+    {
+        for (auto& shard: shards_)
+        {
+            shard->running.store(false,std::memory_order_release);
+            shard->wake_seq.fetch_add(1,std::memory_order_seq_cst);
+            shard->wake_seq.notify_all();
+        }
+        for (auto& shard: shards_)
+            if (shard->dispatcher.joinable())
+                shard->dispatcher.join();
+    }
+
+    /* Supervision work (what to do with a failed actor, restarts) is never dropped, it is the only thing that ever
+        revives or releases a failed actor:
+        - Requests are SUPERVISE_* bits on the slot, and the slot goes on supervision_q_ once (SUPERVISE_QUEUED).
+          Any number of requests for a slot collapse into one entry, so a ONE_FOR_ALL storm queues each sibling once
+        - One supervision pass at a time works off supervision_q_ on the pool, one pool task for all of it.
+          If the pool queue is full, the next pool drain runs the pass instead (a full pool has drains queued)
+    */
+    void requestSupervision(size_t actor_id, uint32_t what, uint64_t gen)
+    {
+        ActorSlot<Task>& slot = actor_slots_[actor_id];
+        slot.supervision_gen.store(gen,std::memory_order_relaxed);
+        if (slot.supervision.fetch_or(what | SUPERVISE_QUEUED,std::memory_order_acq_rel) & SUPERVISE_QUEUED)
+            return;
+        supervision_q_.push(actor_id);
+
+        // pairs with the fence in runSupervision(): either the pass going idle sees our push, or we see it idle
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (supervising_.exchange(true,std::memory_order_acq_rel))
+            return;
+        if (!worker_pool_.tryPush([this](){ runSupervision(); }))
+            supervision_deferred_.store(true,std::memory_order_release);
+    }
+
+    // Tail of every pool drain, picks up a supervision pass the full pool could not take
+    void runDeferredSupervision()
+    {
+        if (supervision_deferred_.load(std::memory_order_relaxed) && supervision_deferred_.exchange(false,std::memory_order_acq_rel))
+            runSupervision();
+    }
+
+    // Owner of supervising_ only
+    void runSupervision()
+    {
+        while (true)
+        {
+            size_t actor_id;
+            while (supervision_q_.pop(actor_id))
+                superviseSlot(actor_id);
+
+            supervising_.store(false,std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (supervision_q_.empty() || supervising_.exchange(true,std::memory_order_acq_rel))
+                return;
+        }
+    }
+
+    void superviseSlot(size_t actor_id)
+    {
+        ActorSlot<Task>& slot = actor_slots_[actor_id];
+        // clears SUPERVISE_QUEUED as well, requests from here on put the slot back on the queue
+        uint32_t what = slot.supervision.exchange(0,std::memory_order_acq_rel);
+        uint64_t gen = slot.supervision_gen.load(std::memory_order_relaxed);
+        if (what & SUPERVISE_FAILURE)
+            superviseFailure(actor_id,gen);
+        // a restart of a failed actor folded into a group restart is skipped by the gen check
+        if (what & SUPERVISE_RESTART)
+            restartActor(actor_id,gen,true);
+        if (what & SUPERVISE_RESUME)
+            restartActor(actor_id,gen,false);
+    }
+
+    // If actor throws exception while handling a task, actor has already stopped accepting new msgs,
+    // hand it to its supervisor. No cleanup thread or lock here: the decision and the restart itself run on the pool
     void notifyActorFailure(size_t actor_id)
     {
-        std::unique_lock<std::mutex> cleanup_lock(cleanup_mtx_);
-        /*ACTOR SLOT*/
-        actor_slots_[actor_id].is_valid.store(false,std::memory_order_release);
-        binned_actor_idx.push(actor_id);
-        cleanup_lock.unlock();
-        actors_pending_cleanup_.notify_one();
+        // keep the time of the first failure, a group restart may fold several failures into one restart
+        int64_t no_failure = 0;
+        actor_slots_[actor_id].failed_at_ns.compare_exchange_strong(no_failure,nowNs(),std::memory_order_relaxed);
+
+        uint64_t gen = actor_slots_[actor_id].gen_id.load(std::memory_order_acquire);
+        requestSupervision(actor_id,SUPERVISE_FAILURE,gen);
+    }
+
+    // A restart parked on the drain token of the actor, the token just got handed back.
+    // Nothing but a restart bumps gen_id and that needs the token, so the current gen is the one it was parked for
+    void requeueParkedRestart(size_t actor_id, bool bump_gen)
+    {
+        uint64_t gen = actor_slots_[actor_id].gen_id.load(std::memory_order_acquire);
+        requestSupervision(actor_id,bump_gen ? SUPERVISE_RESTART : SUPERVISE_RESUME,gen);
+    }
+
+    // Decide what to do with a failed actor, based on its own RecoveryMechanism and its supervisor's spec
+    void superviseFailure(size_t actor_id, uint64_t gen)
+    {
+        ActorSlot<Task>& slot = actor_slots_[actor_id];
+        RecoveryMechanism recovery;
+        std::string name;
+        {
+            SlotPin<Task> actor(slot);
+            // actor stopped, or already restarted by a group restart, since the failure was reported
+            if (!actor || (slot.gen_id.load(std::memory_order_acquire) != gen))
+                return;
+            recovery = actor->recovery_strategy_;
+            name = actor->name_;
+        }
+        // Not pinned from here on: stopAndRelease() waits for the pins, restartActor() pins again itself
+
+        switch (recovery)
+        {
+            case RecoveryMechanism::STOP:
+                stopAndRelease(actor_id);
+                return;
+            case RecoveryMechanism::IGNORE:
+                // resume with the same generation, mailbox and all
+                restartActor(actor_id,gen,false);
+                return;
+            default:
+                break;
+        }
+
+        size_t parent_id = slot.parent_id.load(std::memory_order_acquire);
+        if (restartIntensityExceeded(parent_id))
+        {
+            if (parent_id == NO_SUPERVISOR)
+            {
+                ACTOR_LOG_ERROR(name, "Restart intensity exceeded, stopping actor");
+                stopAndRelease(actor_id);
+                return;
+            }
+            // supervisor gives up, fail the supervisor itself. Its own restart takes this child along
+            SlotPin<Task> parent(actor_slots_[parent_id]);
+            if (parent && parent->escalateFailure())
+                notifyActorFailure(parent_id);
+            return;
+        }
+
+        SupervisionStrategy strategy = (parent_id == NO_SUPERVISOR) ? root_spec_.strategy
+                                        : actor_slots_[parent_id].child_strategy.load(std::memory_order_acquire);
+        restartActor(actor_id,gen,true);
+        restartChildren(actor_id);
+        if (strategy == SupervisionStrategy::ONE_FOR_ONE)
+            return;
+
+        uint64_t failed_order = slot.start_order.load(std::memory_order_relaxed);
+        for (size_t sibling=0; sibling<total_actors_; sibling++)
+        {
+            if ((sibling == actor_id) || !actor_slots_[sibling].is_valid.load(std::memory_order_acquire)
+                || (actor_slots_[sibling].parent_id.load(std::memory_order_acquire) != parent_id))
+                continue;
+            if ((strategy == SupervisionStrategy::REST_FOR_ONE)
+                && (actor_slots_[sibling].start_order.load(std::memory_order_relaxed) < failed_order))
+                continue;
+            // top level "siblings" are every other actor in the system, ONE_FOR_ALL at root restarts them all
+            restartSubtree(sibling);
+        }
+    }
+
+    // Counts a restart against the supervisor, true if it had too many restarts within its window
+    bool restartIntensityExceeded(size_t supervisor_id)
+    {
+        size_t max_restarts;
+        int64_t window_ns;
+        std::atomic<int64_t>* window_start;
+        std::atomic<size_t>* restarts;
+
+        if (supervisor_id == NO_SUPERVISOR)
+        {
+            max_restarts = root_spec_.max_restarts;
+            window_ns = root_spec_.window.count()*1000000;
+            window_start = &root_window_start_ns_;
+            restarts = &root_restarts_in_window_;
+        }
+        else
+        {
+            ActorSlot<Task>& supervisor = actor_slots_[supervisor_id];
+            max_restarts = supervisor.max_child_restarts.load(std::memory_order_relaxed);
+            window_ns = supervisor.restart_window_ms.load(std::memory_order_relaxed)*1000000;
+            window_start = &supervisor.window_start_ns;
+            restarts = &supervisor.restarts_in_window;
+        }
+        if (!max_restarts)
+            return false;
+
+        // start a new window if the current one is over. Racy on the window edge, which is fine for a rate limit
+        int64_t now = nowNs();
+        int64_t start = window_start->load(std::memory_order_relaxed);
+        if (now - start > window_ns)
+        {
+            if (window_start->compare_exchange_strong(start,now,std::memory_order_relaxed))
+                restarts->store(0,std::memory_order_relaxed);
+        }
+        return restarts->fetch_add(1,std::memory_order_relaxed) >= max_restarts;
+    }
+
+    // Restart an actor in place: no new Actor, no new mailbox, no registry update, just a new gen_id.
+    // Pinned throughout, so a concurrent stop() cannot destroy the actor under us, and an actor it already
+    // unregistered is left alone (the gen check alone misses that, stop() does not bump gen_id)
+    void restartActor(size_t actor_id, uint64_t gen, bool bump_gen)
+    {
+        ActorSlot<Task>& slot = actor_slots_[actor_id];
+        SlotPin<Task> actor(slot);
+        if (!actor || (slot.gen_id.load(std::memory_order_acquire) != gen))
+            return;
+
+        // A drain of this actor is still running or queued (it exits quickly since actor is not alive), or stop()
+        // holds the token. The restart waits on the token, handing it back requeues it via requeueParkedRestart()
+        if (!actor->claimDrainForRestart(bump_gen))
+            return;
+
+        uint64_t new_gen = bump_gen ? (slot.gen_id.fetch_add(1,std::memory_order_acq_rel)+1) : gen;
+        // a fresh supervisor gets a fresh restart budget for its children
+        if (bump_gen)
+            slot.restarts_in_window.store(0,std::memory_order_relaxed);
+        // being stopped meanwhile, token went back to stopActor()
+        if (!actor->restartInPlace(new_gen))
+            return;
+
+        int64_t failed_at = slot.failed_at_ns.exchange(0,std::memory_order_relaxed);
+        if (failed_at)
+        {
+            uint64_t latency = static_cast<uint64_t>(nowNs() - failed_at);
+            restart_latency_sum_ns_.fetch_add(latency,std::memory_order_relaxed);
+            uint64_t max_latency = restart_latency_max_ns_.load(std::memory_order_relaxed);
+            while ((latency > max_latency) 
+                    && !restart_latency_max_ns_.compare_exchange_weak(max_latency,latency,std::memory_order_relaxed)) {}
+        }
+        restart_count_.fetch_add(1,std::memory_order_relaxed);
+        pprof::instance().record(ActorModel::Profile::EventType::Restart, actor_id,new_gen,1234);
+    }
+
+    // Restart an actor that did not fail itself (sibling or child of a failed actor), and everything below it
+    void restartSubtree(size_t actor_id)
+    {
+        ActorSlot<Task>& slot = actor_slots_[actor_id];
+        {
+            SlotPin<Task> actor(slot);
+            if (!actor)
+                return;
+            actor->suspend();
+        }
+        uint64_t gen = slot.gen_id.load(std::memory_order_acquire);
+        requestSupervision(actor_id,SUPERVISE_RESTART,gen);
+        restartChildren(actor_id);
+    }
+
+    // A restarted supervisor starts over with fresh children
+    void restartChildren(size_t supervisor_id)
+    {
+        for (size_t child=0; child<total_actors_; child++)
+            if (actor_slots_[child].is_valid.load(std::memory_order_acquire)
+                && (actor_slots_[child].parent_id.load(std::memory_order_acquire) == supervisor_id))
+                restartSubtree(child);
+    }
+
+    // Supervisor decided this actor is gone for good
+    void stopAndRelease(size_t actor_id)
+    {
+        if (!unregisterActor(actor_id))
+            return;
+        stopChildren(actor_id);
+        releaseSlot(actor_id);
+    }
+
+    // Children don't outlive their supervisor
+    void stopChildren(size_t supervisor_id)
+    {
+        for (size_t child=0; child<total_actors_; child++)
+            if (actor_slots_[child].parent_id.load(std::memory_order_acquire) == supervisor_id)
+                stopAndRelease(child);
     }
 
     // Just logs the failure if an exception occurs when an actor is executing a task
     void logFailure(const std::string& failed_actor,Message<Task>&& msg)
     {
         //std::cout << "Terminating Actor: "<< failed_actor << " due to execption" << std::endl;
-        Logger::log(Level::Error, failed_actor, "Terminating Actor due to execption " );
+        ACTOR_LOG_ERROR(failed_actor, "Terminating Actor due to execption " );
         if(msg.request_reply)
         {
             if (!actor_registry_.contains(msg.sender_name))
@@ -584,38 +2143,74 @@ public:
     }
 
     // If actor at given idx exists, remove from the actor_pool_ and destroy the associated actor object
-    void unregisterActor(int idx)
+    // returns false if the slot was empty, or another thread is already tearing this actor down
+    bool unregisterActor(size_t idx)
     {
         std::unique_lock<std::shared_mutex> wrlock(registry_lock_);
+        return unregisterActor(idx,wrlock);
+    }
 
-        if (actor_slots_[idx].actor)
-        {
-            actor_registry_.erase(actor_slots_[idx].actor->name_);
-            wrlock.unlock();
-            actor_slots_[idx].actor->stopActor();
-            //std::cout << "Unregistering actor: " << actor_slots_[idx].actor->name_ <<  ":  " << actor_slots_[idx].actor.get() <<std::endl;
-            Logger::log(Level::Info, actor_slots_[idx].actor->name_, "Unregistering Actor" );
-            pprof::instance().record(ActorModel::Profile::EventType::Unregister,idx,actor_slots_[idx].gen_id, 1234);
-            actor_slots_[idx].is_valid.store(false,std::memory_order_release);    
-            actor_slots_[idx].actor.reset();
-            //else
-            //    std::cout << "Failed to destry actor!" << std::endl;
-        }
+    // Same as above, for callers already holding the registry write lock (the lock gets released inside)
+    bool unregisterActor(size_t idx, std::unique_lock<std::shared_mutex>& wrlock)
+    {
+        if (!actor_slots_[idx].actor)
+            return false;
+
+        // Whoever erases the registry entry owns the teardown of this actor, the rest back off.
+        // Otherwise a stop() and a supervisor giving up on the actor could both reset() the same slot
+        auto it = actor_registry_.find(actor_slots_[idx].actor->name_);
+        if ((it == actor_registry_.end()) || (it->second != idx))
+            return false;
+        // keep the node for the next spawn on this slot, see ActorSlot::registry_node
+        actor_slots_[idx].registry_node = actor_registry_.extract(it);
+        wrlock.unlock();
+
+        // Erasing the entry made us the owner, nobody else resets the slot, so the actor can be used unpinned here.
+        // stopActor() returns holding the drain token, pending drains have run and no restart can revive the actor
+        actor_slots_[idx].actor->stopActor();
+        //std::cout << "Unregistering actor: " << actor_slots_[idx].actor->name_ <<  ":  " << actor_slots_[idx].actor.get() <<std::endl;
+        ACTOR_LOG_INFO(actor_slots_[idx].actor->name_, "Unregistering Actor" );
+        pprof::instance().record(ActorModel::Profile::EventType::Unregister,idx,actor_slots_[idx].gen_id, 1234, actor_slots_[idx].actor->name_);
+        actor_slots_[idx].is_valid.store(false,std::memory_order_seq_cst);    
+        // a dedicated thread may be in the middle of a drain of this actor
+        stopDedicated(idx);
+        // supervision/restart tasks, or the tail of a drain that already gave the token back, may still be using it.
+        // New pins see is_valid false, so this only waits for the ones already running
+        while (actor_slots_[idx].pins.load(std::memory_order_seq_cst))
+            std::this_thread::yield();
+
+        // Pending msgs are destroyed outside the lock. The actor itself is kept for the next spawn on this slot,
+        // registerActor() checks the slot under the write lock, so take it again while emptying the slot
+        actor_slots_[idx].actor->dropMailbox();
+        wrlock.lock();
+        actor_slots_[idx].retired = std::move(actor_slots_[idx].actor);
+        wrlock.unlock();
+        return true;
+    }
+
+    // Slot is empty now and will not be respawned, make it available to spawn() again
+    void releaseSlot(size_t idx)
+    {
+        actor_slots_[idx].parent_id.store(NO_SUPERVISOR,std::memory_order_release);
+        actor_slots_[idx].dispatch_mode.store(DispatchMode::POOL,std::memory_order_release);
+        actor_slots_[idx].failed_at_ns.store(0,std::memory_order_relaxed);
+        actor_slots_[idx].restarts_in_window.store(0,std::memory_order_relaxed);
+        // requests still pending for the old tenant must not hit the next one, the slot may stay queued though
+        actor_slots_[idx].supervision.fetch_and(SUPERVISE_QUEUED,std::memory_order_acq_rel);
+        // bump generation, so that trace events of the next tenant of this slot are distinguishable
+        actor_slots_[idx].gen_id.fetch_add(1,std::memory_order_relaxed);
+        active_actors_.fetch_sub(1,std::memory_order_relaxed);
+        free_slots_.push(idx);
     }
 
     ~ActorSystem()
     {
-        pprof::instance().record(ActorModel::Profile::EventType::StopSystem,0,0, 1234);
+        pprof::instance().record(ActorModel::Profile::EventType::StopSystem,0,0, 1234, "ActorSystem");
+        stopMetricsDump();
+        stopShards();
         worker_pool_.stopPool();
-        if (cleanup_thread_.joinable())
-        {
-            {
-                std::unique_lock<std::mutex> cleanup_lock(cleanup_mtx_);
-                binned_actor_idx.push(total_actors_);
-            }
-            actors_pending_cleanup_.notify_all();
-            cleanup_thread_.join();
-        }
+        // queued drains/restarts still touch the actors, let them finish before the actors go
+        worker_pool_.joinWorkers();
 
         for(size_t i=0;i<total_actors_;i++)
             unregisterActor(i);
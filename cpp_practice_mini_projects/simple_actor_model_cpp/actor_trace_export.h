@@ -0,0 +1,363 @@
+#ifndef ACTOR_TRACE_EXPORT
+#define ACTOR_TRACE_EXPORT
+
+/* Offline side of the Profiler: read a binary trace (log/actor_trace_<ms>.bin) and export it
+    - csv for visual_tracer_prog.py (trace_to_csv)
+    - Chrome trace event JSON for ui.perfetto.dev / chrome://tracing (trace_to_perfetto)
+    Kept out of actor_model_logger_tracer.h, the actor system itself never needs any of this
+*/
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include "actor_model_logger_tracer.h"
+
+namespace ActorModel
+{
+    namespace Profile
+    {
+        class TraceFile
+        {
+        private:
+            std::ifstream in;
+            std::unordered_map<uint32_t,std::string> names[3];     // by TraceStringKind
+
+        public:
+            TraceFileHeader header;
+            uint64_t event_count = 0;
+            bool closed_cleanly = false;    // has a string table
+            std::string error;
+
+            // false if the file can't be used, see error
+            bool open(const std::string& path)
+            {
+                in.open(path, std::ios::in | std::ios::binary);
+                if (!in)
+                {
+                    error = "Cannot open " + path;
+                    return false;
+                }
+                if (!in.read(reinterpret_cast<char*>(&header),sizeof(header)) || std::memcmp(header.magic,TRACE_MAGIC,sizeof(header.magic)))
+                {
+                    error = path + " is not an actor trace";
+                    return false;
+                }
+                if ((header.version != TRACE_VERSION) || (header.event_size != sizeof(Event)))
+                {
+                    error = "Trace version " + std::to_string(header.version) + " / event size " + std::to_string(header.event_size)
+                            + " not supported, expected " + std::to_string(TRACE_VERSION) + " / " + std::to_string(sizeof(Event));
+                    return false;
+                }
+
+                event_count = header.event_count;
+                closed_cleanly = (header.string_table_offset != 0);
+                if (closed_cleanly)
+                {
+                    in.seekg(header.string_table_offset);
+                    TraceString entry;
+                    while (in.read(reinterpret_cast<char*>(&entry),sizeof(entry)))
+                    {
+                        std::string name(entry.len,'\0');
+                        in.read(name.data(),entry.len);
+                        if (static_cast<uint32_t>(entry.kind) < 3)
+                            names[static_cast<uint32_t>(entry.kind)][entry.id] = name;
+                    }
+                    in.clear();
+                }
+                else
+                {
+                    // process died before the Profiler was destroyed, take whatever whole events are there
+                    in.seekg(0,std::ios::end);
+                    event_count = (static_cast<uint64_t>(in.tellg()) - sizeof(header))/sizeof(Event);
+                }
+                return true;
+            }
+
+            // Without a string table, components and threads come out as their ids
+            std::string name(TraceStringKind kind, uint32_t id) const
+            {
+                auto& table = names[static_cast<uint32_t>(kind)];
+                auto it = table.find(id);
+                if (it != table.end())
+                    return it->second;
+                if (kind == TraceStringKind::EventType)
+                    return std::string(evtToStr(static_cast<EventType>(id)));
+                return (kind == TraceStringKind::Component) && (id == 0) ? "" : std::to_string(id);
+            }
+
+            size_t numThreads() const
+            {
+                return names[static_cast<uint32_t>(TraceStringKind::Thread)].size();
+            }
+
+            // Calls func(const Event&) for every event in file order (which is time order), returns the number of events read
+            template <typename Func>
+            uint64_t forEach(Func&& func)
+            {
+                in.clear();
+                in.seekg(sizeof(header));
+                std::vector<Event> events(4096);
+                uint64_t done = 0;
+                while (done < event_count)
+                {
+                    size_t chunk = std::min<uint64_t>(event_count - done,events.size());
+                    if (!in.read(reinterpret_cast<char*>(events.data()),chunk*sizeof(Event)))
+                    {
+                        error = "Trace truncated, " + std::to_string(event_count - done) + " events missing";
+                        break;
+                    }
+                    for (size_t i=0; i<chunk; i++)
+                        func(events[i]);
+                    done += chunk;
+                }
+                return done;
+            }
+        };
+
+        // timestamp is wall clock ms like the old csv traces, so the per ms plots keep working,
+        // timestamp_ns (ns since trace start) and component are extra columns
+        inline uint64_t writeCsv(TraceFile& trace, std::ostream& out)
+        {
+            out << "timestamp,actor_id,gen_id,thread_id,eventType,timestamp_ns,component\n";
+            return trace.forEach([&trace,&out](const Event& ev){
+                out << (trace.header.start_wall_ns + ev.time)/1000000 << "," << ev.actor_id << "," << ev.gen_id << ","
+                    << trace.name(TraceStringKind::Thread,ev.thread_idx) << "," << trace.name(TraceStringKind::EventType,static_cast<uint32_t>(ev.type))
+                    << "," << ev.time << "," << trace.name(TraceStringKind::Component,ev.component) << "\n";
+            });
+        }
+
+        /* Chrome trace event JSON (the format ui.perfetto.dev and chrome://tracing open)
+            - one track per recording thread, named after its std::thread::id
+            - slices: pool tasks (PoolDequeue -> PoolTaskEnd), drains (DrainStart -> DrainEnd) inside them,
+              and handling of each msg (Dequeue -> next Dequeue/DrainEnd on that thread) inside the drain
+            - every Enqueue is a zero length "send" slice with a flow arrow to the slice handling that msg,
+              msgs are matched on (actor_id, Message::trace_seq)
+            - counters: mailbox depth per actor, threadpool queue depth
+            - everything else (Register, Restart, Fail, drops...) are instant events on the thread that recorded them
+        */
+        class ChromeTraceWriter
+        {
+        private:
+            struct OpenSlice
+            {
+                enum class Kind { PoolTask, Drain, Msg } kind;
+                uint64_t start_ns;
+                uint64_t actor_id;
+                uint64_t flow_id;   // 0 = no flow into this slice
+            };
+
+            TraceFile& trace;
+            std::ostream& out;
+            bool first = true;
+            std::unordered_map<uint32_t,std::vector<OpenSlice>> open_slices;    // by thread_idx
+            std::unordered_map<uint64_t,std::string> actor_names;             // by actor_id, from Register
+            std::unordered_map<uint64_t,int64_t> mailbox_depth;               // by actor_id
+            std::map<std::pair<uint64_t,uint32_t>,uint64_t> pending_flows;     // (actor_id, trace_seq) -> flow id
+            uint64_t next_flow_id = 1;
+            int64_t pool_depth = 0;
+            uint64_t last_ns = 0;
+
+            static std::string escape(const std::string& text)
+            {
+                std::string escaped;
+                for (char c: text)
+                {
+                    if ((c == '"') || (c == '\\'))
+                        escaped += '\\';
+                    if (static_cast<unsigned char>(c) < 0x20)
+                        continue;
+                    escaped += c;
+                }
+                return escaped;
+            }
+
+            static std::string usec(uint64_t ns)
+            {
+                char buf[32];
+                std::snprintf(buf,sizeof(buf),"%llu.%03llu",static_cast<unsigned long long>(ns/1000),static_cast<unsigned long long>(ns%1000));
+                return buf;
+            }
+
+            const std::string& actorName(uint64_t actor_id)
+            {
+                auto it = actor_names.find(actor_id);
+                if (it == actor_names.end())
+                    it = actor_names.emplace(actor_id,"actor" + std::to_string(actor_id)).first;
+                return it->second;
+            }
+
+            // starts a trace event object, caller adds its own fields and the closing brace
+            std::ostream& begin(const char* phase, const std::string& name, uint64_t ts_ns, uint32_t tid)
+            {
+                out << (first ? "\n" : ",\n") << "{\"ph\":\"" << phase << "\",\"name\":\"" << escape(name)
+                    << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << usec(ts_ns);
+                first = false;
+                return out;
+            }
+
+            void closeSlice(uint32_t tid, const OpenSlice& slice, uint64_t end_ns)
+            {
+                const char* names[] = {"pool task","drain ","msg "};
+                std::string name = names[static_cast<int>(slice.kind)];
+                if (slice.kind != OpenSlice::Kind::PoolTask)
+                    name += actorName(slice.actor_id);
+                begin("X",name,slice.start_ns,tid) << ",\"dur\":" << usec(end_ns - slice.start_ns);
+                if (slice.kind != OpenSlice::Kind::PoolTask)
+                    out << ",\"args\":{\"actor_id\":" << slice.actor_id << "}";
+                if (slice.flow_id)
+                    out << ",\"bind_id\":" << slice.flow_id << ",\"flow_in\":true";
+                out << "}";
+            }
+
+            // pops (and writes) open slices of the thread till one of kind is closed.
+            // Nothing if there is no such slice, its start may be missing from a sampled trace
+            void closeUpTo(uint32_t tid, OpenSlice::Kind kind, uint64_t end_ns)
+            {
+                auto& stack = open_slices[tid];
+                if (std::none_of(stack.begin(),stack.end(),[kind](const OpenSlice& slice){ return slice.kind == kind; }))
+                    return;
+                while (!stack.empty())
+                {
+                    OpenSlice slice = stack.back();
+                    stack.pop_back();
+                    closeSlice(tid,slice,end_ns);
+                    if (slice.kind == kind)
+                        return;
+                }
+            }
+
+            // a msg slice ends where the thread moves on to the next msg, or its drain ends
+            void closeMsg(uint32_t tid, uint64_t end_ns)
+            {
+                auto& stack = open_slices[tid];
+                if (!stack.empty() && (stack.back().kind == OpenSlice::Kind::Msg))
+                {
+                    closeSlice(tid,stack.back(),end_ns);
+                    stack.pop_back();
+                }
+            }
+
+            void counter(const std::string& name, uint64_t ts_ns, int64_t value)
+            {
+                begin("C",name,ts_ns,0) << ",\"args\":{\"depth\":" << (value < 0 ? 0 : value) << "}}";
+            }
+
+            void mailboxChanged(uint64_t actor_id, uint64_t ts_ns, int64_t delta)
+            {
+                int64_t& depth = mailbox_depth[actor_id];
+                depth = std::max<int64_t>(0,depth + delta);
+                counter("mailbox " + actorName(actor_id),ts_ns,depth);
+            }
+
+            void instant(const Event& ev)
+            {
+                std::string name = trace.name(TraceStringKind::EventType,static_cast<uint32_t>(ev.type));
+                if ((ev.type != EventType::StopSystem) && (ev.type != EventType::Register))
+                    name += " " + actorName(ev.actor_id);
+                else if (ev.type == EventType::Register)
+                    name += " " + trace.name(TraceStringKind::Component,ev.component);
+                begin("i",name,ev.time,ev.thread_idx) << ",\"s\":\"t\",\"args\":{\"actor_id\":" << ev.actor_id
+                                                       << ",\"gen_id\":" << ev.gen_id << "}}";
+            }
+
+            void add(const Event& ev)
+            {
+                uint32_t tid = ev.thread_idx;
+                last_ns = std::max(last_ns,ev.time);
+                switch (ev.type)
+                {
+                    case EventType::PoolEnqueue:
+                        counter("threadpool queue",ev.time,++pool_depth);
+                        break;
+                    case EventType::PoolDequeue:
+                        counter("threadpool queue",ev.time,--pool_depth);
+                        open_slices[tid].push_back({OpenSlice::Kind::PoolTask,ev.time,0,0});
+                        break;
+                    case EventType::PoolTaskEnd:
+                        closeUpTo(tid,OpenSlice::Kind::PoolTask,ev.time);
+                        break;
+                    case EventType::DrainStart:
+                        closeMsg(tid,ev.time);
+                        open_slices[tid].push_back({OpenSlice::Kind::Drain,ev.time,ev.actor_id,0});
+                        break;
+                    case EventType::DrainEnd:
+                        closeUpTo(tid,OpenSlice::Kind::Drain,ev.time);
+                        break;
+                    case EventType::Enqueue:
+                    {
+                        uint64_t flow_id = next_flow_id++;
+                        pending_flows[{ev.actor_id,ev.payload}] = flow_id;
+                        begin("X","send to " + actorName(ev.actor_id),ev.time,tid) << ",\"dur\":0,\"bind_id\":" << flow_id
+                                                                                  << ",\"flow_out\":true}";
+                        mailboxChanged(ev.actor_id,ev.time,1);
+                        break;
+                    }
+                    case EventType::Dequeue:
+                    {
+                        closeMsg(tid,ev.time);
+                        uint64_t flow_id = 0;
+                        auto it = pending_flows.find({ev.actor_id,ev.payload});
+                        if (it != pending_flows.end())
+                        {
+                            flow_id = it->second;
+                            pending_flows.erase(it);
+                        }
+                        open_slices[tid].push_back({OpenSlice::Kind::Msg,ev.time,ev.actor_id,flow_id});
+                        mailboxChanged(ev.actor_id,ev.time,-1);
+                        break;
+                    }
+                    case EventType::DropOldest:
+                        pending_flows.erase({ev.actor_id,ev.payload});
+                        mailboxChanged(ev.actor_id,ev.time,-1);
+                        instant(ev);
+                        break;
+                    case EventType::Register:
+                        if (ev.component)
+                            actor_names[ev.actor_id] = trace.name(TraceStringKind::Component,ev.component);
+                        instant(ev);
+                        break;
+                    case EventType::Unregister:
+                        instant(ev);
+                        mailbox_depth[ev.actor_id] = 0;
+                        counter("mailbox " + actorName(ev.actor_id),ev.time,0);
+                        break;
+                    default:
+                        instant(ev);
+                        break;
+                }
+            }
+
+        public:
+            ChromeTraceWriter(TraceFile& trace_file, std::ostream& output): trace(trace_file), out(output) {}
+
+            // returns the number of trace events read
+            uint64_t write()
+            {
+                out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+                begin("M","process_name",0,0) << ",\"args\":{\"name\":\"ActorSystem\"}}";
+                for (uint32_t idx=0; idx<trace.numThreads(); idx++)
+                    begin("M","thread_name",0,idx) << ",\"args\":{\"name\":\"thread " << idx << " ("
+                                                    << escape(trace.name(TraceStringKind::Thread,idx)) << ")\"}}";
+
+                uint64_t count = trace.forEach([this](const Event& ev){ add(ev); });
+
+                // slices still open at the end of the trace (process stopped mid drain), end them with the trace
+                for (auto& [tid,stack]: open_slices)
+                    while (!stack.empty())
+                    {
+                        closeSlice(tid,stack.back(),last_ns);
+                        stack.pop_back();
+                    }
+                out << "\n]}\n";
+                return count;
+            }
+        };
+    };
+}
+
+#endif /* ACTOR_TRACE_EXPORT */
@@ -0,0 +1,46 @@
+/* Converts a binary Profiler trace (log/actor_trace_<ms>.bin) to the csv visual_tracer_prog.py reads
+    usage: ./trace_to_csv log/actor_trace_<ms>.bin [out.csv]      (default out: same name, .csv)
+    - timestamp is wall clock ms like the old csv traces, so the per ms plots keep working,
+      timestamp_ns (ns since trace start) and component are extra columns
+    - A trace without string table (process died before the Profiler was destroyed) is still converted,
+      event count then comes from the file size and components/threads are printed as ids
+*/
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "actor_trace_export.h"
+
+using namespace ActorModel::Profile;
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace.bin> [out.csv]" << std::endl;
+        return 1;
+    }
+    std::string in_path = argv[1];
+    std::string out_path = (argc > 2) ? argv[2] : in_path.substr(0,in_path.rfind('.')) + ".csv";
+
+    TraceFile trace;
+    if (!trace.open(in_path))
+    {
+        std::cerr << trace.error << std::endl;
+        return 1;
+    }
+    if (!trace.closed_cleanly)
+        std::cerr << "No string table, trace was not closed cleanly. Converting " << trace.event_count << " events" << std::endl;
+
+    std::ofstream out(out_path, std::ios::out);
+    if (!out)
+    {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        return 1;
+    }
+    uint64_t written = writeCsv(trace,out);
+    if (!trace.error.empty())
+        std::cerr << trace.error << std::endl;
+
+    std::cout << "Wrote " << written << " events to " << out_path << std::endl;
+    return 0;
+}
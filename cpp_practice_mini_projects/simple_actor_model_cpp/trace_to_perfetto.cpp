@@ -0,0 +1,46 @@
+/* Converts a binary Profiler trace (log/actor_trace_<ms>.bin) to Chrome trace event JSON
+    usage: ./trace_to_perfetto log/actor_trace_<ms>.bin [out.json]    (default out: same name, .json)
+    Open the json in ui.perfetto.dev (or chrome://tracing): a track per thread with pool task / drain / msg slices,
+    flow arrows from each send to the handling of that msg, mailbox and threadpool queue depth counters.
+    See ChromeTraceWriter in actor_trace_export.h
+*/
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "actor_trace_export.h"
+
+using namespace ActorModel::Profile;
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace.bin> [out.json]" << std::endl;
+        return 1;
+    }
+    std::string in_path = argv[1];
+    std::string out_path = (argc > 2) ? argv[2] : in_path.substr(0,in_path.rfind('.')) + ".json";
+
+    TraceFile trace;
+    if (!trace.open(in_path))
+    {
+        std::cerr << trace.error << std::endl;
+        return 1;
+    }
+    if (!trace.closed_cleanly)
+        std::cerr << "No string table, trace was not closed cleanly. Converting " << trace.event_count << " events" << std::endl;
+
+    std::ofstream out(out_path, std::ios::out);
+    if (!out)
+    {
+        std::cerr << "Cannot write " << out_path << std::endl;
+        return 1;
+    }
+    ChromeTraceWriter writer(trace,out);
+    uint64_t written = writer.write();
+    if (!trace.error.empty())
+        std::cerr << trace.error << std::endl;
+
+    std::cout << "Wrote " << written << " events to " << out_path << std::endl;
+    return 0;
+}
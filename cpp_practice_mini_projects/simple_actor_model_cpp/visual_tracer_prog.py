@@ -126,7 +126,7 @@ def summaryByEvent(evtlog):
 print("This program")
 
 parser = argparse.ArgumentParser("Parsing cmd line arguments")
-parser.add_argument("logpath", type=str,help = "Name of log file in ./log directory")
+parser.add_argument("logpath", type=str,help = "csv trace in ./log directory (convert the .bin trace with ./trace_to_csv first)")
 args = parser.parse_args()
 
 evtlog = parse_csv(f"{args.logpath}")
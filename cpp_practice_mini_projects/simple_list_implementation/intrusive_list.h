@@ -0,0 +1,318 @@
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <cstddef>
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+
+/*
+Intrusive doubly linked list, the boost::intrusive::list idea in small
+    - dList<T> owns its nodes, every element lives in a dNode allocated by the list.
+      Here the links live inside the element itself (a ListHook), the list only strings existing objects together.
+      So no allocation on insert, and unlinking an element we hold a reference to is O(1), no search.
+    - An element can sit on as many lists as it has hooks, e.g. an actor on the run queue and on a timer list.
+      Hooks come in two flavours:
+        base hook:   struct Timer : ListBaseHook<ByDeadline>, ListBaseHook<ByOwner> {...}
+                     IntrusiveList<Timer, BaseHook<Timer,ByDeadline>>
+        member hook: struct Frame { ListHook queueHook; ... }
+                     IntrusiveList<Frame, MemberHook<Frame,&Frame::queueHook>>
+    - The list does not own anything. Elements must outlive their membership, and clear()/~IntrusiveList
+      only unlink, they never destroy elements.
+    - Safe mode (asserts, i.e. builds without NDEBUG): linking an element that is already linked,
+      unlinking one that is not or that is on another list, and destroying an element that is still on a list
+      all abort right there, instead of silently corrupting some other list. The hook remembers its list for that,
+      one pointer more per hook in debug builds only.
+*/
+
+// The links embedded in an element. Unlinked hooks have null pointers, so isLinked() is always accurate
+class ListHook {
+private:
+    ListHook* next = nullptr;
+    ListHook* prev = nullptr;
+#ifndef NDEBUG
+    // the IntrusiveList this hook is linked into, erase(T&) on another list with the same hook type would
+    // otherwise unlink it fine and leave both counts wrong
+    const void* owner = nullptr;
+#endif
+
+    template <typename T, typename Hooks> friend class IntrusiveList;
+    template <typename T, typename Hooks, bool IsConst> friend class IntrusiveListIterator;
+
+public:
+    ListHook() = default;
+
+    // Copying an element must not put the copy on the original's lists (or break the original's links)
+    ListHook(const ListHook&) noexcept {}
+    ListHook& operator=(const ListHook&) noexcept { return *this; }
+
+    bool isLinked() const {
+        return next != nullptr;
+    }
+
+    ~ListHook()
+    {
+        // an element dying while still on a list leaves its neighbours pointing at freed memory
+        assert(!isLinked() && "element destroyed while still linked into an IntrusiveList");
+    }
+};
+
+// Base class hook, Tag tells apart the hooks of an element that is on several lists
+struct DefaultHookTag {};
+
+template <typename Tag = DefaultHookTag>
+class ListBaseHook : public ListHook {};
+
+// Hook accessors, the list only needs element -> hook and back
+template <typename T, typename Tag = DefaultHookTag>
+struct BaseHook {
+    static ListHook* toHook(T* value) {
+        return static_cast<ListBaseHook<Tag>*>(value);
+    }
+    static T* toValue(ListHook* hook) {
+        return static_cast<T*>(static_cast<ListBaseHook<Tag>*>(hook));
+    }
+};
+
+template <typename T, ListHook T::*Member>
+struct MemberHook {
+    static ListHook* toHook(T* value) {
+        return &(value->*Member);
+    }
+    static T* toValue(ListHook* hook) {
+        // container_of: step back from the member to the start of the element.
+        // Offset is computed on a fake address, same thing offsetof does under the hood
+        const std::ptrdiff_t offset = reinterpret_cast<char*>(&(reinterpret_cast<T*>(0x1000)->*Member)) - reinterpret_cast<char*>(0x1000);
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - offset);
+    }
+};
+
+template <typename T, typename Hooks, bool IsConst>
+class IntrusiveListIterator {
+private:
+    ListHook* current = nullptr;
+
+    template <typename U, typename H> friend class IntrusiveList;
+    template <typename U, typename H, bool C> friend class IntrusiveListIterator;
+
+    explicit IntrusiveListIterator(ListHook* hook) : current(hook) {}
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const T*, T*>;
+    using reference = std::conditional_t<IsConst, const T&, T&>;
+
+    IntrusiveListIterator() = default;
+
+    // iterator -> const_iterator
+    template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+    IntrusiveListIterator(const IntrusiveListIterator<T, Hooks, WasConst>& other) : current(other.current) {}
+
+    reference operator*() const {
+        return *Hooks::toValue(current);
+    }
+
+    pointer operator->() const {
+        return Hooks::toValue(current);
+    }
+
+    IntrusiveListIterator& operator++() {
+        current = current->next;
+        return *this;
+    }
+
+    IntrusiveListIterator operator++(int) {
+        IntrusiveListIterator old = *this;
+        current = current->next;
+        return old;
+    }
+
+    IntrusiveListIterator& operator--() {
+        current = current->prev;
+        return *this;
+    }
+
+    IntrusiveListIterator operator--(int) {
+        IntrusiveListIterator old = *this;
+        current = current->prev;
+        return old;
+    }
+
+    friend bool operator==(const IntrusiveListIterator& lhs, const IntrusiveListIterator& rhs) {
+        return lhs.current == rhs.current;
+    }
+
+    friend bool operator!=(const IntrusiveListIterator& lhs, const IntrusiveListIterator& rhs) {
+        return lhs.current != rhs.current;
+    }
+};
+
+// Circular list around a sentinel hook (root), so insert/unlink never have to special case head or tail
+template <typename T, typename Hooks = BaseHook<T>>
+class IntrusiveList {
+private:
+    ListHook root;
+    std::size_t count = 0;
+
+    void linkBefore(ListHook* position, ListHook* hook)
+    {
+        assert(!hook->isLinked() && "element is already linked into a list through this hook");
+#ifndef NDEBUG
+        hook->owner = this;
+#endif
+        hook->next = position;
+        hook->prev = position->prev;
+        position->prev->next = hook;
+        position->prev = hook;
+        count++;
+    }
+
+    void unlink(ListHook* hook)
+    {
+        assert(hook->isLinked() && "element is not linked into a list through this hook");
+        assert(hook != &root);
+        assert(ownedHere(hook) && "element is linked into another list through this hook");
+        hook->prev->next = hook->next;
+        hook->next->prev = hook->prev;
+        hook->next = nullptr;
+        hook->prev = nullptr;
+#ifndef NDEBUG
+        hook->owner = nullptr;
+#endif
+        count--;
+    }
+
+    // safe mode only, always true with NDEBUG
+    bool ownedHere([[maybe_unused]] const ListHook* hook) const
+    {
+#ifndef NDEBUG
+        return hook->owner == this;
+#else
+        return true;
+#endif
+    }
+
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using iterator = IntrusiveListIterator<T, Hooks, false>;
+    using const_iterator = IntrusiveListIterator<T, Hooks, true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    IntrusiveList()
+    {
+        root.next = &root;
+        root.prev = &root;
+    }
+
+    // Elements know their neighbours by address, so a copy would have to relink them all. Not worth it
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    ~IntrusiveList()
+    {
+        clear();
+        // root is a ListHook too, quiet its own "still linked" check
+        root.next = nullptr;
+        root.prev = nullptr;
+    }
+
+    iterator begin() { return iterator(root.next); }
+    iterator end() { return iterator(&root); }
+    const_iterator begin() const { return const_iterator(root.next); }
+    const_iterator end() const { return const_iterator(const_cast<ListHook*>(&root)); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    T& front() {
+        assert(!empty());
+        return *Hooks::toValue(root.next);
+    }
+
+    T& back() {
+        assert(!empty());
+        return *Hooks::toValue(root.prev);
+    }
+
+    void push_back(T& value) {
+        linkBefore(&root, Hooks::toHook(&value));
+    }
+
+    void push_front(T& value) {
+        linkBefore(root.next, Hooks::toHook(&value));
+    }
+
+    void pop_front() {
+        assert(!empty());
+        unlink(root.next);
+    }
+
+    void pop_back() {
+        assert(!empty());
+        unlink(root.prev);
+    }
+
+    // Link value just before position, returns an iterator to it
+    iterator insert(const_iterator position, T& value)
+    {
+        ListHook* hook = Hooks::toHook(&value);
+        linkBefore(position.current, hook);
+        return iterator(hook);
+    }
+
+    // Unlink the element at position (not destroyed), returns the next one
+    iterator erase(const_iterator position)
+    {
+        ListHook* next = position.current->next;
+        unlink(position.current);
+        return iterator(next);
+    }
+
+    // O(1) unlink of an element we hold, it must be on this list through this list's hook
+    void erase(T& value) {
+        unlink(Hooks::toHook(&value));
+    }
+
+    // Iterator to an element already on this list, no search needed
+    iterator iteratorTo(T& value) {
+        assert(ownedHere(Hooks::toHook(&value)) && "element is not on this list");
+        return iterator(Hooks::toHook(&value));
+    }
+
+    // Unlinks every element, the elements themselves stay alive
+    void clear()
+    {
+        ListHook* hook = root.next;
+        while (hook != &root) {
+            ListHook* next = hook->next;
+            hook->next = nullptr;
+            hook->prev = nullptr;
+#ifndef NDEBUG
+            hook->owner = nullptr;
+#endif
+            hook = next;
+        }
+        root.next = &root;
+        root.prev = &root;
+        count = 0;
+    }
+};
+
+#endif // INTRUSIVE_LIST_H
@@ -0,0 +1,236 @@
+#ifndef LOCK_FREE_LIST_H
+#define LOCK_FREE_LIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "node_slab_allocator.h"
+#include "../simple_memory_reclamation/epoch_reclamation.h"
+
+/*
+Lock-free sorted linked list used as a set of keys (Harris 2001, with Michael's 2002 changes)
+    - dList is single threaded. This one takes insert/erase/contains from any number of threads, no locks.
+    - Erasing is two steps:
+        1. logical delete: set the lowest bit ("mark") of the victim's own next pointer with a CAS.
+           From then on nobody can link anything after it, a CAS expecting the unmarked value fails.
+        2. physical delete: CAS the predecessor's next from victim to victim's successor.
+      Step 1 decides who erased the key. Step 2 may be done by anyone, every search unlinks
+      the marked nodes it walks over, so a slow eraser never blocks the others.
+    - Without the mark, erasing B in A->B->C while someone inserts X after B (B->X->C) loses X:
+      both CASes succeed on different pointers. With the mark the insert's CAS on B->next fails and it retries.
+    - Unlinked nodes go to the EpochReclaimer, every operation holds an EpochGuard, so a node someone is still
+      standing on is never freed under them.
+    - contains() never writes anything: it walks past marked nodes and checks the mark of the one it lands on.
+    - O(n) per operation, fine for short lists (subscribers of a topic, ...). LockFreeSkipList is the O(log n) version.
+*/
+
+// Helpers for next pointers that carry the "deleted" mark in their lowest bit. Nodes are at least pointer aligned, so it is free
+struct MarkedPtr {
+    static bool isMarked(std::uintptr_t link) {
+        return link & 1;
+    }
+    static std::uintptr_t marked(std::uintptr_t link) {
+        return link | 1;
+    }
+    static std::uintptr_t unmarked(std::uintptr_t link) {
+        return link & ~std::uintptr_t(1);
+    }
+    template <typename Node>
+    static Node* node(std::uintptr_t link) {
+        return reinterpret_cast<Node*>(unmarked(link));
+    }
+    template <typename Node>
+    static std::uintptr_t link(Node* node) {
+        return reinterpret_cast<std::uintptr_t>(node);
+    }
+};
+
+template <typename Key, typename Compare = std::less<Key>>
+class LockFreeList {
+private:
+    struct Node {
+        const Key key;
+        std::atomic<std::uintptr_t> next{0};
+
+        template <typename... Args>
+        explicit Node(Args&&... args) : key(std::forward<Args>(args)...) {}
+    };
+
+    using Link = std::atomic<std::uintptr_t>;
+    // nodes come from the thread cached slab pool, the reclaimer may free them on another thread than the one that allocated
+    using NodeAlloc = SlabAllocator<Node>;
+
+    Link head{0};
+    std::atomic<std::size_t> count{0};
+    [[no_unique_address]] Compare less;
+
+    template <typename... Args>
+    static Node* createNode(Args&&... args)
+    {
+        NodeAlloc alloc;
+        Node* node = alloc.allocate(1);
+        try {
+            ::new (static_cast<void*>(node)) Node(std::forward<Args>(args)...);
+        } catch (...) {
+            alloc.deallocate(node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    static void destroyNode(void* ptr)
+    {
+        Node* node = static_cast<Node*>(ptr);
+        node->~Node();
+        NodeAlloc().deallocate(node, 1);
+    }
+
+    bool equal(const Key& lhs, const Key& rhs) const {
+        return !less(lhs, rhs) && !less(rhs, lhs);
+    }
+
+    // One pass of find(), false if a CAS lost a race and the search has to start over
+    bool tryFind(const Key& key, Link*& prev, Node*& curr, bool& found)
+    {
+        prev = &head;
+        curr = MarkedPtr::node<Node>(prev->load(std::memory_order_acquire));
+        while (curr) {
+            std::uintptr_t succ = curr->next.load(std::memory_order_acquire);
+            if (MarkedPtr::isMarked(succ)) {
+                // curr is erased, unlink it on the way. Fails if prev changed or prev itself got marked
+                std::uintptr_t expected = MarkedPtr::link(curr);
+                if (!prev->compare_exchange_strong(expected, MarkedPtr::unmarked(succ), std::memory_order_acq_rel, std::memory_order_relaxed))
+                    return false;
+                EpochReclaimer::retire(curr, &destroyNode);
+                curr = MarkedPtr::node<Node>(succ);
+                continue;
+            }
+            if (!less(curr->key, key)) {
+                found = !less(key, curr->key);
+                return true;
+            }
+            prev = &curr->next;
+            curr = MarkedPtr::node<Node>(succ);
+        }
+        found = false;
+        return true;
+    }
+
+    // curr = first unmarked node with key >= key (or null), *prev = the link pointing at it.
+    // Returns whether curr holds key. Caller must hold an EpochGuard
+    bool find(const Key& key, Link*& prev, Node*& curr)
+    {
+        bool found = false;
+        while (!tryFind(key, prev, curr, found)) {
+        }
+        return found;
+    }
+
+    bool insertNode(Node* node)
+    {
+        EpochGuard guard;
+        Link* prev;
+        Node* curr;
+        while (true) {
+            if (find(node->key, prev, curr)) {
+                destroyNode(node);   // never published, no need to go through the reclaimer
+                return false;
+            }
+            node->next.store(MarkedPtr::link(curr), std::memory_order_relaxed);
+            std::uintptr_t expected = MarkedPtr::link(curr);
+            // release: whoever reaches the node through prev sees its key
+            if (prev->compare_exchange_strong(expected, MarkedPtr::link(node), std::memory_order_release, std::memory_order_relaxed)) {
+                count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+public:
+    LockFreeList() = default;
+    explicit LockFreeList(Compare comp) : less(std::move(comp)) {}
+
+    LockFreeList(const LockFreeList&) = delete;
+    LockFreeList& operator=(const LockFreeList&) = delete;
+
+    // No other thread may use the list anymore. Nodes already unlinked belong to the reclaimer, only the linked ones are freed here
+    ~LockFreeList()
+    {
+        Node* node = MarkedPtr::node<Node>(head.load(std::memory_order_acquire));
+        while (node) {
+            Node* next = MarkedPtr::node<Node>(node->next.load(std::memory_order_relaxed));
+            destroyNode(node);
+            node = next;
+        }
+    }
+
+    // false if the key was already there
+    bool insert(const Key& key) {
+        return insertNode(createNode(key));
+    }
+
+    bool insert(Key&& key) {
+        return insertNode(createNode(std::move(key)));
+    }
+
+    // false if the key was not there (or another thread erased it first)
+    bool erase(const Key& key)
+    {
+        EpochGuard guard;
+        Link* prev;
+        Node* curr;
+        while (true) {
+            if (!find(key, prev, curr))
+                return false;
+            std::uintptr_t succ = curr->next.load(std::memory_order_acquire);
+            if (MarkedPtr::isMarked(succ))
+                continue;   // someone else is erasing it, search again to see how that ended
+            if (!curr->next.compare_exchange_weak(succ, MarkedPtr::marked(succ), std::memory_order_acq_rel, std::memory_order_relaxed))
+                continue;
+            // erased as far as everybody else is concerned, now try to unlink it ourselves
+            count.fetch_sub(1, std::memory_order_relaxed);
+            std::uintptr_t expected = MarkedPtr::link(curr);
+            if (prev->compare_exchange_strong(expected, succ, std::memory_order_acq_rel, std::memory_order_relaxed))
+                EpochReclaimer::retire(curr, &destroyNode);
+            else
+                find(key, prev, curr);   // the list changed around it, a search unlinks it
+            return true;
+        }
+    }
+
+    bool contains(const Key& key) const
+    {
+        EpochGuard guard;
+        Node* curr = MarkedPtr::node<Node>(head.load(std::memory_order_acquire));
+        while (curr && less(curr->key, key))
+            curr = MarkedPtr::node<Node>(curr->next.load(std::memory_order_acquire));
+        return curr && equal(curr->key, key) && !MarkedPtr::isMarked(curr->next.load(std::memory_order_acquire));
+    }
+
+    // Calls func(key) in order for the keys not erased at the moment it passes them. Not a snapshot
+    template <typename Func>
+    void forEach(Func&& func) const
+    {
+        EpochGuard guard;
+        Node* curr = MarkedPtr::node<Node>(head.load(std::memory_order_acquire));
+        while (curr) {
+            std::uintptr_t succ = curr->next.load(std::memory_order_acquire);
+            if (!MarkedPtr::isMarked(succ))
+                func(curr->key);
+            curr = MarkedPtr::node<Node>(succ);
+        }
+    }
+
+    // Exact when no other thread is changing the list, otherwise a recent value
+    std::size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+};
+
+#endif // LOCK_FREE_LIST_H
@@ -0,0 +1,140 @@
+/* Scaling of the concurrent sets, 1 to 32 threads
+    - LockFreeList, LockFreeSkipList, and a std::set behind a std::shared_mutex as the baseline
+    - every thread runs random ops on random keys for a fixed time: contains for the read share,
+      insert and erase half/half for the rest, so the set stays around half full
+    - read shares 90%, 50%, 10%
+    - LockFreeList is O(n), it only gets the small key range
+Prints total throughput in Mops/s, more threads than cores just shows how each one copes with preemption
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <set>
+#include <string>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+#include "lock_free_list.h"
+#include "lock_free_skiplist.h"
+
+// std::set with a reader/writer lock, what we would write without the lock-free ones
+class LockedSet {
+private:
+    std::set<uint64_t> set;
+    mutable std::shared_mutex mtx;
+
+public:
+    bool insert(uint64_t key) {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        return set.insert(key).second;
+    }
+
+    bool erase(uint64_t key) {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        return set.erase(key) == 1;
+    }
+
+    bool contains(uint64_t key) const {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        return set.count(key) == 1;
+    }
+};
+
+// xorshift, a shared std::mt19937 or a lock around one would be the bottleneck
+struct FastRng {
+    uint64_t state;
+    explicit FastRng(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t operator()() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+static volatile uint64_t sink = 0;
+
+template <typename Set>
+double runMix(size_t num_threads, uint64_t key_range, unsigned read_percent, std::chrono::milliseconds duration)
+{
+    Set set;
+    // start half full
+    FastRng fill_rng(1);
+    for (uint64_t i = 0; i < key_range / 2; i++)
+        set.insert(fill_rng() % key_range);
+
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> ops(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            FastRng rng(t + 2);
+            uint64_t done = 0;
+            uint64_t hits = 0;
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                // a batch between checks of the stop flag
+                for (int i = 0; i < 64; i++) {
+                    uint64_t r = rng();
+                    uint64_t key = (r >> 8) % key_range;
+                    unsigned roll = r % 100;
+                    if (roll < read_percent)
+                        hits += set.contains(key);
+                    else if (roll & 1)
+                        hits += set.insert(key);
+                    else
+                        hits += set.erase(key);
+                }
+                done += 64;
+            }
+            ops[t] = done;
+            sink = hits;
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t total = 0;
+    for (uint64_t count : ops)
+        total += count;
+    return total / seconds / 1e6;
+}
+
+template <typename Set>
+void benchSet(const std::string& name, uint64_t key_range)
+{
+    const size_t thread_counts[] = {1, 2, 4, 8, 16, 32};
+    std::cout << std::left << std::setw(40) << (name + ", " + std::to_string(key_range) + " keys") << std::right;
+    for (size_t num_threads : thread_counts)
+        std::cout << std::setw(8) << (std::to_string(num_threads) + "T");
+    std::cout << "  (Mops/s)" << std::endl;
+
+    for (unsigned read_percent : {90u, 50u, 10u}) {
+        std::cout << std::left << std::setw(40) << ("    " + std::to_string(read_percent) + "% reads") << std::right
+                  << std::fixed << std::setprecision(2);
+        for (size_t num_threads : thread_counts)
+            std::cout << std::setw(8) << runMix<Set>(num_threads, key_range, read_percent, std::chrono::milliseconds(200));
+        std::cout << std::endl;
+    }
+}
+
+int main()
+{
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    benchSet<LockFreeList<uint64_t>>("LockFreeList", 1024);
+    benchSet<LockFreeSkipList<uint64_t>>("LockFreeSkipList", 1024);
+    benchSet<LockedSet>("std::set + shared_mutex", 1024);
+    benchSet<LockFreeSkipList<uint64_t>>("LockFreeSkipList", 1000000);
+    benchSet<LockedSet>("std::set + shared_mutex", 1000000);
+    return 0;
+}
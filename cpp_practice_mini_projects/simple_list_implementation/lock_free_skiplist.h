@@ -0,0 +1,340 @@
+#ifndef LOCK_FREE_SKIPLIST_H
+#define LOCK_FREE_SKIPLIST_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include "lock_free_list.h"
+
+/*
+Lock-free skip list ordered set (Herlihy & Shavit's LockFreeSkipList, "The Art of Multiprocessor Programming" ch.14)
+    - A stack of LockFreeList style levels: level 0 holds every key, each level above holds about half of the one below,
+      so a search skips along the top and drops down, O(log n) expected.
+    - Level 0 is the truth: a key is in the set iff its node is linked at level 0 and not marked there.
+      The upper levels are only shortcuts, they may briefly miss a node or still hold an erased one.
+    - insert links level 0 first (that is the linearization point), then the levels above one by one.
+      erase marks the levels top down and level 0 last (the CAS on level 0 decides who erased the key),
+      then one search unlinks the node everywhere.
+    - A node can only be retired once nobody can link it anymore. The inserter may still be adding upper levels
+      while the node is being erased, so both of them set a bit in node->state when they are done with it,
+      and whoever sets the second bit retires it. An inserter that finds its node erased underneath
+      runs one more search first, to unlink it from the levels it just added.
+    - popMin() for timer style use: erase and return the smallest key.
+*/
+template <typename Key, typename Compare = std::less<Key>>
+class LockFreeSkipList {
+public:
+    static constexpr int max_level = 20;   // p = 1/2 per level, plenty up to ~1M keys, still fine well past that
+
+private:
+    using Link = std::atomic<std::uintptr_t>;
+
+    static constexpr uint8_t insert_done = 1;
+    static constexpr uint8_t erase_done = 2;
+
+    // The links (height of them) are allocated right after the node
+    struct Node {
+        const Key key;
+        const int height;
+        std::atomic<uint8_t> state{0};
+
+        template <typename K>
+        Node(K&& key_, int height_) : key(std::forward<K>(key_)), height(height_) {}
+
+        Link& next(int level) {
+            return reinterpret_cast<Link*>(reinterpret_cast<char*>(this) + links_offset)[level];
+        }
+    };
+
+    static constexpr std::size_t links_offset = (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+    static constexpr std::size_t node_align = alignof(Node) > alignof(Link) ? alignof(Node) : alignof(Link);
+
+    Link headLinks[max_level];
+    std::atomic<int> levels{1};   // levels in use, searches start at the top one
+    std::atomic<std::size_t> count{0};
+    [[no_unique_address]] Compare less;
+
+    template <typename K>
+    static Node* createNode(K&& key, int height)
+    {
+        void* memory = ::operator new(links_offset + height * sizeof(Link), std::align_val_t(node_align));
+        Node* node;
+        try {
+            node = ::new (memory) Node(std::forward<K>(key), height);
+        } catch (...) {
+            ::operator delete(memory, std::align_val_t(node_align));
+            throw;
+        }
+        for (int level = 0; level < height; level++)
+            ::new (static_cast<void*>(&node->next(level))) Link(0);
+        return node;
+    }
+
+    static void destroyNode(void* ptr)
+    {
+        Node* node = static_cast<Node*>(ptr);
+        node->~Node();
+        ::operator delete(ptr, std::align_val_t(node_align));
+    }
+
+    // Geometric height, 1 with p=1/2, 2 with p=1/4, ... from a per thread xorshift, no shared RNG state
+    static int randomHeight()
+    {
+        static thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<std::uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return 1 + std::countr_zero(state | (uint64_t(1) << (max_level - 1)));
+    }
+
+    // null pred stands for the head
+    Link& linkOf(Node* pred, int level) {
+        return pred ? pred->next(level) : headLinks[level];
+    }
+
+    const Link& linkOf(Node* pred, int level) const {
+        return pred ? pred->next(level) : headLinks[level];
+    }
+
+    void raiseLevels(int height)
+    {
+        int current = levels.load(std::memory_order_relaxed);
+        while (current < height && !levels.compare_exchange_weak(current, height, std::memory_order_relaxed)) {
+        }
+    }
+
+    // One pass of find(), false if a CAS lost a race and the search has to start over
+    bool tryFind(const Key& key, Node** preds, Node** succs)
+    {
+        int top = levels.load(std::memory_order_relaxed);
+        // levels nobody uses yet: the head links there are (almost certainly) null, a CAS on them catches it if not
+        for (int level = max_level - 1; level >= top; level--) {
+            preds[level] = nullptr;
+            succs[level] = MarkedPtr::node<Node>(headLinks[level].load(std::memory_order_acquire));
+        }
+        Node* pred = nullptr;
+        for (int level = top - 1; level >= 0; level--) {
+            Node* curr = MarkedPtr::node<Node>(linkOf(pred, level).load(std::memory_order_acquire));
+            while (curr) {
+                std::uintptr_t succ = curr->next(level).load(std::memory_order_acquire);
+                if (MarkedPtr::isMarked(succ)) {
+                    // erased, unlink it from this level. Retiring is left to the state bits
+                    std::uintptr_t expected = MarkedPtr::link(curr);
+                    if (!linkOf(pred, level).compare_exchange_strong(expected, MarkedPtr::unmarked(succ), std::memory_order_acq_rel, std::memory_order_relaxed))
+                        return false;
+                    curr = MarkedPtr::node<Node>(succ);
+                    continue;
+                }
+                if (!less(curr->key, key))
+                    break;
+                pred = curr;
+                curr = MarkedPtr::node<Node>(succ);
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return true;
+    }
+
+    // preds/succs: at every level, the last node with key < key and the one after it. Unlinks the marked nodes on the way.
+    // Returns whether succs[0] holds key. Caller must hold an EpochGuard
+    bool find(const Key& key, Node** preds, Node** succs)
+    {
+        while (!tryFind(key, preds, succs)) {
+        }
+        return succs[0] && !less(key, succs[0]->key);
+    }
+
+    void finish(Node* node, uint8_t done)
+    {
+        if (node->state.fetch_or(done, std::memory_order_acq_rel) & ~done)
+            EpochReclaimer::retire(node, &destroyNode);
+    }
+
+    // Link the levels above 0 of a node that is already in the set
+    void linkUpperLevels(Node* node, Node** preds, Node** succs)
+    {
+        for (int level = 1; level < node->height; level++) {
+            while (true) {
+                // point the node at its successor first. Only an erase changes node->next here (it marks it): stop then
+                std::uintptr_t current = node->next(level).load(std::memory_order_acquire);
+                std::uintptr_t wanted = MarkedPtr::link(succs[level]);
+                if (MarkedPtr::isMarked(current))
+                    return;
+                if (current != wanted && !node->next(level).compare_exchange_strong(current, wanted, std::memory_order_acq_rel, std::memory_order_relaxed))
+                    return;
+                std::uintptr_t expected = wanted;
+                if (linkOf(preds[level], level).compare_exchange_strong(expected, MarkedPtr::link(node), std::memory_order_release, std::memory_order_relaxed))
+                    break;
+                // the neighbourhood changed, search again. If the node is gone from level 0 it is being erased: stop
+                if (!find(node->key, preds, succs) || succs[0] != node)
+                    return;
+            }
+        }
+    }
+
+    template <typename K>
+    bool insertKey(K&& key)
+    {
+        EpochGuard guard;
+        Node* preds[max_level];
+        Node* succs[max_level];
+        Node* node = nullptr;
+        while (true) {
+            if (find(key, preds, succs)) {
+                if (node)
+                    destroyNode(node);   // never published
+                return false;
+            }
+            if (!node)
+                node = createNode(std::forward<K>(key), randomHeight());
+            for (int level = 0; level < node->height; level++)
+                node->next(level).store(MarkedPtr::link(succs[level]), std::memory_order_relaxed);
+            std::uintptr_t expected = MarkedPtr::link(succs[0]);
+            if (linkOf(preds[0], 0).compare_exchange_strong(expected, MarkedPtr::link(node), std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        raiseLevels(node->height);
+        linkUpperLevels(node, preds, succs);
+        // erased while we were still linking: the levels we added after the eraser's search still point at it
+        if (MarkedPtr::isMarked(node->next(0).load(std::memory_order_acquire)))
+            find(node->key, preds, succs);
+        finish(node, insert_done);
+        return true;
+    }
+
+    // Mark all levels, level 0 last. True if this call is the one that erased the node
+    bool eraseNode(Node* victim)
+    {
+        for (int level = victim->height - 1; level >= 1; level--) {
+            std::uintptr_t succ = victim->next(level).load(std::memory_order_acquire);
+            while (!MarkedPtr::isMarked(succ) &&
+                   !victim->next(level).compare_exchange_weak(succ, MarkedPtr::marked(succ), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            }
+        }
+        std::uintptr_t succ = victim->next(0).load(std::memory_order_acquire);
+        while (true) {
+            if (MarkedPtr::isMarked(succ))
+                return false;   // another thread got there first
+            if (victim->next(0).compare_exchange_weak(succ, MarkedPtr::marked(succ), std::memory_order_acq_rel, std::memory_order_acquire))
+                break;
+        }
+        count.fetch_sub(1, std::memory_order_relaxed);
+        Node* preds[max_level];
+        Node* succs[max_level];
+        find(victim->key, preds, succs);   // unlinks it from every level
+        finish(victim, erase_done);
+        return true;
+    }
+
+public:
+    LockFreeSkipList()
+    {
+        for (Link& link : headLinks)
+            link.store(0, std::memory_order_relaxed);
+    }
+
+    explicit LockFreeSkipList(Compare comp) : LockFreeSkipList() {
+        less = std::move(comp);
+    }
+
+    LockFreeSkipList(const LockFreeSkipList&) = delete;
+    LockFreeSkipList& operator=(const LockFreeSkipList&) = delete;
+
+    // No other thread may use the set anymore. Every live node is linked at level 0, the erased ones are the reclaimer's
+    ~LockFreeSkipList()
+    {
+        Node* node = MarkedPtr::node<Node>(headLinks[0].load(std::memory_order_acquire));
+        while (node) {
+            Node* next = MarkedPtr::node<Node>(node->next(0).load(std::memory_order_relaxed));
+            destroyNode(node);
+            node = next;
+        }
+    }
+
+    bool insert(const Key& key) {
+        return insertKey(key);
+    }
+
+    bool insert(Key&& key) {
+        return insertKey(std::move(key));
+    }
+
+    bool erase(const Key& key)
+    {
+        EpochGuard guard;
+        Node* preds[max_level];
+        Node* succs[max_level];
+        if (!find(key, preds, succs))
+            return false;
+        return eraseNode(succs[0]);
+    }
+
+    // Read only: walks down the levels without unlinking anything
+    bool contains(const Key& key) const
+    {
+        EpochGuard guard;
+        Node* pred = nullptr;
+        Node* curr = nullptr;
+        for (int level = levels.load(std::memory_order_relaxed) - 1; level >= 0; level--) {
+            curr = MarkedPtr::node<Node>(linkOf(pred, level).load(std::memory_order_acquire));
+            while (curr) {
+                std::uintptr_t succ = curr->next(level).load(std::memory_order_acquire);
+                if (!MarkedPtr::isMarked(succ) && !less(curr->key, key))
+                    break;
+                // marked ones are skipped, not unlinked. Their next still leads to the right place
+                if (!MarkedPtr::isMarked(succ))
+                    pred = curr;
+                curr = MarkedPtr::node<Node>(succ);
+            }
+        }
+        return curr && !less(key, curr->key);
+    }
+
+    // Erase the smallest key and hand it out, false if the set is empty
+    bool popMin(Key& out)
+    {
+        EpochGuard guard;
+        while (true) {
+            Node* first = MarkedPtr::node<Node>(headLinks[0].load(std::memory_order_acquire));
+            while (first && MarkedPtr::isMarked(first->next(0).load(std::memory_order_acquire)))
+                first = MarkedPtr::node<Node>(first->next(0).load(std::memory_order_acquire));
+            if (!first)
+                return false;
+            Key key = first->key;   // keys never change, copy it before the node can go to the reclaimer
+            if (eraseNode(first)) {
+                out = std::move(key);
+                return true;
+            }
+        }
+    }
+
+    // Calls func(key) in order for the keys not erased at the moment it passes them. Not a snapshot
+    template <typename Func>
+    void forEach(Func&& func) const
+    {
+        EpochGuard guard;
+        Node* curr = MarkedPtr::node<Node>(headLinks[0].load(std::memory_order_acquire));
+        while (curr) {
+            std::uintptr_t succ = curr->next(0).load(std::memory_order_acquire);
+            if (!MarkedPtr::isMarked(succ))
+                func(curr->key);
+            curr = MarkedPtr::node<Node>(succ);
+        }
+    }
+
+    std::size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+};
+
+#endif // LOCK_FREE_SKIPLIST_H
@@ -0,0 +1,428 @@
+#ifndef NODE_SLAB_ALLOCATOR_H
+#define NODE_SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+/*
+Node allocator for linked containers (dList, std::list, maps...)
+    - A list only ever asks for one node at a time, all of the same size, so a general purpose malloc
+      is overkill. SlabPool carves fixed size blocks out of big slabs and recycles freed blocks through an
+      intrusive free list (the "next" pointer lives inside the freed block itself), so a steady state
+      insert/erase loop never calls malloc/free.
+    - SlabAllocator<T> is a std allocator on top of it, so it can be handed to any allocator aware container.
+      Containers rebind it to their node type, that's the size the pool ends up serving.
+    - SlabAllocator<T, true> (default): one process wide pool per block size, with a small free list cache
+      per thread in front of it. Threads only touch the mutex of the shared pool to move a whole batch
+      of blocks in or out. All these allocators compare equal, so nodes can move between lists and threads.
+    - SlabAllocator<T, false>: every allocator (i.e. every list) owns a private pool, no locks, no thread_local
+      lookup. Only for lists that stay on one thread, and nodes can't be moved between lists.
+A slab whose blocks all came back is given back to the OS (one empty slab is kept as a spare), so a list that
+peaked at 1M nodes does not sit on that memory forever. Blocks still parked in thread caches keep their slabs alive.
+*/
+
+// Fixed size block pool, not thread safe.
+// Every slab keeps its own free list and a count of blocks in use, the slab of a block is found by masking
+// its address (slabs are aligned to their own size). Blocks are always taken from one "current" slab until it
+// runs dry, so nodes allocated one after the other stay within the same 64KB even after heavy churn.
+// One global free list would hand back blocks in whatever order they were freed, and after a big list
+// is destroyed in random order every new node lands somewhere else in hundreds of MB of slabs.
+template <std::size_t BlockSize, std::size_t BlockAlign>
+class SlabPool {
+public:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t block_align = std::max(BlockAlign, alignof(FreeBlock));
+    // round up so that every block in the slab stays aligned
+    static constexpr std::size_t block_size = ((std::max(BlockSize, sizeof(FreeBlock)) + block_align - 1) / block_align) * block_align;
+
+private:
+    // lives at the start of the slab, blocks follow it
+    struct Slab {
+        FreeBlock* freeHead = nullptr;   // blocks handed back to this slab
+        std::size_t used = 0;            // blocks currently handed out
+        std::size_t carved = 0;          // blocks [0, carved) were handed out at least once, the rest never touched
+        Slab* partialPrev = nullptr;     // list of slabs with free blocks, other than current
+        Slab* partialNext = nullptr;
+        bool onPartial = false;
+        Slab* allPrev = nullptr;         // every slab, for the destructor
+        Slab* allNext = nullptr;
+    };
+
+    static constexpr std::size_t header_bytes = ((sizeof(Slab) + block_align - 1) / block_align) * block_align;
+
+    // 64KB, or the next power of two that still fits 32 blocks for big nodes
+    static constexpr std::size_t slabBytesFor()
+    {
+        std::size_t bytes = 64 * 1024;
+        while (bytes < header_bytes + 32 * block_size)
+            bytes *= 2;
+        return bytes;
+    }
+
+public:
+    static constexpr std::size_t slab_bytes = slabBytesFor();
+    static constexpr std::size_t blocks_per_slab = (slab_bytes - header_bytes) / block_size;
+
+private:
+    Slab* current = nullptr;        // where allocate() takes blocks from
+    Slab* partialHead = nullptr;    // next candidates once current is full
+    Slab* spare = nullptr;          // one empty slab kept around, a list hovering at a slab boundary would map/unmap all the time
+    Slab* allHead = nullptr;
+    std::size_t numSlabs = 0;
+    std::size_t numUsed = 0;
+
+    static Slab* slabOf(void* ptr) {
+        return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(ptr) & ~(slab_bytes - 1));
+    }
+
+    static char* blockAt(Slab* slab, std::size_t idx) {
+        return reinterpret_cast<char*>(slab) + header_bytes + idx * block_size;
+    }
+
+    // every block is back: forget the free list and carve from the start again, so the next nodes are in address order
+    static void reset(Slab* slab)
+    {
+        slab->freeHead = nullptr;
+        slab->carved = 0;
+    }
+
+    void pushPartial(Slab* slab)
+    {
+        slab->partialPrev = nullptr;
+        slab->partialNext = partialHead;
+        if (partialHead)
+            partialHead->partialPrev = slab;
+        partialHead = slab;
+        slab->onPartial = true;
+    }
+
+    void removePartial(Slab* slab)
+    {
+        if (slab->partialPrev)
+            slab->partialPrev->partialNext = slab->partialNext;
+        else
+            partialHead = slab->partialNext;
+        if (slab->partialNext)
+            slab->partialNext->partialPrev = slab->partialPrev;
+        slab->onPartial = false;
+    }
+
+    Slab* newSlab()
+    {
+        void* memory = ::operator new(slab_bytes, std::align_val_t(slab_bytes));
+        Slab* slab = ::new (memory) Slab();
+        slab->allNext = allHead;
+        if (allHead)
+            allHead->allPrev = slab;
+        allHead = slab;
+        numSlabs++;
+        return slab;
+    }
+
+    void freeSlab(Slab* slab)
+    {
+        if (slab->allPrev)
+            slab->allPrev->allNext = slab->allNext;
+        else
+            allHead = slab->allNext;
+        if (slab->allNext)
+            slab->allNext->allPrev = slab->allPrev;
+        numSlabs--;
+        ::operator delete(static_cast<void*>(slab), std::align_val_t(slab_bytes));
+    }
+
+    // current is full, move on to a partial slab, the spare or a brand new one
+    void nextSlab()
+    {
+        if (partialHead) {
+            current = partialHead;
+            removePartial(current);
+        } else if (spare) {
+            current = spare;
+            spare = nullptr;
+        } else {
+            current = newSlab();
+        }
+    }
+
+public:
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void* allocate()
+    {
+        if (!current || (!current->freeHead && current->carved == blocks_per_slab))
+            nextSlab();
+        Slab* slab = current;
+        void* block;
+        if (slab->freeHead) {
+            block = slab->freeHead;
+            slab->freeHead = slab->freeHead->next;
+        } else {
+            // carve lazily instead of threading all the blocks of a new slab into the free list up front
+            block = blockAt(slab, slab->carved++);
+        }
+        slab->used++;
+        numUsed++;
+        return block;
+    }
+
+    void deallocate(void* ptr)
+    {
+        Slab* slab = slabOf(ptr);
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = slab->freeHead;
+        slab->freeHead = block;
+        slab->used--;
+        numUsed--;
+
+        if (slab->used == 0) {
+            reset(slab);
+            if (slab == current)
+                return;
+            if (slab->onPartial)
+                removePartial(slab);
+            // keep one empty slab, give the others back
+            if (!spare)
+                spare = slab;
+            else
+                freeSlab(slab);
+        } else if (slab != current && !slab->onPartial) {
+            // was full, it has room again
+            pushPartial(slab);
+        }
+    }
+
+    // Hand out count blocks as a linked chain, used to refill a thread cache in one go
+    std::size_t allocateBatch(FreeBlock*& head, std::size_t count)
+    {
+        head = nullptr;
+        for (std::size_t i = 0; i < count; i++) {
+            FreeBlock* block = static_cast<FreeBlock*>(allocate());
+            block->next = head;
+            head = block;
+        }
+        return count;
+    }
+
+    // Take back a chain of count blocks, each one goes home to its own slab
+    void deallocateBatch(FreeBlock* head, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++) {
+            FreeBlock* next = head->next;
+            deallocate(head);
+            head = next;
+        }
+    }
+
+    std::size_t slabCount() const {
+        return numSlabs;
+    }
+
+    std::size_t freeBlocks() const {
+        return numSlabs * blocks_per_slab - numUsed;
+    }
+
+    ~SlabPool()
+    {
+        while (allHead)
+            freeSlab(allHead);
+    }
+};
+
+// Process wide pool for one block size with per thread caches in front of it.
+// The shared pool is leaked on purpose: a static list destroyed after it (or a thread exiting late)
+// would otherwise free into a dead pool. The OS takes the slabs back at exit anyway.
+template <std::size_t BlockSize, std::size_t BlockAlign>
+class ThreadCachedSlabPool {
+private:
+    using Pool = SlabPool<BlockSize, BlockAlign>;
+    using FreeBlock = typename Pool::FreeBlock;
+
+    static constexpr std::size_t batch_size = 64;           // blocks moved between a thread cache and the shared pool at once
+    static constexpr std::size_t max_cached = 2 * batch_size;
+
+    struct Shared {
+        std::mutex mtx;
+        Pool pool;
+    };
+
+    static Shared& shared()
+    {
+        static Shared* instance = new Shared();
+        return *instance;
+    }
+
+    struct ThreadCache {
+        FreeBlock* head = nullptr;
+        std::size_t count = 0;
+
+        // blocks still cached by an exiting thread go back to the shared pool, other threads may have them in their lists
+        ~ThreadCache()
+        {
+            cacheGone() = true;
+            if (!head)
+                return;
+            Shared& pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mtx);
+            pool.pool.deallocateBatch(head, count);
+            head = nullptr;
+            count = 0;
+        }
+    };
+
+    static ThreadCache& cache()
+    {
+        static thread_local ThreadCache threadCache;
+        return threadCache;
+    }
+
+    // Other thread_local destructors can still free nodes after the cache is destroyed (e.g. the epoch reclaimer
+    // flushing at thread exit). A plain bool has no destructor, so it is still valid then and sends them to the shared pool
+    static bool& cacheGone()
+    {
+        static thread_local bool gone = false;
+        return gone;
+    }
+
+public:
+    static void* allocate()
+    {
+        if (cacheGone()) {
+            Shared& pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mtx);
+            return pool.pool.allocate();
+        }
+        ThreadCache& local = cache();
+        if (!local.head) {
+            Shared& pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mtx);
+            local.count = pool.pool.allocateBatch(local.head, batch_size);
+        }
+        FreeBlock* block = local.head;
+        local.head = block->next;
+        local.count--;
+        return block;
+    }
+
+    static void deallocate(void* ptr)
+    {
+        if (cacheGone()) {
+            Shared& pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mtx);
+            pool.pool.deallocate(ptr);
+            return;
+        }
+        ThreadCache& local = cache();
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = local.head;
+        local.head = block;
+        local.count++;
+
+        // a thread that mostly frees (consumer side of a queue) must not hoard the blocks forever
+        if (local.count > max_cached) {
+            FreeBlock* head = local.head;
+            FreeBlock* tail = head;
+            for (std::size_t i = 1; i < batch_size; i++)
+                tail = tail->next;
+            local.head = tail->next;
+            local.count -= batch_size;
+
+            Shared& pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mtx);
+            pool.pool.deallocateBatch(head, batch_size);
+        }
+    }
+};
+
+template <typename T, bool ThreadCache = true>
+class SlabAllocator {
+private:
+    using Pool = SlabPool<sizeof(T), alignof(T)>;
+    using SharedPool = ThreadCachedSlabPool<sizeof(T), alignof(T)>;
+
+    // private pool, only used with ThreadCache = false
+    std::shared_ptr<Pool> pool;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::bool_constant<!ThreadCache>;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::bool_constant<!ThreadCache>;
+    using is_always_equal = std::bool_constant<ThreadCache>;
+
+    // allocator_traits can't rebind a template with a non type parameter on its own
+    template <typename U>
+    struct rebind {
+        using other = SlabAllocator<U, ThreadCache>;
+    };
+
+    SlabAllocator()
+    {
+        if constexpr (!ThreadCache)
+            pool = std::make_shared<Pool>();
+    }
+
+    SlabAllocator(const SlabAllocator&) noexcept = default;
+    SlabAllocator& operator=(const SlabAllocator&) noexcept = default;
+
+    // Containers rebind SlabAllocator<T> to SlabAllocator<Node>. Without ThreadCache the block size changes,
+    // so the rebound allocator needs a pool of its own (which also means rebinding back does not compare equal)
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U, ThreadCache>&) : SlabAllocator() {}
+
+    // identifies the pool backing this allocator, nullptr for the shared one
+    const void* poolId() const noexcept {
+        return pool.get();
+    }
+
+    T* allocate(std::size_t n)
+    {
+        // arrays are not what this allocator is for, let the regular heap handle them
+        if (n != 1)
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        if constexpr (ThreadCache)
+            return static_cast<T*>(SharedPool::allocate());
+        else
+            return static_cast<T*>(pool->allocate());
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        if (n != 1) {
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+            return;
+        }
+        if constexpr (ThreadCache)
+            SharedPool::deallocate(ptr);
+        else
+            pool->deallocate(ptr);
+    }
+
+    template <typename U>
+    friend bool operator==(const SlabAllocator& lhs, const SlabAllocator<U, ThreadCache>& rhs) noexcept
+    {
+        if constexpr (ThreadCache)
+            return true;
+        else
+            return lhs.poolId() == rhs.poolId();
+    }
+
+    template <typename U>
+    friend bool operator!=(const SlabAllocator& lhs, const SlabAllocator<U, ThreadCache>& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+};
+
+#endif // NODE_SLAB_ALLOCATOR_H
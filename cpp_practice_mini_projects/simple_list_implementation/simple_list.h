@@ -5,6 +5,13 @@
 #include <cstddef> // for std::size_t
 #include <initializer_list>
 #include <iostream> // for std::cout
+#include <memory>   // for std::allocator_traits
+#include <stdexcept>
+#include <utility>
+#include <iterator>
+#include <functional>   // for std::less
+#include <type_traits>
+#include "node_slab_allocator.h"
 
 /*
 Quick note on perfect forwarding and variadic templates:
@@ -18,7 +25,9 @@ void demo(Args&&... args) {
 */
 
 // dList is a doubly linked list implementation for generic data where each node is represented by dNode.
-template <typename T>
+// Nodes come from Alloc (rebound to dNode), by default the slab allocator in node_slab_allocator.h.
+// dList<T, std::allocator<T>> gives back the plain new/delete per node behaviour.
+template <typename T, typename Alloc = SlabAllocator<T>>
 class dList {
 private:
 
@@ -53,14 +62,210 @@ private:
         }
     };
 
-public:
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<dNode>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    // Empty for stateless allocators, so it costs no space in the list
+    [[no_unique_address]] NodeAlloc nodeAlloc;
+
+    // Every node is created and destroyed through these two, so the allocator is the only thing deciding where nodes live
+    template <typename... Args>
+    dNode* createNode(Args&&... args)
+    {
+        dNode* newNode = NodeTraits::allocate(nodeAlloc, 1);
+        try {
+            NodeTraits::construct(nodeAlloc, newNode, std::forward<Args>(args)...);
+        } catch (...) {
+            NodeTraits::deallocate(nodeAlloc, newNode, 1);
+            throw;
+        }
+        return newNode;
+    }
+
+    void destroyNode(dNode* node)
+    {
+        NodeTraits::destroy(nodeAlloc, node);
+        NodeTraits::deallocate(nodeAlloc, node, 1);
+    }
+
+    // Used to be public, iterators and head()/tail() are the way in now,
+    // so nobody outside can leave head/tail/size out of sync with the nodes
     dNode* dlHead;
     dNode* dlTail;
     std::size_t dlSize;
 
+    // Link a new node just before position (nullptr = at the end)
+    void linkBefore(dNode* position, dNode* newNode)
+    {
+        dNode* before = position ? position->prev : dlTail;
+        newNode->prev = before;
+        newNode->next = position;
+        if (before)
+            before->next = newNode;
+        else
+            dlHead = newNode;
+        if (position)
+            position->prev = newNode;
+        else
+            dlTail = newNode;
+        dlSize++;
+    }
+
+    // Cut the nodes [first, last) out of list (last nullptr = up to the end), the nodes keep their own links
+    static void unlinkRange(dList& list, dNode* first, dNode* last, std::size_t count)
+    {
+        if (first->prev)
+            first->prev->next = last;
+        else
+            list.dlHead = last;
+        if (last)
+            last->prev = first->prev;
+        else
+            list.dlTail = first->prev;
+        list.dlSize -= count;
+    }
+
+    // Put the chain first..lastNode (already linked to each other) just before position
+    void linkRangeBefore(dNode* position, dNode* first, dNode* lastNode, std::size_t count)
+    {
+        dNode* before = position ? position->prev : dlTail;
+        first->prev = before;
+        lastNode->next = position;
+        if (before)
+            before->next = first;
+        else
+            dlHead = first;
+        if (position)
+            position->prev = lastNode;
+        else
+            dlTail = lastNode;
+        dlSize += count;
+    }
+
+    // Nodes can only move between lists whose allocators can free each other's nodes,
+    // always true for the default (thread cached) SlabAllocator and std::allocator
+    bool canStealNodes(const dList& other) const
+    {
+        if constexpr (NodeTraits::is_always_equal::value)
+            return true;
+        else
+            return nodeAlloc == other.nodeAlloc;
+    }
+
+    // Stable merge of two sorted, null terminated chains (only next links are maintained).
+    // On ties the node from a wins, a holds the earlier elements
+    template <typename Compare>
+    static dNode* mergeChains(dNode* a, dNode* b, Compare& comp)
+    {
+        dNode* merged = nullptr;
+        dNode** tail = &merged;
+        while (a && b) {
+            if (comp(b->data, a->data)) {
+                *tail = b;
+                b = b->next;
+            } else {
+                *tail = a;
+                a = a->next;
+            }
+            tail = &(*tail)->next;
+        }
+        *tail = a ? a : b;
+        return merged;
+    }
+
+    // Take over a null terminated chain as the whole list, fixing the prev links on the way
+    void adoptChain(dNode* chain)
+    {
+        dlHead = chain;
+        dNode* prev = nullptr;
+        for (dNode* node = chain; node; node = node->next) {
+            node->prev = prev;
+            prev = node;
+        }
+        dlTail = prev;
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = std::size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    template <bool IsConst>
+    class Iterator {
+    private:
+        using ListPtr = std::conditional_t<IsConst, const dList*, dList*>;
+        ListPtr list = nullptr;     // only needed to step back from end()
+        dNode* node = nullptr;      // nullptr is end()
+
+        friend class dList;
+        template <bool> friend class Iterator;
+
+        Iterator(ListPtr owner, dNode* node_) : list(owner), node(node_) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        // iterator -> const_iterator
+        template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+        Iterator(const Iterator<WasConst>& other) : list(other.list), node(other.node) {}
+
+        reference operator*() const {
+            return node->data;
+        }
+
+        pointer operator->() const {
+            return &node->data;
+        }
+
+        Iterator& operator++() {
+            node = node->next;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            node = node->next;
+            return old;
+        }
+
+        Iterator& operator--() {
+            node = node ? node->prev : list->dlTail;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.node == rhs.node;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.node != rhs.node;
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
     // Constructor for dList initializes head and tail to nullptr and size to 0.
     dList() : dlHead(nullptr),dlTail(nullptr), dlSize(0){}
 
+    explicit dList(const Alloc& alloc) : nodeAlloc(alloc), dlHead(nullptr),dlTail(nullptr), dlSize(0){}
+
     dList(std::initializer_list<T>  otherList) 
     {
         dlHead=nullptr;
@@ -75,6 +280,10 @@ public:
     dList(const dList&) = delete;
     dList& operator=(const dList&) = delete;
 
+    Alloc get_allocator() const {
+        return Alloc(nodeAlloc);
+    }
+
     dNode* head() const {
         return dlHead;
     }
@@ -91,6 +300,25 @@ public:
         return dlSize == 0;
     }
 
+    iterator begin() { return iterator(this, dlHead); }
+    iterator end() { return iterator(this, nullptr); }
+    const_iterator begin() const { return const_iterator(this, dlHead); }
+    const_iterator end() const { return const_iterator(this, nullptr); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    T& front() {
+        return dlHead->data;
+    }
+
+    T& back() {
+        return dlTail->data;
+    }
+
     // Create a new node in place, at the end of the list with the given value
     void push_back(const T& value)
     {
@@ -119,7 +347,7 @@ public:
         dlSize--;
 
         T dataToReturn = std::move(nodeToPop->data); // Store the data to return
-        delete nodeToPop; // Delete the popped node 
+        destroyNode(nodeToPop); // Delete the popped node 
         return dataToReturn; // Return the popped node
     }
 
@@ -131,7 +359,7 @@ public:
             return;
         }
 
-        dNode* newNode = new dNode(value);
+        dNode* newNode = createNode(value);
         newNode->next = position;
         newNode->prev = position->prev;
         if (position->prev)
@@ -149,7 +377,7 @@ public:
             return;
         }
 
-        dNode* newNode = new dNode(std::move(value));
+        dNode* newNode = createNode(std::move(value));
         newNode->next = position;
         newNode->prev = position->prev;
         if (position->prev)
@@ -165,7 +393,7 @@ public:
     void emplace_back(Args&&... args)
     {
         // This function allows for perfect forwarding of arguments to construct the data in place.
-        dNode* newNode = new dNode(std::forward<Args>(args)...);
+        dNode* newNode = createNode(std::forward<Args>(args)...);
         if (dlTail){
             dlTail->next = newNode;
             newNode->prev = dlTail;
@@ -186,7 +414,7 @@ public:
             emplace_back(std::forward<Args>(args)...);
             return;
         }
-        dNode* newNode = new dNode(std::forward<Args>(args)...);
+        dNode* newNode = createNode(std::forward<Args>(args)...);
         newNode->next = position;
         newNode->prev = position->prev;
         if (position->prev)
@@ -198,6 +426,37 @@ public:
         dlSize++;
     }
 
+    // Iterator versions of insert/emplace/erase, same semantics as std::list
+    template <typename... Args>
+    iterator emplace(const_iterator position, Args&&... args)
+    {
+        dNode* newNode = createNode(std::forward<Args>(args)...);
+        linkBefore(position.node, newNode);
+        return iterator(this, newNode);
+    }
+
+    iterator insert(const_iterator position, const T& value) {
+        return emplace(position, value);
+    }
+
+    iterator insert(const_iterator position, T&& value) {
+        return emplace(position, std::move(value));
+    }
+
+    iterator erase(const_iterator position)
+    {
+        dNode* next = position.node->next;
+        erase(position.node);
+        return iterator(this, next);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+            first = erase(first);
+        return iterator(this, last.node);
+    }
+
     // Erase a node at the given position.
     void erase(dNode* position)
     {
@@ -213,7 +472,7 @@ public:
         else
             dlTail = position->prev;
 
-        delete position;
+        destroyNode(position);
         dlSize--;
         
     }
@@ -231,6 +490,117 @@ public:
         // Explore SFINAE-restrict for providing print functionality for non-printable types
     }
 #endif // DEBUG
+    // Move the nodes [first, last) of other to just before position. No T is copied or moved, only links change.
+    // count must be the number of nodes in the range, that's what makes this O(1) between different lists
+    // (the size of both lists has to be updated, and counting the range would be O(n))
+    void splice(const_iterator position, dList& other, const_iterator first, const_iterator last, std::size_t count)
+    {
+        if (first == last)
+            return;
+        if (&other != this && !canStealNodes(other)) {
+            // other's allocator can't free our nodes and vice versa, fall back to moving the values over
+            while (first != last) {
+                emplace(position, std::move(first.node->data));
+                first = other.erase(first);
+            }
+            return;
+        }
+        dNode* lastNode = last.node ? last.node->prev : other.dlTail;
+        unlinkRange(other, first.node, last.node, count);
+        linkRangeBefore(position.node, first.node, lastNode, count);
+    }
+
+    // Same, counting the range first: O(1) within one list (size does not change), O(range) between two lists
+    void splice(const_iterator position, dList& other, const_iterator first, const_iterator last)
+    {
+        std::size_t count = 0;
+        if (&other != this)
+            for (const_iterator it = first; it != last; ++it)
+                count++;
+        splice(position, other, first, last, count);
+    }
+
+    // Move the whole of other to just before position, O(1)
+    void splice(const_iterator position, dList& other)
+    {
+        if (&other == this || other.empty())
+            return;
+        splice(position, other, other.begin(), other.end(), other.size());
+    }
+
+    // Move the single node at it (from other) to just before position, O(1)
+    void splice(const_iterator position, dList& other, const_iterator it)
+    {
+        const_iterator next = it;
+        ++next;
+        if (position == it || position == next)
+            return;
+        splice(position, other, it, next, 1);
+    }
+
+    // Merge the sorted other into this sorted list, other ends up empty. Stable, equal elements of this list come first
+    template <typename Compare = std::less<>>
+    void merge(dList& other, Compare comp = Compare())
+    {
+        if (&other == this || other.empty())
+            return;
+        std::size_t otherSize = other.dlSize;
+        dNode* otherChain = other.dlHead;
+        if (canStealNodes(other)) {
+            other.dlHead = nullptr;
+            other.dlTail = nullptr;
+            other.dlSize = 0;
+        } else {
+            // other's nodes can't become ours, rebuild its elements as our own nodes first
+            otherChain = nullptr;
+            dNode** tail = &otherChain;
+            for (dNode* node = other.dlHead; node; node = node->next) {
+                *tail = createNode(std::move(node->data));
+                tail = &(*tail)->next;
+            }
+            other.clearList();
+        }
+        adoptChain(mergeChains(dlHead, otherChain, comp));
+        dlSize += otherSize;
+    }
+
+    // In place, stable, bottom-up merge sort. Only next/prev links change, T is never copied or moved,
+    // so references and iterators to elements stay valid (they just point to a new position).
+    // bins[i] holds a sorted run of 2^i nodes, every node is added as a run of 1 and carried up like a binary counter,
+    // so the runs being merged are mostly still warm in cache (unlike merging the whole list pass by pass)
+    template <typename Compare = std::less<>>
+    void sort(Compare comp = Compare())
+    {
+        if (dlSize < 2)
+            return;
+
+        dNode* bins[64] = {};
+        std::size_t usedBins = 0;
+        dNode* node = dlHead;
+        while (node) {
+            dNode* next = node->next;
+            node->next = nullptr;
+            dNode* carry = node;
+            std::size_t bin = 0;
+            // bins[bin] was built from earlier nodes than carry, so it goes first to keep the sort stable
+            for (; bins[bin]; bin++) {
+                carry = mergeChains(bins[bin], carry, comp);
+                bins[bin] = nullptr;
+            }
+            bins[bin] = carry;
+            if (bin + 1 > usedBins)
+                usedBins = bin + 1;
+            node = next;
+        }
+
+        // higher bins hold the earlier nodes
+        dNode* sorted = nullptr;
+        for (std::size_t bin = 0; bin < usedBins; bin++)
+            if (bins[bin])
+                sorted = sorted ? mergeChains(bins[bin], sorted, comp) : bins[bin];
+        adoptChain(sorted);
+    }
+
     // Clear the list by deleting all nodes
     void clearList()
     {
@@ -238,7 +608,7 @@ public:
         while(delNode)
         {
             dlHead = delNode->next;
-            delete delNode;
+            destroyNode(delNode);
             delNode = dlHead;
         }
         dlHead = nullptr;
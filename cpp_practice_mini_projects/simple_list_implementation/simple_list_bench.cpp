@@ -0,0 +1,272 @@
+/* Insert/erase throughput of dList with different node allocators, against std::list
+    - fill/drain: push_back N nodes, then pop them all, a list growing and shrinking as a whole
+    - churn: list stays at a fixed size, every op erases the oldest node and appends a new one (LRU / queue pattern)
+    - churn on several threads, every thread with its own list, shows the shared pool is not a bottleneck
+Traversal/insertion of UnrolledList against the node lists, 1K to 10M elements
+    - push_back: build the list from scratch
+    - insert mid: one pass over the list inserting a new element before every 8th one
+    - traverse: sum of all elements, fresh list (nodes allocated in list order, the best case for node lists)
+    - traverse aged: half the elements erased in random order and appended again, so list order
+      no longer matches memory order, like a long running LRU
+Sorting a list of random keys: dList::sort (relinks nodes) vs std::list::sort vs copying the values
+into a std::vector, std::sort and copying them back. Small (8B) and big (64B) elements
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <list>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+#include "simple_list.h"
+#include "unrolled_list.h"
+
+struct Entry {
+    uint64_t key;
+    uint64_t value;
+    Entry(uint64_t k = 0, uint64_t v = 0) : key(k), value(v) {}
+};
+
+template <typename List>
+uint64_t churn(size_t list_size, size_t ops)
+{
+    List list;
+    for (size_t i = 0; i < list_size; i++)
+        list.emplace_back(i, i);
+    for (size_t i = 0; i < ops; i++) {
+        list.erase(list.begin());
+        list.emplace_back(list_size + i, i);
+    }
+    return list.size();
+}
+
+// keeps the compiler from dropping a benchmark loop whose result is unused
+static volatile uint64_t sink = 0;
+
+template <typename Func>
+double timeNsPerOp(size_t ops, Func&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed_ns / ops;
+}
+
+void report(const std::string& label, double ns_per_op)
+{
+    std::cout << std::left << std::setw(52) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(7) << ns_per_op << " ns/op" << std::endl;
+}
+
+template <typename List>
+void benchList(const std::string& name)
+{
+    size_t num_nodes = 1 << 20;
+    size_t rounds = 5;
+    // fill/drain: one op = one insert or one erase
+    report(name + " fill/drain", timeNsPerOp(2 * num_nodes * rounds, [&]() {
+        List list;
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t i = 0; i < num_nodes; i++)
+                list.emplace_back(i, round);
+            for (size_t i = 0; i < num_nodes; i++)
+                list.pop_back();
+        }
+        sink = list.size();
+    }));
+
+    size_t list_size = 10000;
+    size_t ops = 10000000;
+    // churn: one op = one erase + one insert
+    report(name + " churn", timeNsPerOp(ops, [&]() { sink = churn<List>(list_size, ops); }));
+
+    size_t num_threads = 4;
+    report(name + " churn, " + std::to_string(num_threads) + " threads", timeNsPerOp(ops, [&]() {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; t++)
+            threads.emplace_back([&]() { sink = churn<List>(list_size, ops / num_threads); });
+        for (auto& thread : threads)
+            thread.join();
+    }));
+}
+
+template <typename List>
+uint64_t sumAll(const List& list)
+{
+    uint64_t sum = 0;
+    for (const auto& value : list)
+        sum += value;
+    return sum;
+}
+
+template <typename List>
+void insertEvery8th(List& list)
+{
+    size_t idx = 0;
+    for (auto it = list.begin(); it != list.end(); ++it)
+        if (idx++ % 8 == 0)
+            it = list.insert(it, idx), ++it;
+}
+
+// Node lists: erase a random half through saved positions, then append as many again.
+// The freed nodes get reused in random order, so neighbours in the list end up far apart in memory
+template <typename List>
+void age(List& list, std::mt19937_64& rng)
+{
+    std::vector<typename List::iterator> nodes;
+    for (auto it = list.begin(); it != list.end(); ++it)
+        nodes.push_back(it);
+    std::shuffle(nodes.begin(), nodes.end(), rng);
+    nodes.resize(nodes.size() / 2);
+    for (auto it : nodes)
+        list.erase(it);
+    for (size_t i = 0; i < nodes.size(); i++)
+        list.emplace_back(i);
+}
+
+// UnrolledList can't hold on to positions across erases, erase every other element in one pass instead
+template <typename T, size_t NodeBytes, typename Alloc>
+void age(UnrolledList<T, NodeBytes, Alloc>& list, std::mt19937_64&)
+{
+    size_t erased = 0;
+    for (auto it = list.begin(); it != list.end();) {
+        it = list.erase(it);
+        erased++;
+        if (it != list.end())
+            ++it;
+    }
+    for (size_t i = 0; i < erased; i++)
+        list.emplace_back(i);
+}
+
+// After a big list was freed in random order glibc sits on millions of small free chunks, and the next
+// mid sized malloc consolidates all of them first (~2s for 10M). Pay that here, not inside the next measurement
+void settleHeap()
+{
+    ::operator delete(::operator new(64 * 1024));
+}
+
+template <typename List>
+void benchTraversal(const std::string& name)
+{
+    std::mt19937_64 rng(7);
+    for (size_t num_elements : {size_t(1000), size_t(10000), size_t(100000), size_t(1000000), size_t(10000000)}) {
+        // repeat small sizes, so every measurement covers ~20M elements
+        size_t repeats = std::max<size_t>(1, 20000000 / num_elements);
+        std::string label = name + " " + std::to_string(num_elements);
+
+        double push_ns = timeNsPerOp(num_elements * repeats, [&]() {
+            for (size_t r = 0; r < repeats; r++) {
+                List list;
+                for (size_t i = 0; i < num_elements; i++)
+                    list.emplace_back(i);
+                sink = list.size();
+            }
+        });
+
+        double traverse_ns, aged_ns, insert_ns;
+        {
+            List list;
+            for (size_t i = 0; i < num_elements; i++)
+                list.emplace_back(i);
+            traverse_ns = timeNsPerOp(num_elements * repeats, [&]() {
+                for (size_t r = 0; r < repeats; r++)
+                    sink = sumAll(list);
+            });
+            age(list, rng);
+            aged_ns = timeNsPerOp(num_elements * repeats, [&]() {
+                for (size_t r = 0; r < repeats; r++)
+                    sink = sumAll(list);
+            });
+            // one op = one element walked past (an insert every 8th)
+            insert_ns = timeNsPerOp(num_elements, [&]() { insertEvery8th(list); });
+        }
+        settleHeap();
+
+        std::cout << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(2)
+                  << " push_back " << std::setw(6) << push_ns << "  insert mid " << std::setw(6) << insert_ns
+                  << "  traverse " << std::setw(6) << traverse_ns << "  traverse aged " << std::setw(6) << aged_ns
+                  << "  ns/element" << std::endl;
+    }
+}
+
+struct Record {
+    uint64_t key;
+    char payload[56];
+    Record(uint64_t k = 0) : key(k), payload{} {}
+    bool operator<(const Record& other) const { return key < other.key; }
+};
+
+uint64_t keyOf(uint64_t value) { return value; }
+uint64_t keyOf(const Record& record) { return record.key; }
+
+template <typename List>
+void fillRandom(List& list, size_t num_elements, std::mt19937_64& rng)
+{
+    for (size_t i = 0; i < num_elements; i++)
+        list.emplace_back(rng());
+}
+
+template <typename T>
+void benchSort(const std::string& name)
+{
+    std::mt19937_64 rng(11);
+    for (size_t num_elements : {size_t(10000), size_t(100000), size_t(1000000)}) {
+        size_t repeats = std::max<size_t>(1, 2000000 / num_elements);
+        double dlist_ns = 0, stdlist_ns = 0, vector_ns = 0;
+        uint64_t check = 0;
+        for (size_t r = 0; r < repeats; r++) {
+            {
+                dList<T> list;
+                fillRandom(list, num_elements, rng);
+                dlist_ns += timeNsPerOp(num_elements, [&]() { list.sort(); });
+                check += keyOf(list.front());
+            }
+            {
+                std::list<T> list;
+                fillRandom(list, num_elements, rng);
+                stdlist_ns += timeNsPerOp(num_elements, [&]() { list.sort(); });
+                check += keyOf(list.front());
+            }
+            {
+                // what users did before dList had a sort
+                dList<T> list;
+                fillRandom(list, num_elements, rng);
+                vector_ns += timeNsPerOp(num_elements, [&]() {
+                    std::vector<T> values(std::make_move_iterator(list.begin()), std::make_move_iterator(list.end()));
+                    std::sort(values.begin(), values.end());
+                    std::move(values.begin(), values.end(), list.begin());
+                });
+                check += keyOf(list.front());
+            }
+        }
+        sink = check;
+        std::cout << std::left << std::setw(28) << (name + " " + std::to_string(num_elements)) << std::right << std::fixed
+                  << std::setprecision(1) << " dList::sort " << std::setw(6) << dlist_ns / repeats
+                  << "  std::list::sort " << std::setw(6) << stdlist_ns / repeats
+                  << "  vector + std::sort " << std::setw(6) << vector_ns / repeats << "  ns/element" << std::endl;
+        settleHeap();
+    }
+}
+
+int main()
+{
+    benchList<std::list<Entry>>("std::list");
+    benchList<std::list<Entry, SlabAllocator<Entry>>>("std::list + SlabAllocator");
+    benchList<dList<Entry, std::allocator<Entry>>>("dList new/delete");
+    benchList<dList<Entry>>("dList SlabAllocator (thread cached)");
+    benchList<dList<Entry, SlabAllocator<Entry, false>>>("dList SlabAllocator (per list pool)");
+
+    benchTraversal<std::list<uint64_t>>("std::list");
+    benchTraversal<dList<uint64_t, std::allocator<uint64_t>>>("dList new/delete");
+    benchTraversal<dList<uint64_t>>("dList SlabAllocator");
+    benchTraversal<UnrolledList<uint64_t>>("UnrolledList (128B chunks)");
+    benchTraversal<UnrolledList<uint64_t, 256>>("UnrolledList (256B chunks)");
+
+    benchSort<uint64_t>("sort 8B");
+    benchSort<Record>("sort 64B");
+    return 0;
+}
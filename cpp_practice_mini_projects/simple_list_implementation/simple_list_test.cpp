@@ -0,0 +1,547 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <list>
+#include <random>
+#include <memory>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "simple_list.h"
+#include "intrusive_list.h"
+#include "unrolled_list.h"
+#include "node_slab_allocator.h"
+#include "lock_free_list.h"
+#include "lock_free_skiplist.h"
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cout << "FAILED: " << #cond << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; \
+            failures++; \
+        } \
+    } while (0)
+
+static int failures = 0;
+
+// A timer that is on a deadline list and on its owner's list at once (base hooks),
+// plus a member hook for a third list
+struct ByDeadline {};
+struct ByOwner {};
+
+struct Timer : ListBaseHook<ByDeadline>, ListBaseHook<ByOwner> {
+    int id;
+    int deadline;
+    ListHook firedHook;
+
+    Timer(int id_, int deadline_) : id(id_), deadline(deadline_) {}
+};
+
+using DeadlineList = IntrusiveList<Timer, BaseHook<Timer, ByDeadline>>;
+using OwnerList = IntrusiveList<Timer, BaseHook<Timer, ByOwner>>;
+using FiredList = IntrusiveList<Timer, MemberHook<Timer, &Timer::firedHook>>;
+
+static_assert(std::bidirectional_iterator<DeadlineList::iterator>);
+static_assert(std::bidirectional_iterator<FiredList::const_iterator>);
+
+template <typename List>
+std::vector<int> ids(const List& list)
+{
+    std::vector<int> out;
+    for (const Timer& timer : list)
+        out.push_back(timer.id);
+    return out;
+}
+
+// Safe mode checks abort, run the misuse in a child and expect it to die on SIGABRT
+template <typename Fn>
+bool abortsInSafeMode(Fn misuse)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        // keep the assert message out of the test output
+        std::freopen("/dev/null", "w", stderr);
+        misuse();
+        std::_Exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+void testIntrusiveList()
+{
+    std::vector<Timer> timers;
+    for (int i = 0; i < 8; i++)
+        timers.emplace_back(i, 100 - i * 10);
+
+    DeadlineList byDeadline;
+    OwnerList byOwner;
+    FiredList fired;
+    // deadlines come in decreasing order, so push_front keeps the list sorted by deadline
+    for (Timer& timer : timers) {
+        byDeadline.push_front(timer);
+        if (timer.id % 2 == 0)
+            byOwner.push_back(timer);
+    }
+    CHECK(byDeadline.size() == 8);
+    CHECK(byOwner.size() == 4);
+    CHECK((ids(byDeadline) == std::vector<int>{7, 6, 5, 4, 3, 2, 1, 0}));
+    CHECK((ids(byOwner) == std::vector<int>{0, 2, 4, 6}));
+
+    // O(1) unlink from one list leaves the other lists alone
+    byDeadline.erase(timers[4]);
+    CHECK(!static_cast<ListBaseHook<ByDeadline>&>(timers[4]).isLinked());
+    CHECK(static_cast<ListBaseHook<ByOwner>&>(timers[4]).isLinked());
+    CHECK((ids(byDeadline) == std::vector<int>{7, 6, 5, 3, 2, 1, 0}));
+    CHECK((ids(byOwner) == std::vector<int>{0, 2, 4, 6}));
+
+    // move the expired ones to the fired list through the member hook
+    for (auto it = byDeadline.begin(); it != byDeadline.end();) {
+        if (it->deadline <= 50) {
+            fired.push_back(*it);
+            it = byDeadline.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    CHECK((ids(byDeadline) == std::vector<int>{3, 2, 1, 0}));
+    CHECK((ids(fired) == std::vector<int>{7, 6, 5}));
+
+    // standard algorithms on the iterators
+    auto found = std::find_if(byOwner.begin(), byOwner.end(), [](const Timer& timer) { return timer.id == 4; });
+    CHECK(found != byOwner.end() && found->deadline == 60);
+    CHECK(std::count_if(byDeadline.cbegin(), byDeadline.cend(), [](const Timer& timer) { return timer.id % 2; }) == 2);
+    CHECK(std::distance(fired.begin(), fired.end()) == 3);
+    CHECK(std::accumulate(byOwner.begin(), byOwner.end(), 0, [](int sum, const Timer& timer) { return sum + timer.id; }) == 12);
+    std::vector<int> reversed;
+    for (auto it = fired.rbegin(); it != fired.rend(); ++it)
+        reversed.push_back(it->id);
+    CHECK((reversed == std::vector<int>{5, 6, 7}));
+
+    // insert before an element found through iteratorTo, no search
+    byDeadline.insert(byDeadline.iteratorTo(timers[1]), timers[4]);
+    CHECK((ids(byDeadline) == std::vector<int>{3, 2, 4, 1, 0}));
+
+#ifndef NDEBUG
+    // same hook type, other list: erasing through the wrong list aborts instead of skewing both counts
+    DeadlineList other;
+    CHECK(abortsInSafeMode([&] { other.erase(timers[3]); }));
+    CHECK(abortsInSafeMode([&] { other.iteratorTo(timers[3]); }));
+    byDeadline.erase(timers[3]);
+    other.push_back(timers[3]);
+    CHECK(abortsInSafeMode([&] { byDeadline.erase(timers[3]); }));
+    other.erase(timers[3]);
+    byDeadline.push_front(timers[3]);
+    CHECK((ids(byDeadline) == std::vector<int>{3, 2, 4, 1, 0}));
+    CHECK(other.empty());
+#endif
+
+    // a copy of a linked element is not on any list
+    Timer copy = timers[0];
+    CHECK(!static_cast<ListBaseHook<ByDeadline>&>(copy).isLinked());
+    CHECK(!copy.firedHook.isLinked());
+
+    // the lists must be emptied before the timers die, clear() only unlinks
+    byDeadline.clear();
+    byOwner.clear();
+    fired.clear();
+    CHECK(byDeadline.empty() && byOwner.empty() && fired.empty());
+    CHECK(!timers[0].firedHook.isLinked());
+    std::cout << "IntrusiveList: done" << std::endl;
+}
+
+// Random ops on UnrolledList and std::list side by side, contents must match after every round.
+// Small chunks, so splits and merges happen all the time
+void testUnrolledList()
+{
+    using Unrolled = UnrolledList<std::unique_ptr<int>, 64>;   // move only element, catches stray copies
+    static_assert(std::bidirectional_iterator<Unrolled::iterator>);
+    Unrolled unrolled;
+    std::list<int> reference;
+    std::mt19937 rng(42);
+    int next_value = 0;
+
+    auto matches = [&]() {
+        if (unrolled.size() != reference.size())
+            return false;
+        auto ref_it = reference.begin();
+        for (auto& value : unrolled)
+            if (*value != *ref_it++)
+                return false;
+        // and backwards, through end()--
+        auto ref_rit = reference.rbegin();
+        for (auto it = unrolled.end(); it != unrolled.begin();)
+            if (**--it != *ref_rit++)
+                return false;
+        return true;
+    };
+
+    for (int round = 0; round < 20000; round++) {
+        int op = rng() % 6;
+        if (op == 0) {
+            unrolled.push_back(std::make_unique<int>(next_value));
+            reference.push_back(next_value++);
+        } else if (op == 1) {
+            unrolled.push_front(std::make_unique<int>(next_value));
+            reference.push_front(next_value++);
+        } else if (op == 2 && !reference.empty()) {
+            CHECK(*unrolled.pop_back() == reference.back());
+            reference.pop_back();
+        } else if (op == 3 && !reference.empty()) {
+            CHECK(*unrolled.pop_front() == reference.front());
+            reference.pop_front();
+        } else if (op == 4) {
+            std::size_t pos = reference.empty() ? 0 : rng() % (reference.size() + 1);
+            auto it = unrolled.begin();
+            std::advance(it, pos);
+            auto ref_it = reference.begin();
+            std::advance(ref_it, pos);
+            auto inserted = unrolled.emplace(it, std::make_unique<int>(next_value));
+            reference.insert(ref_it, next_value++);
+            CHECK(**inserted == next_value - 1);
+        } else if (op == 5 && !reference.empty()) {
+            std::size_t pos = rng() % reference.size();
+            auto it = unrolled.begin();
+            std::advance(it, pos);
+            auto ref_it = reference.begin();
+            std::advance(ref_it, pos);
+            auto after = unrolled.erase(it);
+            auto ref_after = reference.erase(ref_it);
+            CHECK((after == unrolled.end()) == (ref_after == reference.end()));
+            if (ref_after != reference.end())
+                CHECK(**after == *ref_after);
+        }
+        if (round % 1000 == 0)
+            CHECK(matches());
+    }
+    CHECK(matches());
+
+    // push_back only: chunks are completely full
+    UnrolledList<int> packed;
+    for (int i = 0; i < 1000; i++)
+        packed.push_back(i);
+    CHECK(packed.chunkCount() == (1000 + UnrolledList<int>::chunk_capacity - 1) / UnrolledList<int>::chunk_capacity);
+    CHECK(std::accumulate(packed.begin(), packed.end(), 0) == 999 * 1000 / 2);
+    std::cout << "UnrolledList: done, " << unrolled.size() << " elements in " << unrolled.chunkCount() << " chunks" << std::endl;
+}
+
+// Slabs are handed out one at a time, go back to the OS once empty, and a drained slab is carved in order again
+void testSlabPool()
+{
+    using Pool = SlabPool<24, 8>;
+    Pool pool;
+    std::size_t num_blocks = 10 * Pool::blocks_per_slab + 7;
+    std::vector<void*> blocks;
+    for (std::size_t i = 0; i < num_blocks; i++)
+        blocks.push_back(pool.allocate());
+    CHECK(pool.slabCount() == 11);
+    CHECK(pool.freeBlocks() == 11 * Pool::blocks_per_slab - num_blocks);
+    for (void* block : blocks)
+        CHECK(reinterpret_cast<std::uintptr_t>(block) % 8 == 0);
+
+    // free in random order: every block goes back to its own slab, empty slabs are released but one
+    std::mt19937 rng(3);
+    std::shuffle(blocks.begin(), blocks.end(), rng);
+    for (std::size_t i = 0; i < num_blocks / 2; i++)
+        pool.deallocate(blocks[i]);
+    CHECK(pool.freeBlocks() == pool.slabCount() * Pool::blocks_per_slab - (num_blocks - num_blocks / 2));
+    for (std::size_t i = num_blocks / 2; i < num_blocks; i++)
+        pool.deallocate(blocks[i]);
+    CHECK(pool.slabCount() <= 2);
+
+    // everything came back, so new blocks are consecutive again instead of following the free order
+    char* previous = static_cast<char*>(pool.allocate());
+    bool consecutive = true;
+    for (std::size_t i = 1; i < Pool::blocks_per_slab; i++) {
+        char* block = static_cast<char*>(pool.allocate());
+        consecutive = consecutive && block == previous + Pool::block_size;
+        previous = block;
+    }
+    CHECK(consecutive);
+    std::cout << "SlabPool: done" << std::endl;
+}
+
+template <typename List>
+std::vector<int> values(const List& list)
+{
+    std::vector<int> out(list.begin(), list.end());
+    // walk back too, so prev links are checked as well
+    std::vector<int> backwards(list.rbegin(), list.rend());
+    std::reverse(backwards.begin(), backwards.end());
+    CHECK(out == backwards);
+    CHECK(out.size() == list.size());
+    return out;
+}
+
+template <typename Alloc>
+void testDListSplice(const std::string& name)
+{
+    dList<int, Alloc> a{1, 2, 3, 4, 5};
+    dList<int, Alloc> b{10, 20, 30};
+
+    // single node to the front of another list
+    a.splice(a.begin(), b, std::next(b.begin()));
+    CHECK((values(a) == std::vector<int>{20, 1, 2, 3, 4, 5}));
+    CHECK((values(b) == std::vector<int>{10, 30}));
+
+    // range [2,4) of a to the end of b, counted
+    auto first = std::find(a.begin(), a.end(), 2);
+    auto last = std::find(a.begin(), a.end(), 4);
+    b.splice(b.end(), a, first, last);
+    CHECK((values(a) == std::vector<int>{20, 1, 4, 5}));
+    CHECK((values(b) == std::vector<int>{10, 30, 2, 3}));
+
+    // range within one list: move the tail [4,5] to the front
+    a.splice(a.begin(), a, std::find(a.begin(), a.end(), 4), a.end());
+    CHECK((values(a) == std::vector<int>{4, 5, 20, 1}));
+
+    // whole list, O(1)
+    a.splice(std::next(a.begin()), b);
+    CHECK((values(a) == std::vector<int>{4, 10, 30, 2, 3, 5, 20, 1}));
+    CHECK(b.empty() && b.begin() == b.end());
+
+    // splicing into an empty list
+    b.splice(b.end(), a, a.begin(), a.end(), a.size());
+    CHECK(a.empty());
+    CHECK((values(b) == std::vector<int>{4, 10, 30, 2, 3, 5, 20, 1}));
+    std::cout << "dList splice (" << name << "): done" << std::endl;
+}
+
+void testDList()
+{
+    static_assert(std::bidirectional_iterator<dList<int>::iterator>);
+    static_assert(std::bidirectional_iterator<dList<int>::const_iterator>);
+
+    dList<int> list{5, 3, 8, 1};
+    CHECK((values(list) == std::vector<int>{5, 3, 8, 1}));
+    CHECK(*std::max_element(list.begin(), list.end()) == 8);
+    CHECK(std::count_if(list.cbegin(), list.cend(), [](int v) { return v > 2; }) == 3);
+
+    // iterator insert/erase
+    auto it = list.insert(std::find(list.begin(), list.end(), 8), 7);
+    CHECK(*it == 7);
+    it = list.erase(std::find(list.begin(), list.end(), 3));
+    CHECK(*it == 7);
+    list.emplace(list.end(), 9);
+    CHECK((values(list) == std::vector<int>{5, 7, 8, 1, 9}));
+    CHECK(list.front() == 5 && list.back() == 9);
+    CHECK(*std::prev(list.end()) == 9);
+
+    testDListSplice<SlabAllocator<int>>("shared slab");
+    testDListSplice<std::allocator<int>>("new/delete");
+    // per list pools can't take each other's nodes, so values get moved instead of relinked
+    testDListSplice<SlabAllocator<int, false>>("per list pool");
+
+    // sort relinks nodes: elements keep their address, stable for equal keys
+    std::mt19937 rng(3);
+    dList<std::pair<int, int>> pairs;
+    for (int i = 0; i < 5000; i++)
+        pairs.emplace_back(static_cast<int>(rng() % 100), i);
+    std::vector<const std::pair<int, int>*> addresses;
+    for (auto& pair : pairs)
+        addresses.push_back(&pair);
+    std::vector<std::pair<int, int>> expected(pairs.begin(), pairs.end());
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    pairs.sort([](const auto& x, const auto& y) { return x.first < y.first; });
+    CHECK(std::equal(pairs.begin(), pairs.end(), expected.begin(), expected.end()));
+    std::sort(addresses.begin(), addresses.end(), [](auto x, auto y) { return *x < *y; });
+    std::vector<const std::pair<int, int>*> sortedAddresses;
+    for (auto& pair : pairs)
+        sortedAddresses.push_back(&pair);
+    std::sort(sortedAddresses.begin(), sortedAddresses.end(), [](auto x, auto y) { return *x < *y; });
+    CHECK(addresses == sortedAddresses);
+    CHECK(std::prev(pairs.end())->first == 99 && pairs.size() == 5000);
+
+    // move only elements, descending comparator, sizes around the bin boundaries
+    for (int count : {0, 1, 2, 3, 63, 64, 65, 1000}) {
+        dList<std::unique_ptr<int>> owned;
+        std::vector<int> reference;
+        for (int i = 0; i < count; i++) {
+            int value = static_cast<int>(rng() % 1000);
+            owned.emplace_back(std::make_unique<int>(value));
+            reference.push_back(value);
+        }
+        owned.sort([](const auto& x, const auto& y) { return *x > *y; });
+        std::sort(reference.begin(), reference.end(), std::greater<>());
+        std::vector<int> sorted;
+        for (auto& value : owned)
+            sorted.push_back(*value);
+        CHECK(sorted == reference);
+        if (count)
+            CHECK(*owned.back() == reference.back());
+    }
+
+    // merge of two sorted lists, equal elements of the target first
+    dList<std::pair<int, char>> left{{1, 'a'}, {3, 'a'}, {5, 'a'}};
+    dList<std::pair<int, char>> right{{1, 'b'}, {2, 'b'}, {5, 'b'}, {9, 'b'}};
+    left.merge(right, [](const auto& x, const auto& y) { return x.first < y.first; });
+    std::vector<std::pair<int, char>> merged(left.begin(), left.end());
+    CHECK((merged == std::vector<std::pair<int, char>>{{1, 'a'}, {1, 'b'}, {2, 'b'}, {3, 'a'}, {5, 'a'}, {5, 'b'}, {9, 'b'}}));
+    CHECK(right.empty() && left.size() == 7 && left.back().first == 9);
+
+    dList<int, SlabAllocator<int, false>> pooledLeft{1, 4, 6};
+    dList<int, SlabAllocator<int, false>> pooledRight{2, 3, 7};
+    pooledLeft.merge(pooledRight);
+    CHECK((values(pooledLeft) == std::vector<int>{1, 2, 3, 4, 6, 7}));
+    CHECK(pooledRight.empty());
+    std::cout << "dList iterators/sort/merge: done" << std::endl;
+}
+
+template <typename Set>
+std::vector<int> keys(const Set& set)
+{
+    std::vector<int> out;
+    set.forEach([&](int key) { out.push_back(key); });
+    return out;
+}
+
+// Same checks for LockFreeList and LockFreeSkipList. Built with ASan, a node freed too early shows up as use-after-free
+template <typename Set>
+void testConcurrentSet(const std::string& name)
+{
+    // single thread, against std::set
+    {
+        Set set;
+        std::set<int> reference;
+        std::mt19937 rng(5);
+        for (int round = 0; round < 20000; round++) {
+            int key = rng() % 500;
+            int op = rng() % 3;
+            if (op == 0)
+                CHECK(set.insert(key) == reference.insert(key).second);
+            else if (op == 1)
+                CHECK(set.erase(key) == (reference.erase(key) == 1));
+            else
+                CHECK(set.contains(key) == (reference.count(key) == 1));
+        }
+        CHECK((keys(set) == std::vector<int>(reference.begin(), reference.end())));
+        CHECK(set.size() == reference.size());
+    }
+
+    // a thread whose first call pins (before it allocates anything) exits with nodes still retired:
+    // the reclaimer frees them at thread exit, after the slab thread cache is already gone
+    {
+        Set set;
+        std::thread([&]() {
+            set.contains(0);
+            for (int key = 0; key < 1000; key++)
+                set.insert(key);
+            for (int key = 0; key < 1000; key++)
+                set.erase(key);
+        }).join();
+        CHECK(set.empty());
+    }
+
+    int num_threads = 4;
+    // every thread inserts its own keys and erases the odd ones, while reading everybody's
+    {
+        Set set;
+        int per_thread = 2000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < per_thread; i++)
+                    set.insert(i * num_threads + t);
+                for (int i = 1; i < per_thread; i += 2) {
+                    set.erase(i * num_threads + t);
+                    set.contains(i * num_threads + (t + 1) % num_threads);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        std::vector<int> expected;
+        for (int i = 0; i < per_thread; i += 2)
+            for (int t = 0; t < num_threads; t++)
+                expected.push_back(i * num_threads + t);
+        CHECK((keys(set) == expected));
+        CHECK(set.size() == expected.size());
+    }
+
+    // all threads fight over a few keys. Every successful insert/erase is counted,
+    // per key the inserts minus erases must be 1 if the key ended up in the set, 0 if not
+    {
+        Set set;
+        int num_keys = 32;
+        std::vector<std::atomic<int>> balance(num_keys);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t]() {
+                std::mt19937 rng(100 + t);
+                for (int i = 0; i < 20000; i++) {
+                    int key = rng() % num_keys;
+                    if (rng() % 2) {
+                        if (set.insert(key))
+                            balance[key]++;
+                    } else if (set.erase(key)) {
+                        balance[key]--;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        bool consistent = true;
+        for (int key = 0; key < num_keys; key++)
+            consistent = consistent && balance[key] == (set.contains(key) ? 1 : 0);
+        CHECK(consistent);
+    }
+    EpochReclaimer::flush();
+    CHECK(EpochReclaimer::pending() == 0);
+    std::cout << name << ": done" << std::endl;
+}
+
+// Threads draining a skip list through popMin get every key exactly once, each thread in increasing order
+void testSkipListPopMin()
+{
+    LockFreeSkipList<int> set;
+    int num_keys = 10000;
+    for (int key = num_keys - 1; key >= 0; key--)
+        set.insert(key);
+    int num_threads = 4;
+    std::vector<std::vector<int>> popped(num_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            int key;
+            while (set.popMin(key))
+                popped[t].push_back(key);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    std::vector<int> all;
+    for (auto& keys_popped : popped) {
+        CHECK(std::is_sorted(keys_popped.begin(), keys_popped.end()));
+        all.insert(all.end(), keys_popped.begin(), keys_popped.end());
+    }
+    std::sort(all.begin(), all.end());
+    std::vector<int> expected(num_keys);
+    std::iota(expected.begin(), expected.end(), 0);
+    CHECK(all == expected);
+    CHECK(set.empty());
+    std::cout << "LockFreeSkipList popMin: done" << std::endl;
+}
+
+int main()
+{
+    testSlabPool();
+    testDList();
+    testIntrusiveList();
+    testUnrolledList();
+    testConcurrentSet<LockFreeList<int>>("LockFreeList");
+    testConcurrentSet<LockFreeSkipList<int>>("LockFreeSkipList");
+    testSkipListPopMin();
+    std::cout << (failures ? "Some checks FAILED" : "All checks passed") << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,436 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "node_slab_allocator.h"
+
+/*
+Unrolled (chunked) variant of dList
+    - dList walks one heap node per element, so every step of a traversal is a dependent load,
+      and mostly a cache miss once the list is bigger than the cache.
+    - Here every node (Chunk) holds a small array of T, sized so a chunk is NodeBytes (default 2 cache lines),
+      and a traversal does one pointer chase per chunk instead of per element.
+    - Elements of a chunk sit in slots [first, last), contiguous. Keeping a gap on both sides lets
+      push_front/push_back work inside the head/tail chunk until it is full, then a new chunk is linked,
+      so both ends stay O(1).
+    - insert/erase in the middle shift the elements of one chunk only (at most a chunk's worth of moves).
+      A full chunk is split in two halves, a nearly empty one is merged with its successor.
+
+Iterator validity (the price for the cache friendliness, dList/std::list never invalidate):
+    - push/emplace/pop at either end keep every iterator valid, except the ones to a popped element
+    - insert/erase invalidate iterators into the chunk that was touched (and into the one it was split/merged with),
+      iterators into every other chunk stay valid. Use the returned iterator to continue
+*/
+template <typename T, std::size_t NodeBytes = 128, typename Alloc = SlabAllocator<T>>
+class UnrolledList {
+private:
+    struct ChunkHeader {
+        void* next;
+        void* prev;
+        uint32_t first;
+        uint32_t last;
+    };
+
+public:
+    // slots per chunk, never less than 4 or the split/merge logic is pointless
+    static constexpr std::size_t chunk_capacity =
+        std::max<std::size_t>(4, (NodeBytes > sizeof(ChunkHeader)) ? (NodeBytes - sizeof(ChunkHeader)) / sizeof(T) : 0);
+
+private:
+    struct Chunk {
+        Chunk* next = nullptr;
+        Chunk* prev = nullptr;
+        uint32_t first = 0;     // slots [first, last) hold constructed elements
+        uint32_t last = 0;
+        alignas(T) unsigned char storage[chunk_capacity * sizeof(T)];
+
+        T* slot(std::size_t idx) {
+            return reinterpret_cast<T*>(storage) + idx;
+        }
+
+        std::size_t count() const {
+            return last - first;
+        }
+    };
+
+    using ChunkAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Chunk>;
+    using ChunkTraits = std::allocator_traits<ChunkAlloc>;
+
+    [[no_unique_address]] ChunkAlloc chunkAlloc;
+    Chunk* headChunk = nullptr;
+    Chunk* tailChunk = nullptr;
+    std::size_t numElements = 0;
+
+    Chunk* newChunk(uint32_t start)
+    {
+        Chunk* chunk = ChunkTraits::allocate(chunkAlloc, 1);
+        // default init, not Chunk(), which would zero the whole storage array first
+        ::new (static_cast<void*>(chunk)) Chunk;
+        chunk->first = start;
+        chunk->last = start;
+        return chunk;
+    }
+
+    void freeChunk(Chunk* chunk)
+    {
+        for (uint32_t idx = chunk->first; idx < chunk->last; idx++)
+            chunk->slot(idx)->~T();
+        chunk->~Chunk();
+        ChunkTraits::deallocate(chunkAlloc, chunk, 1);
+    }
+
+    // Link a fresh chunk right after prev (or as the new head if prev is nullptr)
+    void linkAfter(Chunk* prev, Chunk* chunk)
+    {
+        Chunk* next = prev ? prev->next : headChunk;
+        chunk->prev = prev;
+        chunk->next = next;
+        if (prev)
+            prev->next = chunk;
+        else
+            headChunk = chunk;
+        if (next)
+            next->prev = chunk;
+        else
+            tailChunk = chunk;
+    }
+
+    void unlinkChunk(Chunk* chunk)
+    {
+        if (chunk->prev)
+            chunk->prev->next = chunk->next;
+        else
+            headChunk = chunk->next;
+        if (chunk->next)
+            chunk->next->prev = chunk->prev;
+        else
+            tailChunk = chunk->prev;
+    }
+
+    // Move-construct slot src into empty slot dst and destroy src
+    static void relocate(Chunk* from, uint32_t src, Chunk* to, uint32_t dst)
+    {
+        ::new (static_cast<void*>(to->slot(dst))) T(std::move(*from->slot(src)));
+        from->slot(src)->~T();
+    }
+
+    // Slide a chunk's elements so they start at slot 0, making room at the back
+    static void compactToFront(Chunk* chunk)
+    {
+        if (chunk->first == 0)
+            return;
+        uint32_t dst = 0;
+        for (uint32_t idx = chunk->first; idx < chunk->last; idx++, dst++)
+            relocate(chunk, idx, chunk, dst);
+        chunk->first = 0;
+        chunk->last = dst;
+    }
+
+    // Full chunk: move its upper half into a new chunk linked after it
+    Chunk* split(Chunk* chunk)
+    {
+        Chunk* upper = newChunk(0);
+        uint32_t mid = chunk->first + static_cast<uint32_t>(chunk->count() / 2);
+        for (uint32_t idx = mid; idx < chunk->last; idx++)
+            relocate(chunk, idx, upper, upper->last++);
+        chunk->last = mid;
+        linkAfter(chunk, upper);
+        return upper;
+    }
+
+public:
+    template <bool IsConst>
+    class Iterator {
+    private:
+        using ListPtr = std::conditional_t<IsConst, const UnrolledList*, UnrolledList*>;
+        ListPtr list = nullptr;
+        Chunk* chunk = nullptr;    // nullptr is end()
+        uint32_t idx = 0;
+
+        friend class UnrolledList;
+        template <bool> friend class Iterator;
+
+        Iterator(ListPtr owner, Chunk* chunk_, uint32_t idx_) : list(owner), chunk(chunk_), idx(idx_) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+        Iterator(const Iterator<WasConst>& other) : list(other.list), chunk(other.chunk), idx(other.idx) {}
+
+        reference operator*() const {
+            return *chunk->slot(idx);
+        }
+
+        pointer operator->() const {
+            return chunk->slot(idx);
+        }
+
+        Iterator& operator++()
+        {
+            if (++idx == chunk->last) {
+                chunk = chunk->next;
+                idx = chunk ? chunk->first : 0;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        Iterator& operator--()
+        {
+            if (!chunk) {
+                chunk = list->tailChunk;
+                idx = chunk->last - 1;
+            } else if (idx == chunk->first) {
+                chunk = chunk->prev;
+                idx = chunk->last - 1;
+            } else {
+                idx--;
+            }
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.chunk == rhs.chunk && lhs.idx == rhs.idx;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return !(lhs == rhs);
+        }
+    };
+
+    using value_type = T;
+    using allocator_type = Alloc;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    UnrolledList() = default;
+
+    explicit UnrolledList(const Alloc& alloc) : chunkAlloc(alloc) {}
+
+    UnrolledList(std::initializer_list<T> values)
+    {
+        for (const T& value : values)
+            push_back(value);
+    }
+
+    UnrolledList(const UnrolledList&) = delete;
+    UnrolledList& operator=(const UnrolledList&) = delete;
+
+    ~UnrolledList()
+    {
+        clearList();
+    }
+
+    iterator begin() { return iterator(this, headChunk, headChunk ? headChunk->first : 0); }
+    iterator end() { return iterator(this, nullptr, 0); }
+    const_iterator begin() const { return const_iterator(this, headChunk, headChunk ? headChunk->first : 0); }
+    const_iterator end() const { return const_iterator(this, nullptr, 0); }
+
+    std::size_t size() const {
+        return numElements;
+    }
+
+    bool empty() const {
+        return numElements == 0;
+    }
+
+    T& front() {
+        return *headChunk->slot(headChunk->first);
+    }
+
+    T& back() {
+        return *tailChunk->slot(tailChunk->last - 1);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (!tailChunk || tailChunk->last == chunk_capacity)
+            linkAfter(tailChunk, newChunk(0));
+        T* value = ::new (static_cast<void*>(tailChunk->slot(tailChunk->last))) T(std::forward<Args>(args)...);
+        tailChunk->last++;
+        numElements++;
+        return *value;
+    }
+
+    // A new head chunk is filled from its end, so repeated push_front keeps filling the same chunk
+    template <typename... Args>
+    T& emplace_front(Args&&... args)
+    {
+        if (!headChunk || headChunk->first == 0)
+            linkAfter(nullptr, newChunk(chunk_capacity));
+        T* value = ::new (static_cast<void*>(headChunk->slot(headChunk->first - 1))) T(std::forward<Args>(args)...);
+        headChunk->first--;
+        numElements++;
+        return *value;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    void push_front(const T& value) { emplace_front(value); }
+    void push_front(T&& value) { emplace_front(std::move(value)); }
+
+    // Same contract as dList::pop_back, the value is returned and an empty list throws
+    T pop_back()
+    {
+        if (!tailChunk)
+            throw std::out_of_range("Cannot pop from an empty list");
+        Chunk* chunk = tailChunk;
+        T value = std::move(*chunk->slot(chunk->last - 1));
+        chunk->slot(--chunk->last)->~T();
+        numElements--;
+        if (chunk->count() == 0) {
+            unlinkChunk(chunk);
+            freeChunk(chunk);
+        }
+        return value;
+    }
+
+    T pop_front()
+    {
+        if (!headChunk)
+            throw std::out_of_range("Cannot pop from an empty list");
+        Chunk* chunk = headChunk;
+        T value = std::move(*chunk->slot(chunk->first));
+        chunk->slot(chunk->first++)->~T();
+        numElements--;
+        if (chunk->count() == 0) {
+            unlinkChunk(chunk);
+            freeChunk(chunk);
+        }
+        return value;
+    }
+
+    // Construct a value just before position, returns an iterator to it
+    template <typename... Args>
+    iterator emplace(const_iterator position, Args&&... args)
+    {
+        Chunk* chunk = position.chunk;
+        if (!chunk) {
+            emplace_back(std::forward<Args>(args)...);
+            return iterator(this, tailChunk, tailChunk->last - 1);
+        }
+        uint32_t idx = position.idx;
+
+        if (chunk->count() == chunk_capacity) {
+            Chunk* upper = split(chunk);
+            if (idx >= chunk->last) {
+                idx = upper->first + (idx - chunk->last);
+                chunk = upper;
+            }
+        }
+
+        // Build the value first, so an exception from T's constructor leaves the chunk untouched
+        T value(std::forward<Args>(args)...);
+        if (chunk->last < chunk_capacity) {
+            // open a gap at idx by sliding [idx, last) one slot right
+            for (uint32_t src = chunk->last; src > idx; src--)
+                relocate(chunk, src - 1, chunk, src);
+            chunk->last++;
+        } else {
+            // no room at the back, slide [first, idx) one slot left instead
+            for (uint32_t src = chunk->first; src < idx; src++)
+                relocate(chunk, src, chunk, src - 1);
+            chunk->first--;
+            idx--;
+        }
+        ::new (static_cast<void*>(chunk->slot(idx))) T(std::move(value));
+        numElements++;
+        return iterator(this, chunk, idx);
+    }
+
+    iterator insert(const_iterator position, const T& value) {
+        return emplace(position, value);
+    }
+
+    iterator insert(const_iterator position, T&& value) {
+        return emplace(position, std::move(value));
+    }
+
+    // Erase the element at position, returns an iterator to the element after it
+    iterator erase(const_iterator position)
+    {
+        Chunk* chunk = position.chunk;
+        uint32_t offset = position.idx - chunk->first;   // of the next element, once the gap is closed
+
+        chunk->slot(position.idx)->~T();
+        for (uint32_t src = position.idx + 1; src < chunk->last; src++)
+            relocate(chunk, src, chunk, src - 1);
+        chunk->last--;
+        numElements--;
+
+        if (chunk->count() == 0) {
+            Chunk* next = chunk->next;
+            unlinkChunk(chunk);
+            freeChunk(chunk);
+            return iterator(this, next, next ? next->first : 0);
+        }
+
+        // Keep chunks reasonably full, or traversal degrades to one element per pointer chase again
+        Chunk* next = chunk->next;
+        if ((chunk->count() < chunk_capacity / 4) && next && (chunk->count() + next->count() <= chunk_capacity)) {
+            compactToFront(chunk);
+            for (uint32_t idx = next->first; idx < next->last; idx++)
+                relocate(next, idx, chunk, chunk->last++);
+            next->last = next->first;
+            unlinkChunk(next);
+            freeChunk(next);
+        }
+
+        if (chunk->first + offset < chunk->last)
+            return iterator(this, chunk, chunk->first + offset);
+        next = chunk->next;
+        return iterator(this, next, next ? next->first : 0);
+    }
+
+    void clearList()
+    {
+        Chunk* chunk = headChunk;
+        while (chunk) {
+            Chunk* next = chunk->next;
+            freeChunk(chunk);
+            chunk = next;
+        }
+        headChunk = nullptr;
+        tailChunk = nullptr;
+        numElements = 0;
+    }
+
+    // chunks in use, mostly to see how full they are (size() / chunkCount())
+    std::size_t chunkCount() const
+    {
+        std::size_t chunks = 0;
+        for (Chunk* chunk = headChunk; chunk; chunk = chunk->next)
+            chunks++;
+        return chunks;
+    }
+};
+
+#endif // UNROLLED_LIST_H
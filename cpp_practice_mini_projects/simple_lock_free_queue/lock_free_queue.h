@@ -31,6 +31,8 @@
  * 
  */
 
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
 
 #include <cstddef>
 #include <atomic>
@@ -139,12 +141,11 @@ public:
         // Check if queue is empty
         //we want to access the tail under the condition that the producer is done pushing new element and incrementing the tail
         // so we need to impose an order here as well, that consumer views the updated tail published by consumer
+        // No DEBUG print here, unlike a full queue: polling consumers (actor shard channels, pipeline stages)
+        // find the queue empty on almost every idle pass
         if (front == tail.index.load(std::memory_order_acquire))
         //if (front == tail.index.load(std::memory_order_seq_cst))
         {
-#ifdef DEBUG
-            std::cout << "Queue is empty" << std::endl;
-#endif
             return false;
         }
         //out = ring_buff[front];
@@ -177,4 +178,6 @@ public:
         return next == head.load(std::memory_order_acquire);
     }
     */
-};
\ No newline at end of file
+};
+
+#endif /* LOCK_FREE_QUEUE_H */
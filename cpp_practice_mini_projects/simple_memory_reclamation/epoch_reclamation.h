@@ -0,0 +1,167 @@
+#ifndef EPOCH_RECLAMATION_H
+#define EPOCH_RECLAMATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "thread_registry.h"
+
+/*
+Epoch based reclamation (EBR), the scheme from Fraser's thesis, same idea as crossbeam-epoch
+    - A lock-free container unlinks a node while other threads may still be walking over it, so the node
+      can't be deleted right away. retire() parks it until no thread can possibly hold a pointer to it anymore.
+    - Every operation on the container runs inside an EpochGuard, which pins the thread: it announces the
+      global epoch it saw. The global epoch only moves from e to e+1 once every pinned thread has seen e.
+    - A node retired while the global epoch was e was already unlinked by then. Anyone pinned at e+1 or later
+      started after that and can't reach it, and the epoch can't get to e+2 while someone is still pinned at e.
+      So once the global epoch is e+2 the node is freed.
+    - Cheap for readers: one store and one fence per operation, nothing per pointer followed (hazard pointers
+      pay per pointer). The catch: a thread that stays pinned for long holds back every free in the process.
+    - Threads register on first use and unregister when they exit (thread_registry.h), what an exiting thread
+      could not free yet is left to the others.
+    - hazard_pointers.h is the other option: more work per pointer read, but a stalled thread only holds back
+      the few nodes it points at.
+*/
+class EpochReclaimer {
+public:
+    static constexpr uint64_t not_pinned = ~uint64_t(0);
+    static constexpr std::size_t collect_every = 64;   // a thread tries to free its retired nodes every 64 retires
+
+private:
+    // one per thread, own cache line since other threads read epoch in tryAdvance()
+    struct alignas(64) ThreadRecord {
+        std::atomic<uint64_t> epoch{not_pinned};
+        std::atomic<bool> inUse{true};
+        ThreadRecord* next = nullptr;
+        unsigned depth = 0;                // nested guards, owner thread only
+        std::vector<RetiredPtr> retired;   // owner thread only, tag = epoch, never decreases along it
+    };
+
+    struct Global {
+        alignas(64) std::atomic<uint64_t> epoch{0};
+        ThreadRegistry<ThreadRecord> registry;
+    };
+
+    // Leaked on purpose (like the slab pool): a thread exiting during static destruction still releases its record here
+    static Global& global()
+    {
+        static Global* instance = new Global();
+        return *instance;
+    }
+
+    static void releaseRecord(ThreadRecord* record)
+    {
+        collect(*record);
+        global().registry.addOrphans(record->retired);
+        record->epoch.store(not_pinned, std::memory_order_release);
+        global().registry.release(record);
+    }
+
+    struct ThreadHandle {
+        ThreadRecord* record = global().registry.acquire();
+        ~ThreadHandle() { releaseRecord(record); }
+    };
+
+    static ThreadRecord& local()
+    {
+        static thread_local ThreadHandle handle;
+        return *handle.record;
+    }
+
+    // Move the epoch forward if every pinned thread has caught up with it
+    static bool tryAdvance()
+    {
+        Global& g = global();
+        uint64_t current = g.epoch.load(std::memory_order_seq_cst);
+        bool lagging = false;
+        g.registry.forEach([&](ThreadRecord& record) {
+            uint64_t seen = record.epoch.load(std::memory_order_seq_cst);
+            lagging = lagging || (seen != not_pinned && seen != current);
+        });
+        return !lagging && g.epoch.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst);
+    }
+
+    static void collect(ThreadRecord& record)
+    {
+        tryAdvance();
+        Global& g = global();
+        uint64_t current = g.epoch.load(std::memory_order_seq_cst);
+        auto freeable = [current](const RetiredPtr& entry) { return entry.tag + 2 <= current; };
+
+        // retired is ordered by epoch, the freeable ones are a prefix
+        auto end = std::find_if_not(record.retired.begin(), record.retired.end(), freeable);
+        std::vector<RetiredPtr> ready(record.retired.begin(), end);
+        record.retired.erase(record.retired.begin(), end);
+        g.registry.takeOrphans(ready, freeable);
+        freeRetired(ready);
+    }
+
+    friend class EpochGuard;
+
+    static void pin()
+    {
+        ThreadRecord& record = local();
+        if (record.depth++ == 0) {
+            record.epoch.store(global().epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // the announcement must be visible before any pointer of the container is read
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void unpin()
+    {
+        ThreadRecord& record = local();
+        if (--record.depth == 0)
+            record.epoch.store(not_pinned, std::memory_order_release);
+    }
+
+public:
+    // Free ptr with deleter once no pinned thread can see it anymore. ptr must already be unreachable for new readers
+    static void retire(void* ptr, void (*deleter)(void*))
+    {
+        ThreadRecord& record = local();
+        record.retired.push_back({ptr, deleter, global().epoch.load(std::memory_order_seq_cst)});
+        if (record.retired.size() % collect_every == 0)
+            collect(record);
+    }
+
+    template <typename T>
+    static void retire(T* ptr)
+    {
+        retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // Free what can be freed right now. From a quiescent thread (no guard held) a few rounds free everything
+    static void flush()
+    {
+        for (int round = 0; round < 3; round++)
+            collect(local());
+    }
+
+    // Retired by this thread and not freed yet
+    static std::size_t pending() {
+        return local().retired.size();
+    }
+
+    static uint64_t epoch() {
+        return global().epoch.load(std::memory_order_relaxed);
+    }
+
+    // Threads registered right now
+    static std::size_t activeThreads() {
+        return global().registry.activeThreads();
+    }
+};
+
+// Pins the calling thread for its lifetime. Pointers read from a lock-free container are only valid while it lives
+class EpochGuard {
+public:
+    EpochGuard() { EpochReclaimer::pin(); }
+    ~EpochGuard() { EpochReclaimer::unpin(); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif // EPOCH_RECLAMATION_H
@@ -0,0 +1,181 @@
+#ifndef HAZARD_POINTERS_H
+#define HAZARD_POINTERS_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "thread_registry.h"
+
+/*
+Hazard pointers (Michael 2004)
+    - Before dereferencing a node a thread publishes its address in one of its hazard slots, then checks
+      the node is still reachable (re-reads the source pointer). If it is, nobody can free it until the slot is cleared:
+      a retired node is only freed after a scan of every thread's slots does not find it.
+    - Per pointer cost: a store with a full fence (the slot must be visible before the re-read), against EBR's one fence
+      per operation. In exchange a thread stuck in the middle of an operation only pins the <= slots_per_thread nodes it
+      points at, while under EBR it would stop all reclamation. Memory held back is bounded.
+    - Retired nodes are scanned in bulk: once a thread has retired
+      max(64, 2 * all hazard slots) of them, one scan frees at least half on average, so the scan is amortized O(1).
+    - Typical use, a node read from an atomic<Node*>:
+          HazardPointer hp;
+          Node* node = hp.protect(head);   // safe to dereference until hp is reset or destroyed
+    - Threads register on first use and unregister on exit (thread_registry.h).
+*/
+class HazardPointers {
+public:
+    static constexpr unsigned slots_per_thread = 4;
+
+private:
+    struct alignas(64) ThreadRecord {
+        std::atomic<void*> hazards[slots_per_thread] = {};
+        std::atomic<bool> inUse{true};
+        ThreadRecord* next = nullptr;
+        unsigned usedSlots = 0;            // bitmask of slots held by a HazardPointer, owner thread only
+        std::vector<RetiredPtr> retired;   // owner thread only, tag unused
+    };
+
+    static ThreadRegistry<ThreadRecord>& registry()
+    {
+        // leaked on purpose, see epoch_reclamation.h
+        static ThreadRegistry<ThreadRecord>* instance = new ThreadRegistry<ThreadRecord>();
+        return *instance;
+    }
+
+    static void releaseRecord(ThreadRecord* record)
+    {
+        scan(*record);
+        registry().addOrphans(record->retired);
+        for (auto& hazard : record->hazards)
+            hazard.store(nullptr, std::memory_order_release);
+        record->usedSlots = 0;
+        registry().release(record);
+    }
+
+    struct ThreadHandle {
+        ThreadRecord* record = registry().acquire();
+        ~ThreadHandle() { releaseRecord(record); }
+    };
+
+    static ThreadRecord& local()
+    {
+        static thread_local ThreadHandle handle;
+        return *handle.record;
+    }
+
+    static std::size_t scanThreshold() {
+        return std::max<std::size_t>(64, 2 * slots_per_thread * registry().recordCount());
+    }
+
+    // Free every retired node no hazard slot points at
+    static void scan(ThreadRecord& record)
+    {
+        // the retiring CAS happened before this but may be acq_rel only (the queues' head CAS): the fence orders it
+        // before the slot loads, so either protect() sees the node unlinked or this scan sees its slot
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<void*> hazards;
+        registry().forEach([&](ThreadRecord& other) {
+            for (auto& hazard : other.hazards)
+                if (void* ptr = hazard.load(std::memory_order_seq_cst))
+                    hazards.push_back(ptr);
+        });
+        std::sort(hazards.begin(), hazards.end());
+        auto freeable = [&](const RetiredPtr& entry) { return !std::binary_search(hazards.begin(), hazards.end(), entry.ptr); };
+
+        auto split = std::stable_partition(record.retired.begin(), record.retired.end(), [&](const RetiredPtr& entry) { return !freeable(entry); });
+        std::vector<RetiredPtr> ready(split, record.retired.end());
+        record.retired.erase(split, record.retired.end());
+        registry().takeOrphans(ready, freeable);
+        freeRetired(ready);
+    }
+
+    friend class HazardPointer;
+
+public:
+    static void retire(void* ptr, void (*deleter)(void*))
+    {
+        ThreadRecord& record = local();
+        record.retired.push_back({ptr, deleter, 0});
+        if (record.retired.size() >= scanThreshold())
+            scan(record);
+    }
+
+    template <typename T>
+    static void retire(T* ptr)
+    {
+        retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // Free what no thread points at right now
+    static void flush() {
+        scan(local());
+    }
+
+    // Retired by this thread and not freed yet
+    static std::size_t pending() {
+        return local().retired.size();
+    }
+
+    // Threads registered right now
+    static std::size_t activeThreads() {
+        return registry().activeThreads();
+    }
+};
+
+// One hazard slot of the calling thread, held for the lifetime of the object. At most slots_per_thread at once per thread
+class HazardPointer {
+private:
+    std::atomic<void*>* slot;
+    unsigned index;
+
+public:
+    HazardPointer()
+    {
+        HazardPointers::ThreadRecord& record = HazardPointers::local();
+        assert(record.usedSlots != (1u << HazardPointers::slots_per_thread) - 1 && "more HazardPointers alive on this thread than slots_per_thread");
+        index = 0;
+        while (record.usedSlots & (1u << index))
+            index++;
+        record.usedSlots |= 1u << index;
+        slot = &record.hazards[index];
+    }
+
+    ~HazardPointer()
+    {
+        slot->store(nullptr, std::memory_order_release);
+        HazardPointers::local().usedSlots &= ~(1u << index);
+    }
+
+    HazardPointer(const HazardPointer&) = delete;
+    HazardPointer& operator=(const HazardPointer&) = delete;
+
+    // Read src and protect what it points at. The returned node stays valid until reset()/another protect()/destruction
+    template <typename T>
+    T* protect(const std::atomic<T*>& src)
+    {
+        T* ptr = src.load(std::memory_order_relaxed);
+        while (true) {
+            // seq_cst store and load: the slot has to be visible to scanners before src is read again.
+            // An acquire load could be satisfied before the store is visible (store->load reordering)
+            slot->store(ptr, std::memory_order_seq_cst);
+            T* again = src.load(std::memory_order_seq_cst);
+            if (again == ptr)
+                return ptr;
+            ptr = again;
+        }
+    }
+
+    // Protect a pointer obtained some other way. Only safe if the caller re-validates it is still reachable afterwards
+    template <typename T>
+    void set(T* ptr) {
+        slot->store(ptr, std::memory_order_seq_cst);
+    }
+
+    void reset() {
+        slot->store(nullptr, std::memory_order_release);
+    }
+};
+
+#endif // HAZARD_POINTERS_H
@@ -0,0 +1,230 @@
+/* What safe memory reclamation costs per operation
+    - primitives, one thread: entering/leaving an EpochGuard, HazardPointer::protect, and retire() including
+      the amortized scan/collect that eventually frees the node
+    - mpmcQueueUnbounded push/pop with EpochPolicy, HazardPolicy, and NoReclaim (nodes only freed after the run,
+      the queue algorithm alone), next to a std::queue behind a mutex. Every thread pushes and pops in turns,
+      so the queue stays short and every pop retires a node. The reclamation cost is the gap to NoReclaim
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include "epoch_reclamation.h"
+#include "hazard_pointers.h"
+#include "reclamation_policy.h"
+#include "../simple_mpmc_queue/mpmc_queue_unbounded.h"
+
+static volatile uint64_t sink = 0;
+
+template <typename Func>
+double timeNsPerOp(size_t ops, Func&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed_ns / ops;
+}
+
+void report(const std::string& label, double ns_per_op)
+{
+    std::cout << std::left << std::setw(56) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(7) << ns_per_op << " ns/op" << std::endl;
+}
+
+// Baseline policy: retired nodes are kept until the benchmark is over and then freed in one go.
+// Not safe for real use (memory grows forever), it only shows the queue without any reclamation work
+struct NoReclaim {
+    static constexpr unsigned slots = 2;
+
+    struct Guard {
+        template <typename T>
+        T* protect(unsigned, const std::atomic<T*>& src) {
+            return src.load(std::memory_order_acquire);
+        }
+    };
+
+    static std::mutex& mtx()
+    {
+        static std::mutex instance;
+        return instance;
+    }
+
+    static std::vector<RetiredPtr>& all()
+    {
+        static std::vector<RetiredPtr> instance;
+        return instance;
+    }
+
+    struct ThreadList {
+        std::vector<RetiredPtr> retired;
+        ~ThreadList()
+        {
+            std::lock_guard<std::mutex> lock(mtx());
+            all().insert(all().end(), retired.begin(), retired.end());
+        }
+    };
+
+    static void retire(void* ptr, void (*deleter)(void*))
+    {
+        static thread_local ThreadList list;
+        list.retired.push_back({ptr, deleter, 0});
+    }
+
+    // only once every thread that used the queue has exited
+    static void flush()
+    {
+        std::lock_guard<std::mutex> lock(mtx());
+        freeRetired(all());
+        all().clear();
+    }
+};
+
+template <typename T>
+class LockedQueue {
+private:
+    std::queue<T> queue;
+    std::mutex mtx;
+
+public:
+    void push(const T& item) {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push(item);
+    }
+
+    bool try_pop(T& out) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue.empty())
+            return false;
+        out = queue.front();
+        queue.pop();
+        return true;
+    }
+};
+
+struct Node {
+    uint64_t payload[2];
+};
+
+void benchPrimitives()
+{
+    size_t ops = 10000000;
+    report("EpochGuard enter + exit", timeNsPerOp(ops, [&]() {
+        for (size_t i = 0; i < ops; i++) {
+            EpochGuard guard;
+        }
+    }));
+
+    std::atomic<Node*> source{new Node()};
+    report("HazardPointer::protect (slot already held)", timeNsPerOp(ops, [&]() {
+        HazardPointer hp;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < ops; i++)
+            sum += reinterpret_cast<uintptr_t>(hp.protect(source));
+        sink = sum;
+    }));
+    report("HazardPointer acquire slot + protect + release", timeNsPerOp(ops, [&]() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            HazardPointer hp;
+            sum += reinterpret_cast<uintptr_t>(hp.protect(source));
+        }
+        sink = sum;
+    }));
+    delete source.load();
+
+    auto deleter = [](void* ptr) { delete static_cast<Node*>(ptr); };
+    size_t nodes = 2000000;
+    // new + retire + (eventually) delete, minus new + delete right away
+    double plain = timeNsPerOp(nodes, [&]() {
+        for (size_t i = 0; i < nodes; i++) {
+            Node* node = new Node();
+            sink = reinterpret_cast<uintptr_t>(node);   // otherwise the compiler drops the new/delete pair
+            deleter(node);
+        }
+    });
+    report("new + delete", plain);
+    report("new + EpochReclaimer::retire (amortized collect)", timeNsPerOp(nodes, [&]() {
+        for (size_t i = 0; i < nodes; i++) {
+            EpochGuard guard;
+            EpochReclaimer::retire(new Node(), deleter);
+        }
+        EpochReclaimer::flush();
+    }));
+    report("new + HazardPointers::retire (amortized scan)", timeNsPerOp(nodes, [&]() {
+        for (size_t i = 0; i < nodes; i++)
+            HazardPointers::retire(new Node(), deleter);
+        HazardPointers::flush();
+    }));
+}
+
+// one op = one push or one pop
+template <typename Queue>
+double runQueue(size_t num_threads, size_t pairs_per_thread)
+{
+    Queue queue;
+    std::vector<std::thread> threads;
+    return timeNsPerOp(2 * pairs_per_thread * num_threads, [&]() {
+        for (size_t t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t]() {
+                uint64_t sum = 0;
+                uint64_t value;
+                for (size_t i = 0; i < pairs_per_thread; i++) {
+                    queue.push(t * pairs_per_thread + i);
+                    // another thread may have taken ours, there is always something unless all are empty at once
+                    while (!queue.try_pop(value))
+                        std::this_thread::yield();
+                    sum += value;
+                }
+                sink = sum;
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    });
+}
+
+// best of a few runs, the first one pays for page faults and cold caches (NoReclaim more than the others, it never reuses a node)
+template <typename Queue, typename AfterRun>
+double bestOf(size_t num_threads, size_t pairs, AfterRun&& afterRun)
+{
+    double best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        best = std::min(best, runQueue<Queue>(num_threads, pairs));
+        afterRun();
+    }
+    return best;
+}
+
+void benchQueues()
+{
+    size_t total_pairs = 2000000;
+    auto nothing = []() {};
+    for (size_t num_threads : {size_t(1), size_t(2), size_t(4), size_t(8)}) {
+        size_t pairs = total_pairs / num_threads;
+        std::string threads = ", " + std::to_string(num_threads) + " thread" + (num_threads > 1 ? "s" : "");
+        double none = bestOf<mpmcQueueUnbounded<uint64_t, NoReclaim>>(num_threads, pairs, []() { NoReclaim::flush(); });
+        double epoch = bestOf<mpmcQueueUnbounded<uint64_t, EpochPolicy>>(num_threads, pairs, nothing);
+        double hazard = bestOf<mpmcQueueUnbounded<uint64_t, HazardPolicy>>(num_threads, pairs, nothing);
+        double locked = bestOf<LockedQueue<uint64_t>>(num_threads, pairs, nothing);
+        report("mpmcQueueUnbounded NoReclaim" + threads, none);
+        report("mpmcQueueUnbounded EpochPolicy" + threads, epoch);
+        report("mpmcQueueUnbounded HazardPolicy" + threads, hazard);
+        report("std::queue + mutex" + threads, locked);
+        std::cout << std::left << std::setw(56) << "    reclamation cost: EBR / hazard pointers" << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(7) << epoch - none << " / " << hazard - none << " ns/op" << std::endl;
+    }
+}
+
+int main()
+{
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    benchPrimitives();
+    benchQueues();
+    return 0;
+}
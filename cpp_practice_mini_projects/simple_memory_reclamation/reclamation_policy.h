@@ -0,0 +1,61 @@
+#ifndef RECLAMATION_POLICY_H
+#define RECLAMATION_POLICY_H
+
+#include <atomic>
+#include "epoch_reclamation.h"
+#include "hazard_pointers.h"
+
+/*
+Lets a lock-free container be written once and run on either reclamation scheme
+    - Policy::Guard lives for one operation. guard.protect(i, src) reads a node pointer out of src and keeps the node
+      alive while the guard lives (or until slot i is protected again). i < Policy::slots.
+    - Policy::retire(ptr, deleter) frees the node once no guard can reach it.
+    - With EBR protect() is a plain load and the guard pins the thread, with hazard pointers the guard holds the slots.
+*/
+struct EpochPolicy {
+    static constexpr unsigned slots = HazardPointers::slots_per_thread;
+
+    class Guard {
+    private:
+        EpochGuard pin;
+
+    public:
+        template <typename T>
+        T* protect(unsigned, const std::atomic<T*>& src) {
+            return src.load(std::memory_order_acquire);
+        }
+    };
+
+    static void retire(void* ptr, void (*deleter)(void*)) {
+        EpochReclaimer::retire(ptr, deleter);
+    }
+
+    static void flush() {
+        EpochReclaimer::flush();
+    }
+};
+
+struct HazardPolicy {
+    static constexpr unsigned slots = 2;   // all a queue or list operation needs (node and its successor)
+
+    class Guard {
+    private:
+        HazardPointer hazards[slots];
+
+    public:
+        template <typename T>
+        T* protect(unsigned slot, const std::atomic<T*>& src) {
+            return hazards[slot].protect(src);
+        }
+    };
+
+    static void retire(void* ptr, void (*deleter)(void*)) {
+        HazardPointers::retire(ptr, deleter);
+    }
+
+    static void flush() {
+        HazardPointers::flush();
+    }
+};
+
+#endif // RECLAMATION_POLICY_H
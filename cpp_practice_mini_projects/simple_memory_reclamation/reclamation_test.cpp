@@ -0,0 +1,187 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include "epoch_reclamation.h"
+#include "hazard_pointers.h"
+#include "../simple_mpmc_queue/mpmc_queue_unbounded.h"
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cout << "FAILED: " << #cond << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; \
+            failures++; \
+        } \
+    } while (0)
+
+static int failures = 0;
+
+// Counts live instances, so a test can tell whether retire() really freed something (and only once, ASan catches the rest)
+struct Tracked {
+    static std::atomic<int> alive;
+    int value;
+    explicit Tracked(int v) : value(v) { alive++; }
+    Tracked(const Tracked& other) : value(other.value) { alive++; }
+    ~Tracked() { alive--; }
+};
+std::atomic<int> Tracked::alive{0};
+
+void testHazardPointers()
+{
+    std::atomic<Tracked*> shared{new Tracked(1)};
+    {
+        HazardPointer hp;
+        Tracked* node = hp.protect(shared);
+        CHECK(node->value == 1);
+        // unlink and retire while hp still points at it
+        shared.store(nullptr);
+        HazardPointers::retire(node);
+        HazardPointers::flush();
+        CHECK(Tracked::alive == 1);
+        CHECK(node->value == 1);
+
+        hp.reset();
+        HazardPointers::flush();
+        CHECK(Tracked::alive == 0);
+    }
+
+    // slots are handed back when a HazardPointer dies, so this can go on forever with 4 slots per thread
+    std::atomic<Tracked*> other{new Tracked(2)};
+    for (int i = 0; i < 100; i++) {
+        HazardPointer a, b, c, d;
+        CHECK(a.protect(other)->value == 2);
+        d.protect(other);
+    }
+    delete other.load();
+
+    // a thread exits with nodes protected by someone else: they stay around as orphans until that hazard is gone
+    std::atomic<Tracked*> victim{new Tracked(3)};
+    HazardPointer keep;
+    Tracked* kept = keep.protect(victim);
+    std::thread([&]() {
+        Tracked* node = victim.exchange(nullptr);
+        HazardPointers::retire(node);
+        HazardPointers::flush();
+    }).join();
+    CHECK(Tracked::alive == 1 && kept->value == 3);
+    keep.reset();
+    HazardPointers::flush();
+    CHECK(Tracked::alive == 0);
+    CHECK(HazardPointers::pending() == 0);
+    std::cout << "HazardPointers: done" << std::endl;
+}
+
+void testEpochReclaimer()
+{
+    {
+        EpochGuard guard;
+        EpochReclaimer::retire(new Tracked(1));
+        // this thread is pinned, the epoch can't get two steps ahead of it
+        EpochReclaimer::flush();
+        CHECK(Tracked::alive == 1);
+    }
+    EpochReclaimer::flush();
+    CHECK(Tracked::alive == 0);
+
+    // nested guards: only the outermost one unpins
+    {
+        EpochGuard outer;
+        {
+            EpochGuard inner;
+        }
+        EpochReclaimer::retire(new Tracked(2));
+        EpochReclaimer::flush();
+        CHECK(Tracked::alive == 1);
+    }
+    EpochReclaimer::flush();
+    CHECK(Tracked::alive == 0);
+
+    // nodes retired by a thread that exits while another thread is pinned end up as orphans, freed by whoever collects next
+    {
+        EpochGuard guard;
+        std::thread([]() {
+            for (int i = 0; i < 10; i++)
+                EpochReclaimer::retire(new Tracked(i));
+        }).join();
+        CHECK(Tracked::alive == 10);
+    }
+    EpochReclaimer::flush();
+    CHECK(Tracked::alive == 0);
+    std::cout << "EpochReclaimer: done" << std::endl;
+}
+
+// producers push (producer, seq) pairs, consumers pop. Every item must come out exactly once,
+// and the items of one producer in the order it pushed them (per consumer)
+template <typename Reclamation>
+void testQueue(const std::string& name)
+{
+    {
+        using Item = std::unique_ptr<Tracked>;   // move only, catches a copy in the queue
+        mpmcQueueUnbounded<Item, Reclamation> queue;
+        int num_producers = 4;
+        int num_consumers = 4;
+        int per_producer = 50000;
+        std::atomic<int> popped{0};
+        std::vector<std::vector<int>> received(num_consumers);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < num_producers; p++) {
+            threads.emplace_back([&, p]() {
+                for (int i = 0; i < per_producer; i++)
+                    queue.push(std::make_unique<Tracked>(p * per_producer + i));
+            });
+        }
+        for (int c = 0; c < num_consumers; c++) {
+            threads.emplace_back([&, c]() {
+                Item item;
+                while (popped.load() < num_producers * per_producer) {
+                    if (queue.try_pop(item)) {
+                        received[c].push_back(item->value);
+                        popped++;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        CHECK(queue.empty());
+
+        bool ordered = true;
+        std::vector<int> all;
+        for (auto& values : received) {
+            std::vector<int> last(num_producers, -1);
+            for (int value : values) {
+                ordered = ordered && value > last[value / per_producer];
+                last[value / per_producer] = value;
+            }
+            all.insert(all.end(), values.begin(), values.end());
+        }
+        CHECK(ordered);
+        std::sort(all.begin(), all.end());
+        std::vector<int> expected(num_producers * per_producer);
+        std::iota(expected.begin(), expected.end(), 0);
+        CHECK(all == expected);
+
+        // items left in the queue are destroyed with it
+        for (int i = 0; i < 10; i++)
+            queue.emplace(std::make_unique<Tracked>(i));
+    }
+    Reclamation::flush();
+    CHECK(Tracked::alive == 0);
+    std::cout << name << ": done" << std::endl;
+}
+
+int main()
+{
+    testHazardPointers();
+    testEpochReclaimer();
+    testQueue<EpochPolicy>("mpmcQueueUnbounded<EpochPolicy>");
+    testQueue<HazardPolicy>("mpmcQueueUnbounded<HazardPolicy>");
+    std::cout << (failures ? "Some checks FAILED" : "All checks passed") << std::endl;
+    return failures ? 1 : 0;
+}
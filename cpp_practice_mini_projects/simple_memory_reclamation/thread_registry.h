@@ -0,0 +1,106 @@
+#ifndef THREAD_REGISTRY_H
+#define THREAD_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+/*
+Bookkeeping shared by the reclamation schemes (epoch_reclamation.h, hazard_pointers.h)
+    - Every thread that touches a lock-free container gets a record the other threads can scan
+      (its epoch, its hazard pointers). Records live on a push only list and are never freed, an exiting thread
+      marks its record free and the next new thread takes it over. So a scan costs O(max live threads),
+      not O(threads ever created), and a scanning thread never reads freed memory.
+    - Nodes an exiting thread retired but could not free yet become orphans, the remaining threads free them later.
+Record must have: std::atomic<bool> inUse, Record* next, and be default constructible with inUse = true
+*/
+
+// A node waiting to be freed. tag is scheme specific (the epoch it was retired in for EBR)
+struct RetiredPtr {
+    void* ptr;
+    void (*deleter)(void*);
+    uint64_t tag;
+};
+
+template <typename Record>
+class ThreadRegistry {
+private:
+    alignas(64) std::atomic<Record*> head{nullptr};
+    std::atomic<std::size_t> numRecords{0};
+    std::mutex orphanMtx;
+    std::vector<RetiredPtr> orphans;
+
+public:
+    Record* acquire()
+    {
+        for (Record* record = head.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+            if (!record->inUse.load(std::memory_order_relaxed) &&
+                record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return record;
+        }
+        Record* record = new Record();
+        record->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        numRecords.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    // The caller resets whatever else of the record other threads look at before this
+    void release(Record* record) {
+        record->inUse.store(false, std::memory_order_release);
+    }
+
+    // Every record ever created, in use or not. func(Record&)
+    template <typename Func>
+    void forEach(Func&& func)
+    {
+        for (Record* record = head.load(std::memory_order_acquire); record; record = record->next)
+            func(*record);
+    }
+
+    std::size_t recordCount() const {
+        return numRecords.load(std::memory_order_relaxed);
+    }
+
+    std::size_t activeThreads()
+    {
+        std::size_t active = 0;
+        forEach([&](Record& record) { active += record.inUse.load(std::memory_order_relaxed); });
+        return active;
+    }
+
+    void addOrphans(std::vector<RetiredPtr>& retired)
+    {
+        if (retired.empty())
+            return;
+        std::lock_guard<std::mutex> lock(orphanMtx);
+        orphans.insert(orphans.end(), retired.begin(), retired.end());
+        retired.clear();
+    }
+
+    // Move the orphans that freeable(entry) allows into out. Skipped if another thread is at it, nobody waits on this lock
+    template <typename Pred>
+    void takeOrphans(std::vector<RetiredPtr>& out, Pred&& freeable)
+    {
+        std::unique_lock<std::mutex> lock(orphanMtx, std::try_to_lock);
+        if (!lock.owns_lock() || orphans.empty())
+            return;
+        auto split = std::stable_partition(orphans.begin(), orphans.end(), [&](const RetiredPtr& entry) { return !freeable(entry); });
+        out.insert(out.end(), split, orphans.end());
+        orphans.erase(split, orphans.end());
+    }
+};
+
+// Run the deleters outside of the vectors they came from, a deleter is allowed to retire() again
+inline void freeRetired(const std::vector<RetiredPtr>& ready)
+{
+    for (const RetiredPtr& entry : ready)
+        entry.deleter(entry.ptr);
+}
+
+#endif // THREAD_REGISTRY_H
@@ -240,6 +240,19 @@ public:
             }   
         }
     }
+    // true if try_pop() would find nothing right now. Only a snapshot while producers/consumers are active
+    bool empty() const
+    {
+        size_t head = deq_head.load(std::memory_order_acquire);
+        return buffer_[head & mask_].seq.load(std::memory_order_acquire) != (head+1);
+    }
+
+    // Actual capacity, rounded up to power of 2 from the requested one
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
     //destructor
     ~mpmcQueueBounded()
     {
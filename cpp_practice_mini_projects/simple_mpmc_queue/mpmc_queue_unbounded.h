@@ -0,0 +1,155 @@
+#ifndef MPMC_QUEUE_UNBOUNDED_H
+#define MPMC_QUEUE_UNBOUNDED_H
+
+/***
+ *  Unbounded lock-free mpmc queue, the Michael-Scott queue (1996)
+ *      - a singly linked list with a dummy node in front: head_ points at the dummy, the first item is in head_->next.
+ *        Popping moves head_ forward by one, the node holding the popped item becomes the new dummy
+ *        and the old dummy is retired.
+ *      - push links the new node after the last one with a CAS on last->next (null -> node), then swings tail_.
+ *        tail_ can lag one node behind, every thread that sees that helps move it forward before doing its own work,
+ *        so a producer stalled between the two CASes never blocks the others.
+ *      - mpmcQueueBounded never frees anything (fixed ring). Here popped nodes have to be freed while other threads
+ *        may still be reading them, that is what the Reclamation policy is for: EpochPolicy or HazardPolicy
+ *        (../simple_memory_reclamation/reclamation_policy.h)
+ *      - never full, push always succeeds, costs one allocation per item
+ */
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "../simple_memory_reclamation/reclamation_policy.h"
+
+template <typename T, typename Reclamation = EpochPolicy>
+class mpmcQueueUnbounded
+{
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        // constructed by push, moved out and destroyed by the pop that takes it. The dummy node holds no value
+        alignas(alignof(T)) unsigned char mem[sizeof(T)];
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(&mem));
+        }
+    };
+
+    static_assert(Reclamation::slots >= 2, "a pop protects the head node and its successor");
+
+    // avoiding false sharing between producers (tail) and consumers (head)
+    alignas(64) std::atomic<Node*> head_;
+    alignas(64) std::atomic<Node*> tail_;
+
+    static void deleteNode(void* ptr) {
+        delete static_cast<Node*>(ptr);
+    }
+
+    void link(Node* node)
+    {
+        typename Reclamation::Guard guard;
+        while (true) {
+            Node* tail = guard.protect(0, tail_);
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (tail != tail_.load(std::memory_order_acquire))
+                continue;
+            if (next) {
+                // tail_ is lagging, help the producer that linked next
+                tail_.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            Node* expected = nullptr;
+            // release: a consumer that reaches node sees the item constructed in it
+            if (tail->next.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed)) {
+                // may fail if someone helped already, fine either way
+                tail_.compare_exchange_strong(tail, node, std::memory_order_release, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+public:
+    mpmcQueueUnbounded()
+    {
+        Node* dummy = new Node();
+        head_.store(dummy, std::memory_order_relaxed);
+        tail_.store(dummy, std::memory_order_relaxed);
+    }
+
+    mpmcQueueUnbounded(const mpmcQueueUnbounded&) = delete;
+    mpmcQueueUnbounded& operator=(const mpmcQueueUnbounded&) = delete;
+
+    // No other thread may use the queue anymore. Items still queued are destroyed
+    ~mpmcQueueUnbounded()
+    {
+        Node* node = head_.load(std::memory_order_relaxed);
+        Node* next = node->next.load(std::memory_order_relaxed);
+        delete node;   // the dummy, no value
+        while (next) {
+            node = next;
+            next = node->next.load(std::memory_order_relaxed);
+            node->value()->~T();
+            delete node;
+        }
+    }
+
+    void push(const T& item) {
+        emplace(item);
+    }
+
+    void push(T&& item) {
+        emplace(std::move(item));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        Node* node = new Node();
+        try {
+            new (&node->mem) T(std::forward<Args>(args)...);
+        } catch (...) {
+            delete node;
+            throw;
+        }
+        link(node);
+    }
+
+    // false if the queue was empty
+    bool try_pop(T& out)
+    {
+        typename Reclamation::Guard guard;
+        while (true) {
+            Node* head = guard.protect(0, head_);
+            Node* tail = tail_.load(std::memory_order_acquire);
+            Node* next = guard.protect(1, head->next);
+            // head still the head: next was read from a live node, so it is protected for real
+            if (head != head_.load(std::memory_order_acquire))
+                continue;
+            if (!next)
+                return false;
+            if (head == tail) {
+                // an item is linked but tail_ was not moved yet, help before taking it
+                tail_.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                // only the winner touches next's item. next is the new dummy now,
+                // still protected by the guard even if another pop retires it meanwhile
+                T* value = next->value();
+                out = std::move(*value);
+                value->~T();
+                Reclamation::retire(head, &deleteNode);
+                return true;
+            }
+        }
+    }
+
+    // A snapshot, may be stale by the time the caller looks at it
+    bool empty()
+    {
+        typename Reclamation::Guard guard;
+        Node* head = guard.protect(0, head_);
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+#endif // MPMC_QUEUE_UNBOUNDED_H